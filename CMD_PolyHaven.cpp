@@ -4,18 +4,67 @@
 #include <CMD/CMD_Args.h>
 #include <iostream>
 #include "startwindow.h"
+#include "headless_pull.h"
 
 
 
+// 子命令用法
+static const char* CMD_POLYHAVEN_USAGE =
+    "Usage: cmd_polyhaven [-r] [-q] [-v] [-j jobs] [-l library] [-t trace.json] [-m metrics.json] [subcommand [args]]\n"
+    "  (no subcommand)     open the asset browser\n"
+    "  sync [type]         download missing assets (type: all, hdris, textures, models)\n"
+    "  plan [type]         report what sync would transfer, without downloading\n"
+    "  verify [type]       check local files against the manifest md5\n"
+    "  search <words...>   list matching assets, most downloaded first\n"
+    "  fetch <slug...>     download the given assets\n"
+    "  trace start|stop    record trace spans in this process\n"
+    "  trace save <file>   write the recorded spans as Chrome trace JSON\n"
+    "  metrics [file]      dump this session's metrics as JSON (default: stdout)\n"
+    "  -r  re-fetch file manifests of assets that are already present\n"
+    "  -q  no progress output\n"
+    "  -v  also print INFO log lines\n"
+    "  -j  maximum concurrent downloads\n"
+    "  -l  asset library root (default: the path last chosen in the browser)\n"
+    "  -t  record this run and write a Chrome trace JSON (chrome://tracing, ui.perfetto.dev)\n"
+    "  -m  write a metrics snapshot as JSON when the run ends (- for stdout)\n";
+
 /// cmd_polyhaven()
 ///
 /// Callback function for the new 'cmd_polyhaven' command
+/// 不带子命令时打开浏览器；带子命令时无界面运行（渲染节点 / 夜间任务预热资产库），
+/// 退出码见 HeadlessExitCode，写入 hscript 的命令状态
 static void
 cmd_polyhaven(CMD_Args& args)
 {
-    StartWindow* ins = StartWindow::getInstance();
-    ins->show();
+    if (args.argc() < 2) {
+        StartWindow* ins = StartWindow::getInstance();
+        ins->show();
+        return;
+    }
+
+    const QString subcommand = QString::fromUtf8(args(1));
+    QStringList rest;
+    for (int i = 2; i < args.argc(); ++i)
+        rest.append(QString::fromUtf8(args(i)));
+
+    HeadlessOptions options;
+    options.revalidate = args.found('r');
+    options.quiet = args.found('q');
+    options.verbose = args.found('v');
+    if (args.found('j'))
+        options.jobs = QString::fromUtf8(args.argp('j')).toInt();
+
+    if (args.found('l'))
+        options.libraryPath = QString::fromUtf8(args.argp('l'));
+    if (args.found('t'))
+        options.traceFile = QString::fromUtf8(args.argp('t'));
+    if (args.found('m'))
+        options.metricsFile = QString::fromUtf8(args.argp('m'));
 
+    const int status = headless_run(subcommand, rest, options);
+    if (status == PH_EXIT_USAGE)
+        args.err() << CMD_POLYHAVEN_USAGE;
+    CMDgetManager()->setStatusCode(status);
 }
 
 /// This function gets called once during Houdini initialization to register
@@ -24,5 +73,6 @@ void
 CMDextendLibrary(CMD_Manager* cman)
 {
     // install the cmd_polyhaven command into the command manager
-    cman->installCommand("cmd_polyhaven", "", cmd_polyhaven);
+    // -r/-q/-v 为开关，-j/-l/-t/-m 带一个参数
+    cman->installCommand("cmd_polyhaven", "rqvj:l:t:m:", cmd_polyhaven);
 }
\ No newline at end of file
@@ -3,8 +3,6 @@
 #include <QtCore/QJsonParseError>
 #include <QtCore/qdebug.h>
 
-#include <UT/UT_String.h>
-
 
 // 日志宏（适配 Houdini 日志系统）
 #define LOG_DEBUG(msg) qDebug() << "[PolyHavenLink] DEBUG:" << msg
@@ -0,0 +1,231 @@
+﻿#include "asset_index.h"
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qendian.h>
+#include <algorithm>
+#include <cstring>
+
+// 检索串分隔符：保证搜索词不会跨越 name / tag 边界匹配
+static const QChar HAYSTACK_SEP(0x1f);
+
+void AssetIndex::build(const QMap<QString, QJsonObject>& assets)
+{
+    m_slugs.clear();
+    m_details.clear();
+    m_types.clear();
+    m_haystacks.clear();
+    m_categoryMasks.clear();
+    m_termCounts.clear();
+
+    m_slugs.reserve(assets.size());
+    m_details.reserve(assets.size());
+    m_types.reserve(assets.size());
+    m_haystacks.reserve(assets.size());
+    m_categoryMasks.reserve(assets.size());
+
+    for (auto it = assets.constBegin(); it != assets.constEnd(); ++it) {
+        const QJsonObject& asset = it.value();
+
+        // tags & categories 合并（与 filterAssets 原有语义一致）
+        QStringList tags;
+        for (const QJsonValue& v : asset.value("tags").toArray())
+            tags.append(v.toString().toLower());
+        for (const QJsonValue& v : asset.value("categories").toArray())
+            tags.append(v.toString().toLower());
+
+        QStringList distinct = tags;
+        distinct.removeDuplicates();
+        for (const QString& t : distinct)
+            ++m_termCounts[t];
+
+        QString haystack = asset.value("name").toString().toLower();
+        for (const QString& t : tags) {
+            haystack += HAYSTACK_SEP;
+            haystack += t;
+        }
+
+        int type = asset.value("type").toInt();
+        m_slugs.append(it.key());
+        m_details.append(asset);
+        m_types.append(type);
+        m_haystacks.append(haystack);
+        m_categoryMasks.append(categoryMask(tags, type));
+    }
+
+    // 掩码转置为每个节点的位图
+    m_nodeBits.fill(QBitArray(size(), false), CATEGORY_NODE_COUNT);
+    for (int row = 0; row < size(); ++row) {
+        quint64 mask = m_categoryMasks[row];
+        for (int node = 0; mask; ++node, mask >>= 1) {
+            if (mask & 1)
+                m_nodeBits[node].setBit(row);
+        }
+    }
+
+    buildSortPermutations();
+}
+
+void AssetIndex::buildSortPermutations()
+{
+    const int n = size();
+
+    // 排序键只在建索引时提取一次
+    QVector<QString> names(n);
+    QVector<qint64> downloads(n);
+    QVector<qint64> published(n);
+    for (int row = 0; row < n; ++row) {
+        const QJsonObject& asset = m_details[row];
+        names[row] = asset.value("name").toString().toLower();
+        downloads[row] = qint64(asset.value("download_count").toDouble());
+        published[row] = qint64(asset.value("date_published").toDouble());
+    }
+
+    for (int f = 0; f < SortFieldCount; ++f) {
+        QVector<int>& order = m_order[f];
+        order.resize(n);
+        for (int row = 0; row < n; ++row)
+            order[row] = row;
+
+        // 行号本身就是 slug 顺序，stable_sort 保证同值时按 slug 排
+        switch (f) {
+        case SortByName:
+            std::stable_sort(order.begin(), order.end(),
+                [&](int a, int b) { return names[a] < names[b]; });
+            break;
+        case SortByDownloads:
+            std::stable_sort(order.begin(), order.end(),
+                [&](int a, int b) { return downloads[a] < downloads[b]; });
+            break;
+        case SortByDatePublished:
+            std::stable_sort(order.begin(), order.end(),
+                [&](int a, int b) { return published[a] < published[b]; });
+            break;
+        default:
+            break;
+        }
+
+        QVector<int>& rank = m_rank[f];
+        rank.resize(n);
+        for (int i = 0; i < n; ++i)
+            rank[order[i]] = i;
+    }
+}
+
+quint64 AssetIndex::categoryMask(const QStringList& lowerTags, int type)
+{
+    quint64 mask = 0;
+    for (int node = 0; node < CATEGORY_NODE_COUNT; ++node) {
+        const CategoryNode& n = CATEGORY_NODES[node];
+        if (n.assetType >= 0 && n.assetType != type)
+            continue;
+
+        // 节点的全部匹配词都要被某个 tag 包含（与原 onCategoryClicked + filterAssets 语义一致）
+        bool allIn = true;
+        for (int t = 0; t < n.termCount && allIn; ++t) {
+            QLatin1String term(n.terms[t].data(), int(n.terms[t].size()));
+            allIn = std::any_of(lowerTags.constBegin(), lowerTags.constEnd(),
+                [&](const QString& tag) { return tag.contains(term, Qt::CaseInsensitive); });
+        }
+        if (allIn)
+            mask |= quint64(1) << node;
+    }
+    return mask;
+}
+
+QBitArray AssetIndex::nodeBits(int node) const
+{
+    if (node < 0 || node >= m_nodeBits.size())
+        return allBits();
+    return m_nodeBits[node];
+}
+
+QBitArray AssetIndex::matchText(const QString& text, const QBitArray& candidates) const
+{
+    if (text.isEmpty())
+        return allBits();
+
+    const bool refine = candidates.size() == size();
+    QBitArray bits(size(), false);
+    for (int row = 0; row < size(); ++row) {
+        if (refine && !candidates.testBit(row))
+            continue;
+        if (m_haystacks[row].contains(text))
+            bits.setBit(row);
+    }
+    return bits;
+}
+
+QVector<int> AssetIndex::facetCounts(const QBitArray& base) const
+{
+    QVector<int> counts(m_nodeBits.size(), 0);
+    for (int node = 0; node < m_nodeBits.size(); ++node)
+        counts[node] = countAnd(m_nodeBits[node], base);
+    return counts;
+}
+
+QVector<int> AssetIndex::sortedRows(const QBitArray& bits, SortField field, bool descending) const
+{
+    QVector<int> rows;
+    if (bits.size() != size() || field < 0 || field >= SortFieldCount)
+        return rows;
+
+    const int hits = bits.count(true);
+    rows.reserve(hits);
+
+    // 命中少时按 64 位字只取置位行（N/64 + k）再按 rank 排序，共 O(N/64 + k·log2(k))；
+    // k·log2(k) 不小于 N 时不如直接顺着置换数组挑出命中行
+    int logHits = 1;
+    while ((1 << logHits) < hits) ++logHits;
+    if (qint64(hits) * logHits < size()) {
+        // QBitArray 第 i 位在第 i/8 字节的第 i%8 位，按小端读成字后即第 i%64 位；末字节的填充位恒为 0
+        const char* data = bits.bits();
+        const qsizetype bytes = (size() + 7) / 8;
+        for (qsizetype i = 0; i < bytes; i += 8) {
+            quint64 word = 0;
+            if (i + 8 <= bytes) {
+                word = qFromLittleEndian<quint64>(data + i);
+            }
+            else {
+                for (qsizetype b = i; b < bytes; ++b)
+                    word |= quint64(quint8(data[b])) << ((b - i) * 8);
+            }
+            while (word) {
+                rows.append(int(i * 8 + qCountTrailingZeroBits(word)));
+                word &= word - 1;
+            }
+        }
+        const QVector<int>& rank = m_rank[field];
+        std::sort(rows.begin(), rows.end(),
+            [&](int a, int b) { return rank[a] < rank[b]; });
+    }
+    else {
+        for (int row : m_order[field])
+            if (bits.testBit(row)) rows.append(row);
+    }
+
+    if (descending)
+        std::reverse(rows.begin(), rows.end());
+    return rows;
+}
+
+int AssetIndex::countAnd(const QBitArray& a, const QBitArray& b)
+{
+    if (a.size() != b.size())
+        return 0;
+
+    // 按 64 位字做 AND + popcount，QBitArray 末字节的填充位恒为 0
+    const char* pa = a.bits();
+    const char* pb = b.bits();
+    const qsizetype bytes = (a.size() + 7) / 8;
+    int count = 0;
+    qsizetype i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        quint64 wa, wb;
+        std::memcpy(&wa, pa + i, 8);
+        std::memcpy(&wb, pb + i, 8);
+        count += qPopulationCount(wa & wb);
+    }
+    for (; i < bytes; ++i)
+        count += qPopulationCount(quint8(pa[i] & pb[i]));
+    return count;
+}
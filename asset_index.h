@@ -0,0 +1,106 @@
+﻿#ifndef ASSET_INDEX_H
+#define ASSET_INDEX_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qbitarray.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qmap.h>
+#include <QtCore/qhash.h>
+#include "category_taxonomy.h"
+
+/**
+ * 资产倒排索引（浏览器筛选 / 分类计数共用）
+ * 行号与 get_asset_lib() 返回的 QMap 迭代顺序一致；
+ * 每个资产预先算出分类掩码（第 n 位 = 命中 CATEGORY_NODES[n]），
+ * 每个分类节点再持有一个 QBitArray（第 i 位 = 第 i 个资产命中），
+ * 筛选和计数只需要按位与 + popcount，不再逐个解析 QJsonObject。
+ */
+class AssetIndex
+{
+public:
+    // 可选排序字段（/assets 返回的字段）；SortByKey 即 QMap 的 slug 顺序
+    enum SortField {
+        SortByKey = 0,
+        SortByName,
+        SortByDownloads,
+        SortByDatePublished,
+        SortFieldCount
+    };
+
+    AssetIndex() = default;
+
+    /**
+     * 从资产字典重建索引（小写 name/tags/categories 预先拼接成检索串，并计算分类掩码）
+     * @param assets get_asset_lib() 的结果
+     */
+    void build(const QMap<QString, QJsonObject>& assets);
+
+    /**
+     * 计算资产命中的分类节点掩码
+     * @param lowerTags 小写 tags + categories
+     * @param type 资产类型（0:HDRIs,1:Textures,2:Models）
+     * @return 第 n 位 = 命中 CATEGORY_NODES[n]
+     */
+    static quint64 categoryMask(const QStringList& lowerTags, int type);
+
+    int size() const { return m_slugs.size(); }
+    int nodeCount() const { return m_nodeBits.size(); }
+    const QString& slug(int row) const { return m_slugs[row]; }
+    const QJsonObject& details(int row) const { return m_details[row]; }
+    quint64 categoryMask(int row) const { return m_categoryMasks[row]; }
+
+    /** 每个 tag/category（小写）-> 含该词的资产数，供补全排序 */
+    const QHash<QString, int>& termCounts() const { return m_termCounts; }
+
+    /** 全部资产（全 1 位图） */
+    QBitArray allBits() const { return QBitArray(size(), true); }
+
+    /** 分类节点的命中位图（越界返回全 1） */
+    QBitArray nodeBits(int node) const;
+
+    /**
+     * 文本匹配：name 或任一 tag/category 包含 text
+     * @param text 已小写、去空白的搜索词（空串命中全部）
+     * @param candidates 可选的候选集；新搜索词包含旧搜索词时传入旧结果，只复查其中置位的行
+     */
+    QBitArray matchText(const QString& text, const QBitArray& candidates = QBitArray()) const;
+
+    /**
+     * 分类计数：每个节点 popcount(nodeBits & base)
+     * @param base 当前搜索结果
+     * @return 下标与节点 id 对应
+     */
+    QVector<int> facetCounts(const QBitArray& base) const;
+
+    /**
+     * 按预计算的排序置换输出命中的行
+     * 命中较少时按 rank 做整数排序，否则顺序扫描置换数组；两者都不再比较 QJsonObject
+     * @param bits 筛选结果位图
+     * @param field 排序字段
+     * @param descending 是否倒序
+     * @return 排好序的行号
+     */
+    QVector<int> sortedRows(const QBitArray& bits, SortField field, bool descending = false) const;
+
+    /** 两个位图按位与后的置位数（不分配临时 QBitArray） */
+    static int countAnd(const QBitArray& a, const QBitArray& b);
+
+private:
+    QVector<QString> m_slugs;
+    QVector<QJsonObject> m_details;
+    QVector<int> m_types;
+    QVector<QString> m_haystacks;   // "name\x1ftag1\x1ftag2..."（小写）
+    QVector<quint64> m_categoryMasks;
+    QHash<QString, int> m_termCounts;
+    QVector<QBitArray> m_nodeBits;  // 下标为分类节点 id
+
+    // 每个排序字段一份置换（m_order[f][i] = 第 i 名的行号）与其逆（m_rank[f][row] = 名次）
+    QVector<int> m_order[SortFieldCount];
+    QVector<int> m_rank[SortFieldCount];
+
+    void buildSortPermutations();
+};
+
+#endif // ASSET_INDEX_H
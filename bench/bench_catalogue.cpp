@@ -0,0 +1,478 @@
+﻿// 浏览路径基准：合成 Poly Haven 形态的资产列表（tag / 分类分布接近真实），测美术日常操作涉及的各段耗时
+//
+// 用法：bench_catalogue [--sizes 1000,10000,100000] [--repeat R] [--thumbnails K] [--hash-mb M]
+//                       [--dir D] [--seed S] [--json FILE]
+//   每个规模在 D（默认系统临时目录）下生成一个临时资产库：asset_list_cache.json + K 张缩略图，结束后删除
+//   测量：JSON 解析、parseAssetJson、get_asset_lib、索引构建、filterAssets（多种查询组合）、
+//         AssetModel 构建、缩略图解码缩放、filehash 吞吐
+//   表格写到 stdout；--json 另外输出机器可读结果（"-" 为 stdout），供 CI 对比回归
+
+#include "asset_index.h"
+#include "category_taxonomy.h"
+#include "filehash.h"
+#include "get_asset_lib.h"
+#include "get_asset_list.h"
+#include "AssetModel.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtGui/QImageReader>
+#include <QtGui/QImageWriter>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+// 防止被测调用的结果被优化掉
+static volatile qint64 g_sink = 0;
+// 表格输出；--json - 时 stdout 留给 JSON，表格改写到 stderr
+static FILE* g_table = stdout;
+
+// 缩略图卡片尺寸（与 AssetDelegate 一致：卡片宽 - 16 × 60）
+static const int THUMB_WIDTH = 184;
+static const int THUMB_HEIGHT = 60;
+
+/* ---------- 合成资产列表 ---------- */
+
+// 常见的 tag 词根：真实列表里少数词（wood、outdoor、rock……）出现在大量资产上，长尾词只出现几次
+static const char* TAG_WORDS[] = {
+    "wood", "rock", "outdoor", "nature", "ground", "stone", "floor", "wall", "brick", "metal",
+    "concrete", "plaster", "fabric", "leather", "sand", "snow", "grass", "moss", "bark", "tile",
+    "roof", "painted", "rusty", "dirty", "clean", "old", "worn", "cracked", "wet", "dry",
+    "sunny", "cloudy", "overcast", "sunset", "sunrise", "night", "urban", "street", "forest", "field",
+    "mountain", "beach", "river", "lake", "city", "building", "interior", "room", "studio", "window",
+    "furniture", "chair", "table", "lamp", "prop", "plant", "tree", "flower", "rocky", "gravel",
+    "asphalt", "pavement", "cobblestone", "planks", "marble", "granite", "clay", "mud", "soil", "leaves",
+};
+static const int TAG_WORD_COUNT = int(sizeof(TAG_WORDS) / sizeof(TAG_WORDS[0]));
+
+struct CatalogueGenerator {
+    std::mt19937_64 rng;
+    QStringList vocabulary;                       // 词根 + 长尾合成词
+    std::discrete_distribution<int> tagPick;      // Zipf 分布
+    QVector<int> nodesByType[3];                  // 每种类型的分类节点
+
+    explicit CatalogueGenerator(quint64 seed)
+        : rng(seed)
+    {
+        for (int i = 0; i < TAG_WORD_COUNT; ++i)
+            vocabulary.append(TAG_WORDS[i]);
+        for (int i = 0; i < 2000; ++i)
+            vocabulary.append(QString("%1%2").arg(TAG_WORDS[i % TAG_WORD_COUNT]).arg(i / TAG_WORD_COUNT));
+
+        std::vector<double> weights(vocabulary.size());
+        for (int i = 0; i < vocabulary.size(); ++i)
+            weights[i] = 1.0 / std::pow(double(i + 1), 1.1);
+        tagPick = std::discrete_distribution<int>(weights.begin(), weights.end());
+
+        for (int node = 0; node < CATEGORY_NODE_COUNT; ++node) {
+            const int type = CATEGORY_NODES[node].assetType;
+            if (type >= 0 && type < 3 && CATEGORY_NODES[node].termCount > 0)
+                nodesByType[type].append(node);
+        }
+    }
+
+    int uniform(int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); }
+
+    QJsonObject asset(int index)
+    {
+        // 类型比例接近真实列表：贴图最多，HDRI 次之，模型最少
+        const int roll = uniform(100);
+        const int type = roll < 35 ? 0 : (roll < 80 ? 1 : 2);
+
+        QJsonArray categories;
+        const QVector<int>& nodes = nodesByType[type];
+        if (!nodes.isEmpty()) {
+            const CategoryNode& node = CATEGORY_NODES[nodes[uniform(nodes.size())]];
+            for (int t = 0; t < node.termCount; ++t)
+                categories.append(QString::fromLatin1(node.terms[t].data(), int(node.terms[t].size())).toLower());
+        }
+
+        QJsonArray tags;
+        const int tagCount = 3 + uniform(8);
+        for (int t = 0; t < tagCount; ++t)
+            tags.append(vocabulary[tagPick(rng)]);
+
+        // 下载量长尾：少数资产下载量极高
+        const double downloads = std::exp(std::normal_distribution<double>(8.0, 1.5)(rng));
+
+        QJsonObject authors;
+        authors.insert(QString("Author %1").arg(uniform(60)), "All");
+
+        QJsonObject asset;
+        asset.insert("name", QString("%1 %2 %3").arg(vocabulary[tagPick(rng)], vocabulary[tagPick(rng)]).arg(index));
+        asset.insert("type", type);
+        asset.insert("date_published", 1500000000 + uniform(250000000));
+        asset.insert("download_count", qint64(downloads));
+        asset.insert("files_hash", QString::number(rng(), 16));
+        asset.insert("authors", authors);
+        asset.insert("categories", categories);
+        asset.insert("tags", tags);
+        asset.insert("max_resolution", QJsonArray{ 8192, type == 0 ? 4096 : 8192 });
+        asset.insert("thumbnail_url", QString("https://cdn.polyhaven.com/asset_img/thumbs/synthetic_%1.png").arg(index));
+        return asset;
+    }
+
+    QByteArray catalogue(int count)
+    {
+        QJsonObject root;
+        for (int i = 0; i < count; ++i)
+            root.insert(QString("synthetic_%1").arg(i, 6, 10, QChar('0')), asset(i));
+        return QJsonDocument(root).toJson(QJsonDocument::Compact);
+    }
+
+    QImage thumbnail()
+    {
+        // 渐变 + 噪声，编码后的体积接近真实缩略图
+        QImage image(256, 256, QImage::Format_RGB32);
+        const int r = uniform(256), g = uniform(256), b = uniform(256);
+        for (int y = 0; y < image.height(); ++y) {
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                const int n = uniform(48);
+                line[x] = qRgb((r + x + n) & 255, (g + y + n) & 255, (b + x + y) & 255);
+            }
+        }
+        return image;
+    }
+};
+
+/* ---------- 计时与结果 ---------- */
+
+struct BenchResult {
+    QString name;
+    int assets = 0;
+    int iterations = 0;
+    double minMs = 0.0;
+    double medianMs = 0.0;
+    double maxMs = 0.0;
+    double throughput = 0.0;      // 每秒处理的 unit 数（按中位数计算）
+    QString unit;
+};
+
+static QVector<BenchResult> g_results;
+
+/**
+ * 重复执行 body，记录最短 / 中位 / 最长耗时
+ * @param items 每次执行处理的数量（用于计算吞吐）
+ */
+static void measure(const QString& name, int assets, int repeat, double items, const QString& unit,
+    const std::function<void()>& body)
+{
+    QVector<double> samples;
+    samples.reserve(repeat);
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        samples.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult r;
+    r.name = name;
+    r.assets = assets;
+    r.iterations = repeat;
+    r.minMs = samples.first();
+    r.medianMs = samples[samples.size() / 2];
+    r.maxMs = samples.last();
+    r.throughput = r.medianMs > 0.0 ? items * 1000.0 / r.medianMs : 0.0;
+    r.unit = unit;
+    g_results.append(r);
+
+    std::fprintf(g_table, "%-40s %8d %10.3f %10.3f %10.3f %14.1f %s/s\n", qPrintable(name), assets,
+        r.minMs, r.medianMs, r.maxMs, r.throughput, qPrintable(unit));
+    std::fflush(g_table);
+}
+
+static QByteArray results_json(const QList<int>& sizes, int repeat, quint64 seed)
+{
+    QJsonArray results;
+    for (const BenchResult& r : g_results) {
+        QJsonObject o;
+        o.insert("name", r.name);
+        o.insert("assets", r.assets);
+        o.insert("iterations", r.iterations);
+        o.insert("min_ms", r.minMs);
+        o.insert("median_ms", r.medianMs);
+        o.insert("max_ms", r.maxMs);
+        o.insert("throughput", r.throughput);
+        o.insert("unit", r.unit + "/s");
+        results.append(o);
+    }
+    QJsonArray sizeArray;
+    for (int size : sizes)
+        sizeArray.append(size);
+
+    QJsonObject root;
+    root.insert("benchmark", "bench_catalogue");
+    root.insert("timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    root.insert("qt_version", qVersion());
+    root.insert("sizes", sizeArray);
+    root.insert("repeat", repeat);
+    root.insert("seed", QString::number(seed));
+    root.insert("results", results);
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+/* ---------- 各项测量 ---------- */
+
+// 与 StartWindow::filterAssets 相同：分类位图 & 文本位图，再按预计算的排序置换输出
+static QVector<int> filter_assets(const AssetIndex& index, int node, const QString& text,
+    AssetIndex::SortField field, bool descending)
+{
+    const QBitArray bits = index.nodeBits(node) & index.matchText(text);
+    return index.sortedRows(bits, field, descending);
+}
+
+struct Query {
+    int node;
+    QString text;
+    AssetIndex::SortField field;
+    bool descending;
+};
+
+static void bench_filters(const AssetIndex& index, int assets, int repeat, CatalogueGenerator& gen)
+{
+    // 查询组合：浏览全部 / 点分类 / 输入常见词 / 逐字输入 / 长尾词 / 无结果
+    QVector<Query> browse = {
+        { 0, QString(), AssetIndex::SortByKey, false },
+        { 0, QString(), AssetIndex::SortByDownloads, true },
+        { 0, QString(), AssetIndex::SortByDatePublished, true },
+        { 0, QString(), AssetIndex::SortByName, false },
+    };
+    QVector<Query> category;
+    for (int node = 1; node < CATEGORY_NODE_COUNT; ++node)
+        category.append({ node, QString(), AssetIndex::SortByDownloads, true });
+    QVector<Query> common;
+    for (int i = 0; i < 16; ++i)
+        common.append({ 0, QString(TAG_WORDS[i]), AssetIndex::SortByDownloads, true });
+    QVector<Query> typing;
+    for (const char* word : { "wood", "concrete", "sunset", "cobblestone" }) {
+        const QString w(word);
+        for (int n = 1; n <= w.size(); ++n)
+            typing.append({ 0, w.left(n), AssetIndex::SortByKey, false });
+    }
+    QVector<Query> rare;
+    for (int i = 0; i < 16; ++i)
+        rare.append({ 0, gen.vocabulary[gen.vocabulary.size() - 1 - gen.uniform(1000)], AssetIndex::SortByName, false });
+    QVector<Query> combined;
+    for (int i = 0; i < 16; ++i)
+        combined.append({ 1 + gen.uniform(CATEGORY_NODE_COUNT - 1), QString(TAG_WORDS[gen.uniform(TAG_WORD_COUNT)]),
+            AssetIndex::SortByDownloads, true });
+    const QVector<Query> miss = { { 0, "zzqx", AssetIndex::SortByKey, false } };
+
+    const QPair<const char*, QVector<Query>> mixes[] = {
+        { "filterAssets browse", browse },
+        { "filterAssets category", category },
+        { "filterAssets common tag", common },
+        { "filterAssets typing", typing },
+        { "filterAssets rare tag", rare },
+        { "filterAssets category+text", combined },
+        { "filterAssets no match", miss },
+    };
+    for (const auto& mix : mixes) {
+        const QVector<Query>& queries = mix.second;
+        measure(mix.first, assets, repeat, queries.size(), "queries", [&]() {
+            for (const Query& q : queries)
+                g_sink = g_sink + filter_assets(index, q.node, q.text, q.field, q.descending).size();
+        });
+    }
+}
+
+static void bench_thumbnails(const QStringList& paths, int assets, int repeat)
+{
+    if (paths.isEmpty())
+        return;
+
+    // 现行路径：整图解码后再缩放（AssetDelegate 的 QPixmap(path).scaled）
+    measure("thumbnail decode+scale", assets, repeat, paths.size(), "images", [&]() {
+        for (const QString& path : paths) {
+            const QImage image(path);
+            const QImage thumb = image.scaled(THUMB_WIDTH, THUMB_HEIGHT, Qt::KeepAspectRatio, Qt::FastTransformation);
+            g_sink = g_sink + thumb.width();
+        }
+    });
+    // 对照：解码时直接缩放（部分格式可在解码阶段跳过像素）
+    measure("thumbnail reader scaled decode", assets, repeat, paths.size(), "images", [&]() {
+        for (const QString& path : paths) {
+            QImageReader reader(path);
+            const QSize size = reader.size().scaled(THUMB_WIDTH, THUMB_HEIGHT, Qt::KeepAspectRatio);
+            if (size.isValid())
+                reader.setScaledSize(size);
+            g_sink = g_sink + reader.read().width();
+        }
+    });
+}
+
+static bool write_random_file(const QString& path, qint64 size, quint64 seed)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    std::mt19937_64 rng(seed);
+    QByteArray block(HASH_BUFFER_SIZE, Qt::Uninitialized);
+    for (qint64 written = 0; written < size;) {
+        quint64* words = reinterpret_cast<quint64*>(block.data());
+        for (qint64 i = 0; i < block.size() / 8; ++i)
+            words[i] = rng();
+        const qint64 n = qMin<qint64>(block.size(), size - written);
+        if (file.write(block.constData(), n) != n)
+            return false;
+        written += n;
+    }
+    return true;
+}
+
+static void bench_filehash(const QString& dir, int hashMB, int repeat, quint64 seed)
+{
+    if (hashMB <= 0)
+        return;
+    const QString path = QDir(dir).filePath("bench_catalogue_payload.bin");
+    if (!write_random_file(path, qint64(hashMB) << 20, seed)) {
+        std::fprintf(stderr, "Failed to write %s\n", qPrintable(path));
+        return;
+    }
+    // 页缓存已热：测的是哈希本身，磁盘吞吐见 bench_filehash --cold
+    measure("filehash md5", 0, repeat, hashMB, "MB", [&]() { g_sink = g_sink + filehash(path).size(); });
+    QByteArray buffer;
+    measure("filehash xxh64", 0, repeat, hashMB, "MB", [&]() {
+        g_sink = g_sink + filehash(path, HashAlgorithm::XxHash64, buffer).size();
+    });
+    QFile::remove(path);
+}
+
+static void bench_size(int count, int repeat, int thumbnailCount, const QString& dir, quint64 seed)
+{
+    CatalogueGenerator gen(seed + quint64(count));
+    const QByteArray raw = gen.catalogue(count);
+    std::fprintf(g_table, "\n-- %d assets, %.1f MB asset list --\n", count, raw.size() / (1024.0 * 1024.0));
+
+    // 临时资产库：get_asset_lib() 从注入的资产库路径读 asset_list_cache.json
+    QTemporaryDir library(QDir(dir).filePath("bench_catalogue_XXXXXX"));
+    if (!library.isValid()) {
+        std::fprintf(stderr, "Failed to create a temporary library in %s\n", qPrintable(dir));
+        return;
+    }
+    set_asset_lib_path(library.path());
+    if (!write_asset_list_cache(raw)) {
+        std::fprintf(stderr, "Failed to write the asset list cache\n");
+        return;
+    }
+
+    measure("QJsonDocument::fromJson", count, repeat, count, "assets", [&]() {
+        g_sink = g_sink + QJsonDocument::fromJson(raw).object().size();
+    });
+    const QJsonObject root = QJsonDocument::fromJson(raw).object();
+    measure("parseAssetJson", count, repeat, count, "assets", [&]() {
+        g_sink = g_sink + parseAssetJson(root).size();
+    });
+    QMap<QString, QJsonObject> assets;
+    measure("get_asset_lib (read+parse)", count, repeat, count, "assets", [&]() {
+        assets = get_asset_lib();
+        g_sink = g_sink + assets.size();
+    });
+
+    AssetIndex index;
+    measure("AssetIndex::build", count, repeat, count, "assets", [&]() { index.build(assets); });
+
+    bench_filters(index, count, repeat, gen);
+
+    // 模型构建 + 第一屏 data()（浏览器每次筛选都会重建模型）
+    const QVector<int> rows = filter_assets(index, 0, QString(), AssetIndex::SortByKey, false);
+    measure("AssetModel construct", count, repeat, rows.size(), "rows", [&]() {
+        AssetModel model(index, rows);
+        g_sink = g_sink + model.rowCount();
+    });
+    AssetModel model(index, rows);
+    const int visible = qMin(model.rowCount(), 200);
+    measure("AssetModel data (first screen)", count, repeat, visible, "rows", [&]() {
+        for (int row = 0; row < visible; ++row)
+            g_sink = g_sink + model.data(model.index(row), AssetModel::AssetDataRole).toMap().size();
+    });
+
+    // 缩略图按资产库布局写入 <slug>/thumbnail.webp（环境没有 webp 插件时退回 png）
+    const char* format = QImageWriter::supportedImageFormats().contains("webp") ? "webp" : "png";
+    QStringList thumbnails;
+    const int thumbs = qMin(thumbnailCount, count);
+    for (int i = 0; i < thumbs; ++i) {
+        const QString slug = index.slug(i);
+        QDir(library.path()).mkpath(slug);
+        const QString path = QDir(library.path()).filePath(slug + "/thumbnail." + format);
+        if (gen.thumbnail().save(path, format))
+            thumbnails.append(path);
+    }
+    bench_thumbnails(thumbnails, count, repeat);
+
+    set_asset_lib_path(QString());
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QList<int> sizes = { 1000, 10000, 100000 };
+    int repeat = 5;
+    int thumbnailCount = 200;
+    int hashMB = 256;
+    quint64 seed = 20240601;
+    QString dir = QDir::tempPath();
+    QString jsonPath;
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if (arg == "--sizes" && i + 1 < args.size()) {
+            sizes.clear();
+            for (const QString& s : args[++i].split(',', Qt::SkipEmptyParts))
+                sizes.append(qMax(1, s.toInt()));
+        }
+        else if (arg == "--repeat" && i + 1 < args.size())
+            repeat = qMax(1, args[++i].toInt());
+        else if (arg == "--thumbnails" && i + 1 < args.size())
+            thumbnailCount = qMax(0, args[++i].toInt());
+        else if (arg == "--hash-mb" && i + 1 < args.size())
+            hashMB = qMax(0, args[++i].toInt());
+        else if (arg == "--dir" && i + 1 < args.size())
+            dir = args[++i];
+        else if (arg == "--seed" && i + 1 < args.size())
+            seed = args[++i].toULongLong();
+        else if (arg == "--json" && i + 1 < args.size())
+            jsonPath = args[++i];
+        else {
+            std::fprintf(stderr, "Unknown argument: %s\n", qPrintable(arg));
+            return 2;
+        }
+    }
+
+    if (jsonPath == "-")
+        g_table = stderr;
+    std::fprintf(g_table, "%-40s %8s %10s %10s %10s %16s\n", "case", "assets", "min ms", "median ms", "max ms", "throughput");
+    for (int size : sizes)
+        bench_size(size, repeat, thumbnailCount, dir, seed);
+    std::fprintf(g_table, "\n-- payload hashing, %d MB --\n", hashMB);
+    bench_filehash(dir, hashMB, repeat, seed);
+
+    if (!jsonPath.isEmpty()) {
+        const QByteArray json = results_json(sizes, repeat, seed);
+        if (jsonPath == "-") {
+            std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        }
+        else {
+            QFile file(jsonPath);
+            if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+                std::fprintf(stderr, "Failed to write %s\n", qPrintable(jsonPath));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
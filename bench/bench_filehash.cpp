@@ -0,0 +1,194 @@
+﻿// 哈希引擎基准：旧实现（8 KB 分块 + 每块一个 QByteArray）对比新引擎（大缓冲区 + 顺序读提示）、XXH64、批量并行
+//
+// 用法：bench_filehash [--size-gb N] [--files K] [--dir D] [--threads T] [--cold] [文件...]
+//   不给文件时在 D（默认系统临时目录）下生成 K 个（默认 4）共 N GB（默认 2）的随机文件，结束后删除
+//   --cold：每轮前丢弃这些文件的页缓存（仅 Linux），测的是磁盘吞吐；默认先预热，测的是 CPU 吞吐
+
+#include "filehash.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
+#include <cstdio>
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// 改造前的 filehash()，原样保留作为基线
+static QString legacy_filehash(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
+        return "";
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    QByteArray chunk;
+    while (!(chunk = file.read(8192)).isEmpty())
+        hash.addData(chunk);
+    return hash.result().toHex().toLower();
+}
+
+static bool generate_file(const QString& path, qint64 size, quint64 seed)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QByteArray block(HASH_BUFFER_SIZE, Qt::Uninitialized);
+    quint64 state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (qint64 written = 0; written < size;) {
+        quint64* words = reinterpret_cast<quint64*>(block.data());
+        for (qint64 i = 0; i < block.size() / 8; ++i) {
+            // xorshift64：够随机，不让压缩型文件系统占便宜
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            words[i] = state;
+        }
+        const qint64 n = qMin<qint64>(block.size(), size - written);
+        if (file.write(block.constData(), n) != n)
+            return false;
+        written += n;
+    }
+    return true;
+}
+
+static void prepare_cache(const QStringList& files, bool cold)
+{
+    for (const QString& path : files) {
+        if (cold) {
+#ifdef Q_OS_LINUX
+            const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+            if (fd >= 0) {
+                fdatasync(fd);
+                posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd);
+            }
+#endif
+        }
+        else {
+            QFile file(path);
+            if (file.open(QIODevice::ReadOnly)) {
+                QByteArray block(HASH_BUFFER_SIZE, Qt::Uninitialized);
+                while (file.read(block.data(), block.size()) > 0) {}
+            }
+        }
+    }
+}
+
+struct BenchResult {
+    double seconds = 0.0;
+    QStringList digests;
+};
+
+static BenchResult run(const QStringList& files, bool cold, const std::function<QStringList()>& body)
+{
+    prepare_cache(files, cold);
+    QElapsedTimer timer;
+    timer.start();
+    BenchResult result;
+    result.digests = body();
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    double sizeGB = 2.0;
+    int fileCount = 4;
+    int threads = QThread::idealThreadCount();
+    bool cold = false;
+    QString dir = QDir::tempPath();
+    QStringList files;
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if (arg == "--size-gb" && i + 1 < args.size())
+            sizeGB = args[++i].toDouble();
+        else if (arg == "--files" && i + 1 < args.size())
+            fileCount = qMax(1, args[++i].toInt());
+        else if (arg == "--threads" && i + 1 < args.size())
+            threads = qMax(1, args[++i].toInt());
+        else if (arg == "--dir" && i + 1 < args.size())
+            dir = args[++i];
+        else if (arg == "--cold")
+            cold = true;
+        else
+            files.append(arg);
+    }
+
+    const bool generated = files.isEmpty();
+    if (generated) {
+        const qint64 perFile = qint64(sizeGB * 1024.0 * 1024.0 * 1024.0) / fileCount;
+        std::printf("Generating %d files of %lld MB in %s...\n", fileCount, perFile >> 20, qPrintable(dir));
+        for (int i = 0; i < fileCount; ++i) {
+            const QString path = QDir(dir).filePath(QString("bench_filehash_%1.bin").arg(i));
+            if (!generate_file(path, perFile, quint64(i + 1))) {
+                std::fprintf(stderr, "Failed to write %s\n", qPrintable(path));
+                return 1;
+            }
+            files.append(path);
+        }
+    }
+
+    qint64 totalBytes = 0;
+    for (const QString& path : files)
+        totalBytes += QFileInfo(path).size();
+    const double totalMB = totalBytes / (1024.0 * 1024.0);
+    std::printf("%d files, %.1f MB, %s cache, %d threads\n\n", int(files.size()), totalMB,
+        cold ? "cold" : "warm", threads);
+
+    struct Case {
+        const char* name;
+        std::function<QStringList()> body;
+    };
+    const Case cases[] = {
+        { "legacy md5 (8 KB chunks)", [&]() {
+            QStringList out;
+            for (const QString& path : files)
+                out.append(legacy_filehash(path));
+            return out;
+        } },
+        { "filehash md5", [&]() {
+            QStringList out;
+            for (const QString& path : files)
+                out.append(filehash(path));
+            return out;
+        } },
+        { "filehash xxh64", [&]() {
+            QStringList out;
+            QByteArray buffer;
+            for (const QString& path : files)
+                out.append(filehash(path, HashAlgorithm::XxHash64, buffer));
+            return out;
+        } },
+        { "filehash_batch md5", [&]() { return filehash_batch(files, HashAlgorithm::Md5, threads); } },
+        { "filehash_batch xxh64", [&]() { return filehash_batch(files, HashAlgorithm::XxHash64, threads); } },
+    };
+
+    QStringList baseline;
+    std::printf("%-28s %10s %12s\n", "case", "seconds", "MB/s");
+    for (const Case& c : cases) {
+        const BenchResult r = run(files, cold, c.body);
+        std::printf("%-28s %10.3f %12.1f\n", c.name, r.seconds, r.seconds > 0 ? totalMB / r.seconds : 0.0);
+
+        // 新旧 MD5 必须逐文件一致
+        if (baseline.isEmpty())
+            baseline = r.digests;
+        else if (QString(c.name).contains("md5") && r.digests != baseline)
+            std::printf("  !! %s digests differ from legacy\n", c.name);
+    }
+
+    if (generated) {
+        for (const QString& path : files)
+            QFile::remove(path);
+    }
+    return 0;
+}
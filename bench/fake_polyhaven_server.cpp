@@ -0,0 +1,754 @@
+﻿// 本地假 Poly Haven：提供 /assets、/files/<slug>、缩略图和载荷下载，可注入延迟、限速、截断、429/5xx，支持 Range
+// 用来离线、可复现地测整条同步链路的吞吐和容错
+//
+// 用法：fake_polyhaven_server [--port P] [--bind ADDR] [--fixtures DIR | --synthetic N] [--payload-kb K]
+//                             [--seed S] [--latency MS] [--jitter MS] [--bandwidth KBPS] [--truncate P]
+//                             [--error-rate P] [--error-codes 429,500,503] [--no-md5] [--quiet]
+//   客户端配置 ApiBaseUrl / CdnBaseUrl 指向本服务（启动时打印一段可直接使用的 ini），例如
+//     polyhaven_cli -c fake.ini -l "/tmp/Poly Haven" sync
+//   --fixtures 目录布局：
+//     assets.json          /assets 的响应（key 为 slug）
+//     files/<slug>.json    /files/<slug> 的响应，url 中的 {base} 替换为本服务地址
+//     dl/...               /dl/... 的载荷
+//     thumbs/<slug>.png    缩略图（缺省时返回内置的 1x1 PNG）
+//   不给 --fixtures 时生成 N 个（默认 200）合成资产；载荷内容由路径决定，服务重启后断点续传仍然对得上
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtCore/QUrlQuery>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <cstdio>
+#include <cstring>
+
+struct ServerOptions {
+    QString bind = "127.0.0.1";
+    quint16 port = 8089;
+    QString fixtures;
+    int synthetic = 200;
+    qint64 payloadBytes = 512 * 1024;   // 合成载荷 1k 文件的大小，分辨率每翻一倍 ×4
+    quint64 seed = 1;
+    int latencyMs = 0;                  // 每个请求在发响应头前的延迟
+    int jitterMs = 0;
+    qint64 bandwidth = 0;               // 每连接字节/秒，0 表示不限
+    double truncateRate = 0.0;          // 载荷响应被中途截断的概率
+    double errorRate = 0.0;             // 直接返回错误状态码的概率
+    QList<int> errorCodes = { 429, 500, 503 };
+    bool md5 = true;
+    bool quiet = false;
+};
+
+static ServerOptions g_options;
+static QString g_base;                  // 本服务地址，如 http://127.0.0.1:8089
+static QRandomGenerator g_faults;       // 故障注入用，按 --seed 复现
+
+struct ServerStats {
+    qint64 requests = 0;
+    qint64 bytes = 0;
+    qint64 errors = 0;
+    qint64 truncations = 0;
+};
+static ServerStats g_stats;
+
+static const int CHUNK_SIZE = 64 * 1024;
+static const qint64 WRITE_HIGH_WATER = 256 * 1024;   // 套接字写缓冲超过这么多就等 bytesWritten
+static const int PACE_INTERVAL_MS = 10;
+
+// 1x1 PNG，缺省缩略图
+static const unsigned char BUILTIN_PNG[] = {
+    0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1f, 0x15, 0xc4,
+    0x89, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0xf8, 0xcf, 0xc0, 0xf0,
+    0x1f, 0x00, 0x05, 0x00, 0x01, 0xff, 0x89, 0x99, 0x3d, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45,
+    0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+};
+
+/* ---------- 响应体 ---------- */
+
+// 内存数据 / fixture 文件 / 合成载荷；合成载荷可从任意偏移生成，Range 请求不必缓存整份文件
+struct Body {
+    QByteArray data;
+    QString filePath;
+    quint64 seed = 0;
+    bool synthetic = false;
+    qint64 size = 0;
+};
+
+static quint64 splitmix64(quint64 x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// FNV-1a：跨进程稳定（qHash 每个进程随机加盐）
+static quint64 stable_hash(const QByteArray& bytes)
+{
+    quint64 h = 0xcbf29ce484222325ULL;
+    for (char c : bytes) {
+        h ^= quint64(quint8(c));
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// 第 i 个 8 字节字 = splitmix64(seed + i)
+static void synthetic_bytes(quint64 seed, qint64 offset, char* out, qint64 len)
+{
+    qint64 pos = offset;
+    while (len > 0) {
+        const quint64 word = splitmix64(seed + quint64(pos / 8));
+        const int skip = int(pos % 8);
+        const int n = int(qMin<qint64>(8 - skip, len));
+        std::memcpy(out, reinterpret_cast<const char*>(&word) + skip, size_t(n));
+        out += n;
+        pos += n;
+        len -= n;
+    }
+}
+
+static QByteArray read_body(const Body& body, qint64 offset, qint64 len)
+{
+    if (body.synthetic) {
+        QByteArray out(int(len), Qt::Uninitialized);
+        synthetic_bytes(body.seed, offset, out.data(), len);
+        return out;
+    }
+    if (!body.filePath.isEmpty()) {
+        QFile file(body.filePath);
+        if (!file.open(QIODevice::ReadOnly) || !file.seek(offset))
+            return QByteArray();
+        return file.read(len);
+    }
+    return body.data.mid(int(offset), int(len));
+}
+
+static Body memory_body(const QByteArray& data)
+{
+    Body body;
+    body.data = data;
+    body.size = data.size();
+    return body;
+}
+
+/* ---------- 资产目录（fixtures 或合成） ---------- */
+
+static const char* SYNTHETIC_TAGS[] = {
+    "wood", "rock", "outdoor", "nature", "ground", "stone", "floor", "wall", "brick", "metal",
+    "concrete", "fabric", "sand", "snow", "grass", "sunset", "night", "urban", "studio", "forest",
+};
+static const int SYNTHETIC_TAG_COUNT = int(sizeof(SYNTHETIC_TAGS) / sizeof(SYNTHETIC_TAGS[0]));
+
+// 贴图通道：/files 中的 key -> 文件名里的缩写
+static const char* MAP_KEYS[][2] = {
+    { "Diffuse", "diff" }, { "nor_gl", "nor_gl" }, { "Rough", "rough" }, { "Displacement", "disp" },
+};
+
+class Catalogue
+{
+public:
+    bool loadFixtures(const QString& dir, QString& error)
+    {
+        QFile file(QDir(dir).filePath("assets.json"));
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = QString("Cannot open %1: %2").arg(file.fileName(), file.errorString());
+            return false;
+        }
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            error = QString("Invalid %1: %2").arg(file.fileName(), parseError.errorString());
+            return false;
+        }
+        m_fixtures = dir;
+        m_assets = doc.object();
+        return true;
+    }
+
+    void generate(int count, quint64 seed)
+    {
+        QRandomGenerator rng(quint32(seed));
+        for (int i = 0; i < count; ++i) {
+            const QString slug = QString("synthetic_%1").arg(i, 5, 10, QChar('0'));
+            const int roll = int(rng.bounded(100));
+            const int type = roll < 35 ? 0 : (roll < 80 ? 1 : 2);
+            QJsonArray tags;
+            for (int t = 0, n = 2 + int(rng.bounded(4)); t < n; ++t)
+                tags.append(SYNTHETIC_TAGS[rng.bounded(SYNTHETIC_TAG_COUNT)]);
+
+            QJsonObject asset;
+            asset.insert("name", QString("Synthetic %1").arg(i));
+            asset.insert("type", type);
+            asset.insert("tags", tags);
+            asset.insert("categories", QJsonArray{ type == 0 ? "outdoor" : "natural" });
+            asset.insert("download_count", qint64(rng.bounded(100000)));
+            asset.insert("date_published", 1500000000 + qint64(rng.bounded(250000000)));
+            asset.insert("authors", QJsonObject{ { "Synthetic", "All" } });
+            // 载荷内容只由路径决定，files_hash 也固定，重启后不会被当成清单已变
+            asset.insert("files_hash", QString::number(stable_hash((slug + ':' + QString::number(seed)).toUtf8()), 16));
+            m_assets.insert(slug, asset);
+        }
+    }
+
+    int size() const { return m_assets.size(); }
+
+    // ?t=all / hdris / textures / models
+    QByteArray assets(const QString& type) const
+    {
+        static const QStringList TYPES = { "hdris", "textures", "models" };
+        const int wanted = TYPES.indexOf(type);
+        if (wanted < 0)
+            return QJsonDocument(m_assets).toJson(QJsonDocument::Compact);
+        QJsonObject filtered;
+        for (auto it = m_assets.constBegin(); it != m_assets.constEnd(); ++it) {
+            if (it.value().toObject().value("type").toInt() == wanted)
+                filtered.insert(it.key(), it.value());
+        }
+        return QJsonDocument(filtered).toJson(QJsonDocument::Compact);
+    }
+
+    bool files(const QString& slug, QByteArray& json)
+    {
+        auto cached = m_files.constFind(slug);
+        if (cached != m_files.constEnd()) {
+            json = cached.value();
+            return true;
+        }
+        if (!m_assets.contains(slug))
+            return false;
+
+        if (!m_fixtures.isEmpty()) {
+            QFile file(QDir(m_fixtures).filePath(QString("files/%1.json").arg(slug)));
+            if (!file.open(QIODevice::ReadOnly))
+                return false;
+            json = file.readAll().replace("{base}", g_base.toUtf8());
+        }
+        else {
+            json = QJsonDocument(syntheticManifest(slug, m_assets.value(slug).toObject().value("type").toInt()))
+                .toJson(QJsonDocument::Compact);
+        }
+        m_files.insert(slug, json);
+        return true;
+    }
+
+    // /dl/<path>
+    bool payload(const QString& path, Body& body) const
+    {
+        if (path.isEmpty() || path.contains(".."))
+            return false;
+        if (!m_fixtures.isEmpty()) {
+            const QString filePath = QDir(m_fixtures).filePath("dl/" + path);
+            QFileInfo info(filePath);
+            if (!info.isFile())
+                return false;
+            body.filePath = filePath;
+            body.size = info.size();
+            return true;
+        }
+        if (!m_assets.contains(path.section('/', 0, 0)))
+            return false;
+        body.synthetic = true;
+        body.seed = stable_hash(path.toUtf8());
+        body.size = syntheticSize(path);
+        return true;
+    }
+
+    Body thumbnail(const QString& slug) const
+    {
+        if (!m_fixtures.isEmpty() && !slug.contains("..")) {
+            const QString filePath = QDir(m_fixtures).filePath(QString("thumbs/%1.png").arg(slug));
+            QFileInfo info(filePath);
+            if (info.isFile()) {
+                Body body;
+                body.filePath = filePath;
+                body.size = info.size();
+                return body;
+            }
+        }
+        return memory_body(QByteArray(reinterpret_cast<const char*>(BUILTIN_PNG), int(sizeof(BUILTIN_PNG))));
+    }
+
+private:
+    QString m_fixtures;
+    QJsonObject m_assets;
+    QHash<QString, QByteArray> m_files;   // slug -> /files 响应
+
+    // 大小只由路径决定：分辨率每翻一倍 ×4，再按路径上下浮动 25%
+    static qint64 syntheticSize(const QString& path)
+    {
+        qint64 factor = 1;
+        if (path.contains("_2k"))
+            factor = 4;
+        else if (path.contains("_4k"))
+            factor = 16;
+        const qint64 base = g_options.payloadBytes * factor;
+        const qint64 spread = base / 4;
+        const quint64 h = stable_hash(path.toUtf8());
+        return qMax<qint64>(1, base - spread + qint64(h % quint64(2 * spread + 1)));
+    }
+
+    static QString syntheticMd5(const QString& path, qint64 size)
+    {
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        const quint64 seed = stable_hash(path.toUtf8());
+        QByteArray block(1 << 20, Qt::Uninitialized);
+        for (qint64 pos = 0; pos < size;) {
+            const qint64 n = qMin<qint64>(block.size(), size - pos);
+            synthetic_bytes(seed, pos, block.data(), n);
+            hash.addData(QByteArrayView(block.constData(), n));
+            pos += n;
+        }
+        return QString::fromLatin1(hash.result().toHex());
+    }
+
+    static QJsonObject syntheticFile(const QString& path)
+    {
+        const qint64 size = syntheticSize(path);
+        QJsonObject file;
+        file.insert("url", g_base + "/dl/" + path);
+        file.insert("size", size);
+        if (g_options.md5)
+            file.insert("md5", syntheticMd5(path, size));
+        return file;
+    }
+
+    // 与真实 /files 同构：hdri.<res>.<fmt>；<map>.<res>.<fmt>；gltf.<res>.gltf + include
+    static QJsonObject syntheticManifest(const QString& slug, int type)
+    {
+        static const char* RESOLUTIONS[] = { "1k", "2k" };
+        QJsonObject manifest;
+        if (type == 0) {
+            QJsonObject hdri;
+            for (const char* res : RESOLUTIONS) {
+                QJsonObject formats;
+                for (const char* format : { "hdr", "exr" })
+                    formats.insert(format, syntheticFile(QString("%1/%2_%3.%4").arg(slug, slug, res, format)));
+                hdri.insert(res, formats);
+            }
+            manifest.insert("hdri", hdri);
+            return manifest;
+        }
+
+        QJsonObject gltf;
+        for (const auto& map : MAP_KEYS) {
+            QJsonObject byRes;
+            for (const char* res : RESOLUTIONS) {
+                QJsonObject formats;
+                for (const char* format : { "jpg", "png" }) {
+                    formats.insert(format, syntheticFile(QString("%1/%2_%3_%4.%5").arg(slug, slug, map[1], res, format)));
+                }
+                byRes.insert(res, formats);
+            }
+            manifest.insert(map[0], byRes);
+        }
+        for (const char* res : RESOLUTIONS) {
+            QJsonObject include;
+            for (const auto& map : MAP_KEYS) {
+                const QString name = QString("%1_%2_%3.jpg").arg(slug, map[1], res);
+                include.insert("textures/" + name, syntheticFile(QString("%1/%2").arg(slug, name)));
+            }
+            include.insert(slug + ".bin", syntheticFile(QString("%1/%2_%3.bin").arg(slug, slug, res)));
+            QJsonObject main = syntheticFile(QString("%1/%2_%3.gltf").arg(slug, slug, res));
+            main.insert("include", include);
+            gltf.insert(res, QJsonObject{ { "gltf", main } });
+        }
+        manifest.insert("gltf", gltf);
+        return manifest;
+    }
+};
+
+/* ---------- HTTP 连接 ---------- */
+
+static QByteArray reason_phrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 416: return "Range Not Satisfiable";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Error";
+    }
+}
+
+// 只支持单段 bytes=a-b / bytes=a- / bytes=-n；end 为开区间
+static bool parse_range(const QByteArray& value, qint64 size, qint64& start, qint64& end)
+{
+    if (!value.startsWith("bytes=") || value.contains(','))
+        return false;
+    const QByteArray spec = value.mid(6).trimmed();
+    const int dash = spec.indexOf('-');
+    if (dash < 0)
+        return false;
+    const QByteArray first = spec.left(dash);
+    const QByteArray last = spec.mid(dash + 1);
+    bool ok = true;
+    if (first.isEmpty()) {
+        const qint64 suffix = last.toLongLong(&ok);
+        if (!ok || suffix <= 0)
+            return false;
+        start = qMax<qint64>(0, size - suffix);
+        end = size;
+        return start < end;
+    }
+    start = first.toLongLong(&ok);
+    if (!ok)
+        return false;
+    end = last.isEmpty() ? size : qMin(size, last.toLongLong(&ok) + 1);
+    return ok && start < end;
+}
+
+// 每个客户端连接一个；随套接字析构。curl 不做流水线，同一连接上的请求逐个处理
+class Connection : public QObject
+{
+public:
+    Connection(QTcpSocket* socket, Catalogue* catalogue)
+        : QObject(socket)
+        , m_socket(socket)
+        , m_catalogue(catalogue)
+    {
+        m_pacer.setSingleShot(true);
+        connect(&m_pacer, &QTimer::timeout, this, [this]() { pump(); });
+        connect(socket, &QTcpSocket::readyRead, this, [this]() { onReadyRead(); });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this]() { pump(); });
+    }
+
+private:
+    QTcpSocket* m_socket;
+    Catalogue* m_catalogue;
+    QByteArray m_buffer;
+    bool m_busy = false;
+    bool m_keepAlive = true;
+
+    // 当前响应
+    QByteArray m_requestLine;
+    int m_status = 0;
+    Body m_body;
+    qint64 m_pos = 0;
+    qint64 m_end = 0;
+    qint64 m_cut = -1;            // >=0 时写到这里就断开（截断注入）
+    double m_tokens = 0.0;        // 限速令牌桶
+    QElapsedTimer m_tokenClock;
+    QTimer m_pacer;
+
+    void onReadyRead()
+    {
+        m_buffer += m_socket->readAll();
+        if (m_busy)
+            return;
+        const int headerEnd = m_buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            if (m_buffer.size() > 64 * 1024)
+                m_socket->abort();
+            return;
+        }
+        const QByteArray head = m_buffer.left(headerEnd);
+        m_buffer.remove(0, headerEnd + 4);
+
+        const QList<QByteArray> lines = head.split('\n');
+        const QList<QByteArray> request = lines.value(0).trimmed().split(' ');
+        if (request.size() < 3) {
+            m_socket->abort();
+            return;
+        }
+        QHash<QByteArray, QByteArray> headers;
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon > 0)
+                headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+        }
+        m_keepAlive = request[2] == "HTTP/1.1" && headers.value("connection").toLower() != "close";
+        m_requestLine = request[0] + ' ' + request[1];
+        m_busy = true;
+        ++g_stats.requests;
+
+        int delay = g_options.latencyMs;
+        if (g_options.jitterMs > 0)
+            delay += int(g_faults.bounded(g_options.jitterMs + 1));
+        const QByteArray method = request[0];
+        const QByteArray target = request[1];
+        QTimer::singleShot(delay, this, [this, method, target, headers]() { handle(method, target, headers); });
+    }
+
+    void handle(const QByteArray& method, const QByteArray& target, const QHash<QByteArray, QByteArray>& headers)
+    {
+        const bool headOnly = method == "HEAD";
+        if (method != "GET" && !headOnly) {
+            respond(405, {}, memory_body("method not allowed\n"), headOnly);
+            return;
+        }
+
+        // 故障注入：按概率直接返回错误状态码
+        if (g_options.errorRate > 0.0 && g_faults.generateDouble() < g_options.errorRate && !g_options.errorCodes.isEmpty()) {
+            const int status = g_options.errorCodes[int(g_faults.bounded(g_options.errorCodes.size()))];
+            QList<QPair<QByteArray, QByteArray>> extra;
+            if (status == 429 || status == 503)
+                extra.append(qMakePair(QByteArray("Retry-After"), QByteArray("1")));
+            ++g_stats.errors;
+            respond(status, extra, memory_body("injected failure\n"), headOnly);
+            return;
+        }
+
+        const QUrl url(QString::fromLatin1(target));
+        const QString path = url.path();
+        QByteArray json;
+        if (path == "/assets") {
+            respond(200, { { "Content-Type", "application/json" } },
+                memory_body(m_catalogue->assets(QUrlQuery(url).queryItemValue("t"))), headOnly);
+        }
+        else if (path.startsWith("/files/") && m_catalogue->files(path.mid(7), json)) {
+            respond(200, { { "Content-Type", "application/json" } }, memory_body(json), headOnly);
+        }
+        else if (path.startsWith("/asset_img/thumbs/") && path.endsWith(".png")) {
+            const QString slug = path.mid(18, path.size() - 18 - 4);
+            respond(200, { { "Content-Type", "image/png" } }, m_catalogue->thumbnail(slug), headOnly);
+        }
+        else if (path.startsWith("/dl/")) {
+            Body body;
+            if (!m_catalogue->payload(path.mid(4), body)) {
+                respond(404, {}, memory_body("not found\n"), headOnly);
+                return;
+            }
+            QList<QPair<QByteArray, QByteArray>> extra = {
+                { "Content-Type", "application/octet-stream" }, { "Accept-Ranges", "bytes" },
+            };
+            qint64 start = 0;
+            qint64 end = body.size;
+            int status = 200;
+            if (headers.contains("range")) {
+                if (!parse_range(headers.value("range"), body.size, start, end)) {
+                    respond(416, { { "Content-Range", "bytes */" + QByteArray::number(body.size) } },
+                        memory_body(QByteArray()), headOnly);
+                    return;
+                }
+                status = 206;
+                extra.append(qMakePair(QByteArray("Content-Range"), "bytes " + QByteArray::number(start) + '-'
+                    + QByteArray::number(end - 1) + '/' + QByteArray::number(body.size)));
+            }
+            respond(status, extra, body, headOnly, start, end, true);
+        }
+        else {
+            respond(404, {}, memory_body("not found\n"), headOnly);
+        }
+    }
+
+    /**
+     * 写响应头并开始输出 [start, end) 的响应体
+     * @param truncatable 载荷响应才参与截断注入
+     */
+    void respond(int status, const QList<QPair<QByteArray, QByteArray>>& extra, const Body& body, bool headOnly,
+        qint64 start = 0, qint64 end = -1, bool truncatable = false)
+    {
+        if (end < 0)
+            end = body.size;
+        QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + reason_phrase(status) + "\r\n";
+        head += "Content-Length: " + QByteArray::number(end - start) + "\r\n";
+        head += m_keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+        for (const auto& header : extra)
+            head += header.first + ": " + header.second + "\r\n";
+        head += "\r\n";
+        m_socket->write(head);
+
+        m_status = status;
+        m_body = body;
+        m_pos = start;
+        m_end = headOnly ? start : end;
+        m_cut = -1;
+        if (truncatable && !headOnly && g_options.truncateRate > 0.0 && m_end - m_pos > 1
+            && g_faults.generateDouble() < g_options.truncateRate) {
+            m_cut = m_pos + qint64(g_faults.bounded(quint64(m_end - m_pos)));
+        }
+        m_tokens = 0.0;
+        m_tokenClock.start();
+        pump();
+    }
+
+    void pump()
+    {
+        if (!m_busy || m_pacer.isActive())
+            return;
+        // 写缓冲里还压着数据就等 bytesWritten 再写，内存占用与文件大小无关
+        while (m_pos < m_end && m_socket->bytesToWrite() < WRITE_HIGH_WATER) {
+            qint64 chunk = qMin<qint64>(CHUNK_SIZE, m_end - m_pos);
+            if (g_options.bandwidth > 0) {
+                // 令牌桶：最多攒 1 秒的额度
+                m_tokens = qMin(double(g_options.bandwidth),
+                    m_tokens + g_options.bandwidth * (m_tokenClock.restart() / 1000.0));
+                if (m_tokens < 1.0) {
+                    m_pacer.start(PACE_INTERVAL_MS);
+                    return;
+                }
+                chunk = qMin(chunk, qint64(m_tokens));
+                m_tokens -= double(chunk);
+            }
+            if (m_cut >= 0)
+                chunk = qMin(chunk, m_cut - m_pos);
+            if (chunk > 0) {
+                m_socket->write(read_body(m_body, m_pos, chunk));
+                m_pos += chunk;
+                g_stats.bytes += chunk;
+            }
+            if (m_cut >= 0 && m_pos >= m_cut) {
+                // 截断：已写出的部分发完后断开，客户端收到的字节少于 Content-Length
+                ++g_stats.truncations;
+                log("truncated");
+                m_busy = false;
+                m_socket->disconnectFromHost();
+                return;
+            }
+        }
+        if (m_pos >= m_end)
+            finish();
+    }
+
+    void finish()
+    {
+        log(nullptr);
+        m_busy = false;
+        m_body = Body();
+        if (!m_keepAlive) {
+            m_socket->disconnectFromHost();
+            return;
+        }
+        // 客户端可能已经发来下一个请求
+        if (!m_buffer.isEmpty())
+            QTimer::singleShot(0, this, [this]() { onReadyRead(); });
+    }
+
+    void log(const char* note)
+    {
+        if (g_options.quiet)
+            return;
+        std::printf("[fake] %d %s%s%s\n", m_status, m_requestLine.constData(), note ? " " : "", note ? note : "");
+        std::fflush(stdout);
+    }
+};
+
+/* ---------- 入口 ---------- */
+
+static void print_usage()
+{
+    std::fputs(
+        "Usage: fake_polyhaven_server [--port P] [--bind ADDR] [--fixtures DIR | --synthetic N] [--payload-kb K]\n"
+        "                             [--seed S] [--latency MS] [--jitter MS] [--bandwidth KBPS] [--truncate P]\n"
+        "                             [--error-rate P] [--error-codes 429,500,503] [--no-md5] [--quiet]\n",
+        stderr);
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (arg == "--port" && hasValue)
+            g_options.port = quint16(args[++i].toUInt());
+        else if (arg == "--bind" && hasValue)
+            g_options.bind = args[++i];
+        else if (arg == "--fixtures" && hasValue)
+            g_options.fixtures = args[++i];
+        else if (arg == "--synthetic" && hasValue)
+            g_options.synthetic = qMax(1, args[++i].toInt());
+        else if (arg == "--payload-kb" && hasValue)
+            g_options.payloadBytes = qMax<qint64>(1, args[++i].toLongLong()) * 1024;
+        else if (arg == "--seed" && hasValue)
+            g_options.seed = args[++i].toULongLong();
+        else if (arg == "--latency" && hasValue)
+            g_options.latencyMs = qMax(0, args[++i].toInt());
+        else if (arg == "--jitter" && hasValue)
+            g_options.jitterMs = qMax(0, args[++i].toInt());
+        else if (arg == "--bandwidth" && hasValue)
+            g_options.bandwidth = qMax<qint64>(0, args[++i].toLongLong()) * 1024;
+        else if (arg == "--truncate" && hasValue)
+            g_options.truncateRate = qBound(0.0, args[++i].toDouble(), 1.0);
+        else if (arg == "--error-rate" && hasValue)
+            g_options.errorRate = qBound(0.0, args[++i].toDouble(), 1.0);
+        else if (arg == "--error-codes" && hasValue) {
+            g_options.errorCodes.clear();
+            for (const QString& code : args[++i].split(',', Qt::SkipEmptyParts))
+                g_options.errorCodes.append(code.toInt());
+        }
+        else if (arg == "--no-md5")
+            g_options.md5 = false;
+        else if (arg == "--quiet")
+            g_options.quiet = true;
+        else {
+            print_usage();
+            return 2;
+        }
+    }
+    g_faults.seed(quint32(g_options.seed));
+
+    QTcpServer server;
+    if (!server.listen(QHostAddress(g_options.bind), g_options.port)) {
+        std::fprintf(stderr, "Cannot listen on %s:%u: %s\n", qPrintable(g_options.bind), unsigned(g_options.port),
+            qPrintable(server.errorString()));
+        return 1;
+    }
+    // --port 0 时由系统分配端口，清单里的 url 要用实际端口
+    g_base = QString("http://%1:%2").arg(g_options.bind).arg(server.serverPort());
+
+    Catalogue catalogue;
+    if (!g_options.fixtures.isEmpty()) {
+        QString error;
+        if (!catalogue.loadFixtures(g_options.fixtures, error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+    }
+    else {
+        catalogue.generate(g_options.synthetic, g_options.seed);
+    }
+
+    QObject::connect(&server, &QTcpServer::newConnection, [&]() {
+        while (QTcpSocket* socket = server.nextPendingConnection()) {
+            new Connection(socket, &catalogue);
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+
+    // 每 5 秒一行汇总（有流量时）
+    QElapsedTimer uptime;
+    uptime.start();
+    qint64 lastBytes = 0;
+    qint64 lastRequests = 0;
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout, [&]() {
+        if (g_stats.requests == lastRequests && g_stats.bytes == lastBytes)
+            return;
+        std::printf("[fake] %lld requests, %.1f MB sent (%.1f MB/s), %lld injected errors, %lld truncations\n",
+            g_stats.requests, g_stats.bytes / (1024.0 * 1024.0),
+            (g_stats.bytes - lastBytes) / (1024.0 * 1024.0) / 5.0, g_stats.errors, g_stats.truncations);
+        std::fflush(stdout);
+        lastBytes = g_stats.bytes;
+        lastRequests = g_stats.requests;
+    });
+    statsTimer.start(5000);
+
+    std::printf("Serving %d assets at %s\n", catalogue.size(), qPrintable(g_base));
+    std::printf("Point the client at it with these settings (e.g. polyhaven_cli -c fake.ini):\n"
+        "  ApiBaseUrl=%s\n  CdnBaseUrl=%s\n", qPrintable(g_base), qPrintable(g_base));
+    std::fflush(stdout);
+    return app.exec();
+}
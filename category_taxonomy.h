@@ -0,0 +1,237 @@
+﻿#ifndef CATEGORY_TAXONOMY_H
+#define CATEGORY_TAXONOMY_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Poly Haven 分类树（编译期生成）
+ * 原先 StartWindow::parseCatalogFile() 每次 loadTreeModel() 都要用 QTextStream + split + QSet
+ * 重新解析一段 "UUID:路径" 字符串；现在原始条目只在 CATALOG_ENTRIES 中写一次，
+ * 节点排序、父子关系、名称、匹配词以及路径 -> 节点 id 的完美哈希表全部由 constexpr 在编译期算出，
+ * 运行期建树和点击分类都不再做任何解析。
+ */
+
+// 单个节点的最大匹配词数（路径深度去掉 ALL 与类型根）
+constexpr int CATEGORY_MAX_TERMS = 4;
+
+struct CatalogEntry {
+    std::string_view uuid;
+    std::string_view path;      // 以 "ALL/" 开头的完整路径
+};
+
+struct CategoryNode {
+    std::string_view uuid;
+    std::string_view path;      // "ALL/HDRIs/Indoor"
+    std::string_view name;      // "Indoor"
+    int parent = -1;            // 父节点 id（根节点为 -1）
+    int depth = 0;              // "ALL" 为 0
+    int assetType = -1;         // 0:HDRIs,1:Textures,2:Models,-1:不限
+    int termCount = 0;
+    std::array<std::string_view, CATEGORY_MAX_TERMS> terms{};  // 资产 tags 需全部命中的词
+};
+
+// 原始分类条目（与 Blender blender_assets.cats.txt 的 UUID 保持一致）
+inline constexpr CatalogEntry CATALOG_ENTRIES[] = {
+    { "", "ALL" },
+    { "6b43eea6-2dee-4960-8ff0-edfb4f283858", "ALL/HDRIs" },
+    { "e2328e9a-1cec-4c44-b542-5cd52bfbce19", "ALL/HDRIs/Indoor" },
+    { "1f0e3686-4835-433f-a076-074d204d3a43", "ALL/HDRIs/Indoor/Natural Light" },
+    { "00459860-c6d8-4632-b5e9-19929853cf3b", "ALL/HDRIs/Indoor/Natural Light/Medium Contrast" },
+    { "7c6ef490-2383-461c-b6ee-dcdd6714a2c4", "ALL/HDRIs/Indoor/Natural Light/Low Contrast" },
+    { "5cb78b4d-9bcc-4b91-8a30-ff185da05e18", "ALL/HDRIs/Indoor/Natural Light/High Contrast" },
+    { "768ae7a1-5518-495d-9176-7cccad60a71c", "ALL/HDRIs/Indoor/Artificial Light" },
+    { "5f70a139-9202-4fc9-a218-bcea5f9ab263", "ALL/HDRIs/Indoor/Artificial Light/Medium Contrast" },
+    { "1134e281-8fda-4913-9662-06d42776b3e9", "ALL/HDRIs/Indoor/Artificial Light/Low Contrast" },
+    { "1325556c-7986-4568-a694-1134b6e16d32", "ALL/HDRIs/Indoor/Artificial Light/High Contrast" },
+    { "f1e775ea-3173-41fe-b0e1-e315a61ab694", "ALL/HDRIs/Indoor/Studio" },
+    { "feae2c70-9016-4506-af27-6db147f93d00", "ALL/HDRIs/Indoor/Studio/Medium Contrast" },
+    { "af336f94-da70-4e9e-b3aa-9444d6b270fc", "ALL/HDRIs/Indoor/Studio/Low Contrast" },
+    { "0ecbbd9d-7504-41d6-988c-1470362f5fc4", "ALL/HDRIs/Indoor/Studio/High Contrast" },
+    { "a40d8a97-03b5-4a77-aafc-4f31126329fe", "ALL/HDRIs/Outdoor" },
+    { "eac57a1b-31a6-4542-a7c6-797799cc49c9", "ALL/HDRIs/Outdoor/Nature" },
+    { "41ce4c4f-8ff1-4aa9-ae68-0120b44f0b77", "ALL/HDRIs/Outdoor/Nature/Midday" },
+    { "8d14dcb5-f464-43ea-bbf5-15df36cf406e", "ALL/HDRIs/Outdoor/Nature/Morning-afternoon" },
+    { "415760a2-a428-4781-bf8e-636735f059fe", "ALL/HDRIs/Outdoor/Nature/Night" },
+    { "0f03b383-10da-4c89-819f-02a29bbc4bce", "ALL/HDRIs/Outdoor/Nature/Sunrise-sunset" },
+    { "8908b21d-a3fe-48ab-a59c-3d1d4553344a", "ALL/HDRIs/Outdoor/Urban" },
+    { "5f2c9621-3c96-4944-8206-d11cef84b586", "ALL/HDRIs/Outdoor/Urban/Midday" },
+    { "18a3a12c-9d33-404c-9c95-811fe23052a8", "ALL/HDRIs/Outdoor/Urban/Morning-afternoon" },
+    { "44100f90-2dc1-4d97-b8dc-d192afd42b89", "ALL/HDRIs/Outdoor/Urban/Night" },
+    { "b35909d0-be3d-4be5-a888-caf24f881148", "ALL/HDRIs/Outdoor/Urban/Sunrise-sunset" },
+    { "f2d63417-5e13-4efd-9987-93697bbf0a40", "ALL/HDRIs/Outdoor/Skies" },
+    { "ee1c2a23-f241-40e2-a0f1-46f3469b6ac7", "ALL/HDRIs/Outdoor/Skies/Midday" },
+    { "f21f81e2-3dde-4f2c-b9b4-3180a98d3d2e", "ALL/HDRIs/Outdoor/Skies/Morning-afternoon" },
+    { "8e41e6f9-b630-40c3-8427-3bace6c8268c", "ALL/HDRIs/Outdoor/Skies/Night" },
+    { "e64bbf5b-1ddf-47b2-9a6f-adf38150e68c", "ALL/HDRIs/Outdoor/Skies/Sunrise-sunset" },
+    { "0b4a1940-abfc-435d-ae06-1b1912fcb0fa", "ALL/Textures" },
+    { "fc0b7e40-beca-4085-a2c0-62fcff980615", "ALL/Textures/Rock" },
+    { "57a6a6bc-1144-4fb9-9858-226c85c1062d", "ALL/Textures/Terrain" },
+    { "f0457b2f-0212-4fb7-968b-35cb79bf6c8b", "ALL/Textures/Terrain/Aerial" },
+    { "5314108e-cb5a-43a5-aee0-0dc00fc2ed88", "ALL/Textures/Terrain/Rock" },
+    { "c79f5bda-6ad7-4556-972a-8dcc07a2d3f2", "ALL/Textures/Terrain/Sand" },
+    { "8753a952-0631-4b2d-9dbf-1122a725268e", "ALL/Textures/Terrain/Snow" },
+    { "eba19344-dabb-4949-b152-04bad720a3f7", "ALL/Textures/Roofing" },
+    { "e267e464-8444-4213-b8ab-426d0aae55c3", "ALL/Textures/Wood" },
+    { "cb20759c-8417-4047-aca2-19755b99e892", "ALL/Textures/Brick" },
+    { "dde53271-57f5-4d03-9d49-0384142ce2f4", "ALL/Textures/Fabric" },
+    { "09cf6a6c-a358-4f01-b38e-fe17f027f493", "ALL/Textures/Metal" },
+    { "18ac3bd9-c74b-419b-b275-31047f5ade74", "ALL/Textures/Plaster-concrete" },
+    { "38881529-9e8f-474e-81c8-d535cba978f4", "ALL/Models" },
+    { "419127fb-d621-4dd9-b881-8e0d625119fb", "ALL/Models/Props" },
+    { "1082487c-9383-4e5d-bbbd-13fe8007dc9e", "ALL/Models/Props/Appliances" },
+    { "b02575d8-d0fb-4a8c-8233-ec3ac8b4b052", "ALL/Models/Props/Electronics" },
+    { "62daa2e2-0e53-4623-a9ed-fee4190c99e0", "ALL/Models/Props/Tools" },
+    { "d006c372-76c4-4f2b-b22d-42d60b89d086", "ALL/Models/Industrial" },
+    { "3dfced29-5b6c-4a9c-8e4a-19e1c1330c4c", "ALL/Models/Lighting" },
+    { "ae0813db-d65b-447f-8535-2a4856d98b9a", "ALL/Models/Nature" },
+    { "d88a690f-556e-4936-a8a6-9b675b8c2031", "ALL/Models/Nature/Food" },
+    { "e60a325b-60d7-4b45-9e0d-1bb268c763bb", "ALL/Models/Nature/Ground Cover" },
+    { "f55affcc-c81f-4e51-9b76-b4273189824a", "ALL/Models/Nature/Ground Cover/Grass" },
+    { "35e80462-1b62-4736-95dc-ed8bb0c4cb1a", "ALL/Models/Nature/Plants" },
+    { "05825054-8739-4c42-8bc7-f70e15625a9b", "ALL/Models/Nature/Potted Plants" },
+    { "1d68844f-b0e7-40ee-8819-d81eb1ee6baf", "ALL/Models/Nature/Rocks" },
+    { "5eb59ce6-abcf-4c4c-8b72-d3540ceda629", "ALL/Models/Furniture" },
+    { "c362fb1a-f3cf-4afc-ab4c-9ac979d7a20d", "ALL/Models/Furniture/Seating" },
+    { "f7d9a241-6a68-4104-bdf8-1c13109e8e6c", "ALL/Models/Furniture/Shelves" },
+    { "dac0d06c-3e0d-4530-981c-530b89fb0cb2", "ALL/Models/Furniture/Table" },
+};
+
+constexpr int CATEGORY_NODE_COUNT = int(sizeof(CATALOG_ENTRIES) / sizeof(CATALOG_ENTRIES[0]));
+static_assert(CATEGORY_NODE_COUNT <= 64, "category mask is a quint64, at most 64 nodes");
+
+namespace category_detail {
+
+constexpr int depthOf(std::string_view path)
+{
+    int depth = 0;
+    for (char c : path)
+        if (c == '/') ++depth;
+    return depth;
+}
+
+constexpr bool lessNode(const CatalogEntry& a, const CatalogEntry& b)
+{
+    int da = depthOf(a.path);
+    int db = depthOf(b.path);
+    return da != db ? da < db : a.path < b.path;
+}
+
+constexpr std::array<CategoryNode, CATEGORY_NODE_COUNT> buildNodes()
+{
+    // 1. 按（深度, 路径）排序，保证父节点一定排在子节点之前（与原 parseCatalogFile 顺序一致）
+    std::array<CatalogEntry, CATEGORY_NODE_COUNT> sorted{};
+    for (int i = 0; i < CATEGORY_NODE_COUNT; ++i)
+        sorted[i] = CATALOG_ENTRIES[i];
+    for (int i = 1; i < CATEGORY_NODE_COUNT; ++i) {
+        CatalogEntry key = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && lessNode(key, sorted[j])) {
+            sorted[j + 1] = sorted[j];
+            --j;
+        }
+        sorted[j + 1] = key;
+    }
+
+    // 2. 父子关系、名称、类型与匹配词
+    std::array<CategoryNode, CATEGORY_NODE_COUNT> nodes{};
+    for (int i = 0; i < CATEGORY_NODE_COUNT; ++i) {
+        CategoryNode& node = nodes[i];
+        node.uuid = sorted[i].uuid;
+        node.path = sorted[i].path;
+        node.depth = depthOf(node.path);
+
+        std::size_t slash = node.path.rfind('/');
+        node.name = slash == std::string_view::npos ? node.path : node.path.substr(slash + 1);
+        if (slash == std::string_view::npos)
+            continue;
+
+        std::string_view parentPath = node.path.substr(0, slash);
+        for (int p = 0; p < i; ++p) {
+            if (nodes[p].path == parentPath) {
+                node.parent = p;
+                break;
+            }
+        }
+
+        const CategoryNode& parent = nodes[node.parent];
+        node.assetType = parent.assetType;
+        node.termCount = parent.termCount;
+        node.terms = parent.terms;
+        if (node.depth == 1) {
+            if (node.name == "HDRIs") node.assetType = 0;
+            else if (node.name == "Textures") node.assetType = 1;
+            else if (node.name == "Models") node.assetType = 2;
+            else node.terms[node.termCount++] = node.name;
+        }
+        else {
+            node.terms[node.termCount++] = node.name;
+        }
+    }
+    return nodes;
+}
+
+// FNV-1a（带种子），用于路径 -> 节点 id 的完美哈希
+constexpr std::uint32_t hashPath(std::string_view path, std::uint32_t seed)
+{
+    std::uint32_t h = 2166136261u ^ seed;
+    for (char c : path) {
+        h ^= std::uint8_t(c);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr int HASH_SLOTS = 1024;    // 2 的幂；62 个键时随机种子无冲突的概率约 15%
+
+struct PerfectHash {
+    std::uint32_t seed = 0;
+    std::array<std::int8_t, HASH_SLOTS> slots{};
+};
+
+constexpr PerfectHash buildPerfectHash(const std::array<CategoryNode, CATEGORY_NODE_COUNT>& nodes)
+{
+    PerfectHash ph{};
+    for (std::uint32_t seed = 1; seed < 100000; ++seed) {
+        for (auto& s : ph.slots) s = -1;
+        bool ok = true;
+        for (int i = 0; i < CATEGORY_NODE_COUNT && ok; ++i) {
+            std::uint32_t slot = hashPath(nodes[i].path, seed) & (HASH_SLOTS - 1);
+            if (ph.slots[slot] != -1)
+                ok = false;
+            else
+                ph.slots[slot] = std::int8_t(i);
+        }
+        if (ok) {
+            ph.seed = seed;
+            return ph;
+        }
+    }
+    return ph;  // seed == 0 表示失败，由下方 static_assert 拦截
+}
+
+} // namespace category_detail
+
+// 分类节点表：下标即节点 id，父节点总在子节点之前
+inline constexpr std::array<CategoryNode, CATEGORY_NODE_COUNT> CATEGORY_NODES = category_detail::buildNodes();
+
+inline constexpr category_detail::PerfectHash CATEGORY_PATH_HASH = category_detail::buildPerfectHash(CATEGORY_NODES);
+static_assert(CATEGORY_PATH_HASH.seed != 0, "no collision-free seed found for category path hash");
+
+/**
+ * 路径 -> 节点 id（完美哈希，一次 FNV + 一次比较）
+ * @param path 完整路径（如 "ALL/HDRIs/Indoor"）
+ * @return 节点 id；未知路径返回 -1
+ */
+constexpr int find_category_node(std::string_view path)
+{
+    std::uint32_t slot = category_detail::hashPath(path, CATEGORY_PATH_HASH.seed) & (category_detail::HASH_SLOTS - 1);
+    int id = CATEGORY_PATH_HASH.slots[slot];
+    return (id >= 0 && CATEGORY_NODES[id].path == path) ? id : -1;
+}
+
+static_assert(find_category_node("ALL") == 0, "root node must be id 0");
+static_assert(find_category_node("ALL/HDRIs/Indoor/Studio") >= 0, "category path hash lookup failed");
+
+#endif // CATEGORY_TAXONOMY_H
@@ -0,0 +1,77 @@
+﻿// 独立命令行：不依赖 Houdini，只链接 polyhaven_core（QtCore + libcurl），子命令与 cmd_polyhaven 相同
+//
+// 用法：polyhaven_cli [-r] [-q] [-v] [-j jobs] [-l library] [-c settings.ini] [-t trace.json] [-m metrics.json] <subcommand> [args]
+//   适合没有 Houdini 许可的渲染节点 / CI 机器预热资产库，退出码见 HeadlessExitCode
+
+#include "headless_pull.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <cstdio>
+
+static const char* CLI_USAGE =
+    "Usage: polyhaven_cli [-r] [-q] [-v] [-j jobs] [-l library] [-c settings.ini] [-t trace.json] [-m metrics.json] <subcommand> [args]\n"
+    "  sync [type]         download missing assets (type: all, hdris, textures, models)\n"
+    "  plan [type]         report what sync would transfer, without downloading\n"
+    "  verify [type]       check local files against the manifest md5\n"
+    "  search <words...>   list matching assets, most downloaded first\n"
+    "  fetch <slug...>     download the given assets\n"
+    "  -r  re-fetch file manifests of assets that are already present\n"
+    "  -q  no progress output\n"
+    "  -v  also print INFO log lines\n"
+    "  -j  maximum concurrent downloads\n"
+    "  -l  asset library root (default: the path last chosen in the Houdini browser)\n"
+    "  -c  read settings from this ini file instead of the browser's settings\n"
+    "  -t  record this run and write a Chrome trace JSON (chrome://tracing, ui.perfetto.dev)\n"
+    "  -m  write a metrics snapshot as JSON when the run ends (- for stdout)\n";
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList arguments = QCoreApplication::arguments();
+
+    HeadlessOptions options;
+    QString subcommand;
+    QStringList rest;
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString& arg = arguments[i];
+        // 子命令之后的参数原样交给子命令
+        if (!subcommand.isEmpty()) {
+            rest.append(arg);
+            continue;
+        }
+        if (arg == "-r") {
+            options.revalidate = true;
+        }
+        else if (arg == "-q") {
+            options.quiet = true;
+        }
+        else if (arg == "-v") {
+            options.verbose = true;
+        }
+        else if ((arg == "-j" || arg == "-l" || arg == "-c" || arg == "-t" || arg == "-m") && i + 1 < arguments.size()) {
+            const QString value = arguments[++i];
+            if (arg == "-j")
+                options.jobs = value.toInt();
+            else if (arg == "-l")
+                options.libraryPath = value;
+            else if (arg == "-t")
+                options.traceFile = value;
+            else if (arg == "-m")
+                options.metricsFile = value;
+            else
+                options.settingsFile = value;
+        }
+        else if (arg.startsWith('-')) {
+            std::fputs(CLI_USAGE, stderr);
+            return PH_EXIT_USAGE;
+        }
+        else {
+            subcommand = arg;
+        }
+    }
+
+    const int status = headless_run(subcommand, rest, options);
+    if (status == PH_EXIT_USAGE)
+        std::fputs(CLI_USAGE, stderr);
+    return status;
+}
@@ -12,6 +12,12 @@ static const QMap<QString, QString> REQ_HEADERS = {
 
 static const bool early_access = false;
 
+// QSettings 的组织名 / 程序名：浏览器和 cmd_polyhaven 子命令共用同一份配置
+static const QString SETTINGS_ORG_NAME = "coolaken";
+static const QString SETTINGS_APP_NAME = "polyhavenforhoudini";
+// 资产库根路径（浏览器上次选择的路径；命令行未指定 -l 时沿用）
+static const QString SETTINGS_LIBRARY_PATH_KEY = "LastFilepath";
+
 // 全局日志宏（模拟 Python 打印调试信息）
 #define LOG_DEBUG(msg) qDebug() << "[get_asset_lib] DEBUG:" << msg
 #define LOG_ERROR(msg) qWarning() << "[get_asset_lib] ERROR:" << msg
@@ -0,0 +1,138 @@
+﻿#include "content_store.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <filesystem>
+#include <system_error>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static fs::path to_fs_path(const QString& path)
+{
+#ifdef Q_OS_WIN
+    return fs::path(path.toStdWString());
+#else
+    return fs::path(QFile::encodeName(path).toStdString());
+#endif
+}
+
+QString link_or_copy(const QString& sourcePath, const QString& destPath)
+{
+    const fs::path source = to_fs_path(sourcePath);
+    const fs::path dest = to_fs_path(destPath);
+    std::error_code ec;
+
+    fs::create_directories(dest.parent_path(), ec);
+    fs::remove(dest, ec);
+
+    ec.clear();
+    fs::create_hard_link(source, dest, ec);
+    if (!ec)
+        return "";
+
+    // 跨卷 / 文件系统不支持硬链接：符号链接（Windows 上可能需要开发者模式或管理员权限）
+    ec.clear();
+    fs::create_symlink(fs::absolute(source), dest, ec);
+    if (!ec)
+        return "";
+
+    ec.clear();
+    fs::copy_file(source, dest, fs::copy_options::overwrite_existing, ec);
+    if (ec)
+        return QString("Failed to link or copy %1 to %2: %3").arg(sourcePath).arg(destPath).arg(QString::fromStdString(ec.message()));
+    return "";
+}
+
+QString replace_file(const QString& sourcePath, const QString& destPath)
+{
+    // QFile::rename 不覆盖已有文件；std::filesystem::rename 在 POSIX 上是 rename(2)，
+    // 在 Windows 上是带 MOVEFILE_REPLACE_EXISTING 的 MoveFileEx
+    std::error_code ec;
+    fs::rename(to_fs_path(sourcePath), to_fs_path(destPath), ec);
+    if (ec)
+        return QString("Failed to move %1 into place: %2").arg(sourcePath).arg(QString::fromStdString(ec.message()));
+    return "";
+}
+
+bool is_shared_link(const QString& path)
+{
+    const fs::path p = to_fs_path(path);
+    std::error_code ec;
+    if (fs::is_symlink(fs::symlink_status(p, ec)))
+        return true;
+    ec.clear();
+    const std::uintmax_t links = fs::hard_link_count(p, ec);
+    return !ec && links > 1;
+}
+
+FileIdentity file_identity(const QString& path)
+{
+    FileIdentity id;
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(path.utf16()), 0,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+        return id;
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(handle, &info)) {
+        id.device = info.dwVolumeSerialNumber;
+        id.inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    }
+    CloseHandle(handle);
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+        id.device = quint64(st.st_dev);
+        id.inode = quint64(st.st_ino);
+    }
+#endif
+    return id;
+}
+
+ContentStore::ContentStore(const QString& libraryPath)
+{
+    if (!libraryPath.isEmpty())
+        m_root = QDir(libraryPath).filePath(".store");
+}
+
+QString ContentStore::blobPath(const QString& md5) const
+{
+    const QString key = md5.toLower();
+    return QString("%1/%2/%3").arg(m_root).arg(key.left(2)).arg(key);
+}
+
+bool ContentStore::contains(const QString& md5, qint64 size) const
+{
+    if (!isValid() || md5.isEmpty())
+        return false;
+    QFileInfo blob(blobPath(md5));
+    return blob.exists() && blob.size() > 0 && (size <= 0 || blob.size() == size);
+}
+
+QString ContentStore::materialize(const QString& md5, const QString& destPath) const
+{
+    if (!isValid() || md5.isEmpty())
+        return "Content store is not configured";
+    return link_or_copy(blobPath(md5), destPath);
+}
+
+QString ContentStore::ingest(const QString& filePath, const QString& md5) const
+{
+    if (!isValid() || md5.isEmpty())
+        return "Content store is not configured";
+
+    const QString blob = blobPath(md5);
+    if (!QFileInfo::exists(blob)) {
+        QDir().mkpath(QFileInfo(blob).absolutePath());
+        // 仓库与资产目录同在资产库下，rename 不跨卷；并发收录同一内容时后到的会失败，走下面的链接分支
+        if (QFile::rename(filePath, blob))
+            return link_or_copy(blob, filePath);
+    }
+    return link_or_copy(blob, filePath);
+}
@@ -0,0 +1,86 @@
+﻿#ifndef CONTENT_STORE_H
+#define CONTENT_STORE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qhashfunctions.h>
+
+/**
+ * 按内容寻址的文件仓库（<资产库>/.store/<md5 前两位>/<md5>）
+ * 每个 blob 只存一份，资产目录里的文件是指向 blob 的硬链接；
+ * 跨文件系统建不了硬链接时退回符号链接，再不行才复制。
+ * 共享 include、不同文件名的同一内容都只占一份磁盘、只下载一次。
+ */
+class ContentStore
+{
+public:
+    ContentStore() = default;
+
+    /** @param libraryPath 资产库根目录（仓库放在其下的 .store） */
+    explicit ContentStore(const QString& libraryPath);
+
+    bool isValid() const { return !m_root.isEmpty(); }
+    const QString& root() const { return m_root; }
+
+    /** blob 路径（不保证存在） */
+    QString blobPath(const QString& md5) const;
+
+    /**
+     * 仓库中是否已有该内容
+     * @param md5 清单中的 md5
+     * @param size 清单中的字节数（>0 时一并比对，防止残缺 blob）
+     */
+    bool contains(const QString& md5, qint64 size = 0) const;
+
+    /**
+     * 把 blob 落到资产目录中的路径（已存在的目标文件会被替换）
+     * @return 错误信息（空表示成功）
+     */
+    QString materialize(const QString& md5, const QString& destPath) const;
+
+    /**
+     * 收录刚下载好的文件：移入仓库后在原位置建链接；仓库里已有同内容时直接丢弃本地副本改为链接
+     * 调用方负责事先校验 md5
+     * @return 错误信息（空表示成功）
+     */
+    QString ingest(const QString& filePath, const QString& md5) const;
+
+private:
+    QString m_root;
+};
+
+/**
+ * 让 destPath 与 sourcePath 内容相同：硬链接 -> 符号链接 -> 复制，依次尝试
+ * @return 错误信息（空表示成功）
+ */
+QString link_or_copy(const QString& sourcePath, const QString& destPath);
+
+/**
+ * 用 sourcePath 原子替换 destPath（destPath 已存在时覆盖，同卷内改名）
+ * @return 错误信息（空表示成功）
+ */
+QString replace_file(const QString& sourcePath, const QString& destPath);
+
+/** 是否为共享内容的链接：符号链接，或硬链接数大于 1（仓库 blob、其他资产的同一文件） */
+bool is_shared_link(const QString& path);
+
+/** 文件身份（卷 + inode / file index）：同一内容的多个硬链接身份相同 */
+struct FileIdentity {
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    bool isValid() const { return inode != 0; }
+    bool operator==(const FileIdentity& other) const { return device == other.device && inode == other.inode; }
+};
+
+inline size_t qHash(const FileIdentity& id, size_t seed = 0)
+{
+    return qHash(id.device, seed) ^ qHash(id.inode, seed);
+}
+
+/**
+ * 读取文件身份
+ * @return 无法读取时返回无效身份
+ */
+FileIdentity file_identity(const QString& path);
+
+#endif // CONTENT_STORE_H
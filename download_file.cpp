@@ -1,15 +1,158 @@
 ﻿#include "download_file.h"
+#include "trace.h"
+#include "metrics.h"
+#include <QtCore/QFileInfo>
+#include <atomic>
+#include <mutex>
+
+// 传输统计登记在指标注册表里，浏览器的统计面板和命令行导出直接读取
+static MetricCounter* const s_bytesReceived = metrics_counter("net.bytes_received");
+static MetricCounter* const s_failedTransfers = metrics_counter("net.failures");
+static MetricCounter* const s_requests = metrics_counter("net.requests");
+static MetricGauge* const s_activeTransfers = metrics_gauge("net.active_transfers");
+
+qint64 transfer_bytes_total()
+{
+    return s_bytesReceived->value();
+}
+
+qint64 transfer_failures_total()
+{
+    return s_failedTransfers->value();
+}
+
+// 404 之类是资源本身的问题，不代表链路拥塞
+static void record_transfer_result(CURLcode res, long http_code)
+{
+    if (res != CURLE_OK || http_code == 429 || http_code >= 500)
+        s_failedTransfers->add();
+}
+
+// 按主机记请求耗时（整个请求）和首字节时间（握手 + 服务端处理），单位微秒
+static void record_request_metrics(CURL* curl, const QUrl& url)
+{
+    curl_off_t startTransfer = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    const QString host = url.host().isEmpty() ? QString("unknown") : url.host();
+    if (MetricHistogram* latency = metrics_histogram("net.request_us." + host))
+        latency->record(qint64(total));
+    if (startTransfer > 0) {
+        if (MetricHistogram* ttfb = metrics_histogram("net.ttfb_us." + host))
+            ttfb->record(qint64(startTransfer));
+    }
+}
+
+// curl_easy_perform 期间计入正在进行的传输
+static CURLcode perform_counted(CURL* curl, const QUrl& url)
+{
+    s_requests->add();
+    s_activeTransfers->add(1);
+    const CURLcode res = curl_easy_perform(curl);
+    s_activeTransfers->add(-1);
+    record_request_metrics(curl, url);
+    return res;
+}
+
+// 开启 trace 时累计本线程当前传输花在写盘上的时间（curl 在调用 perform 的线程里回调）
+static thread_local qint64 s_traceWriteNs = 0;
 
 // --- 1. 通用回调 (核心技巧) ---
 // 无论是存文件还是存内存，都把 stream 强转为 QIODevice
 static size_t write_callback(void* ptr, size_t size, size_t nmemb, void* stream) {
     QIODevice* device = static_cast<QIODevice*>(stream);
     if (device && device->isWritable()) {
-        return device->write(static_cast<const char*>(ptr), size * nmemb);
+        const qint64 traceStart = trace_enabled() ? trace_now_ns() : -1;
+        qint64 written = device->write(static_cast<const char*>(ptr), size * nmemb);
+        if (traceStart >= 0)
+            s_traceWriteNs += trace_now_ns() - traceStart;
+        if (written > 0)
+            s_bytesReceived->add(written);
+        return written;
     }
     return 0;
 }
 
+// --- 共享句柄：所有下载线程的 easy handle 共用 DNS 缓存和 TLS 会话 ---
+// 连接缓存不共享：libcurl 不支持多个线程上同时运行的 easy handle 共用连接池；连接复用见 acquire_curl
+static std::mutex s_shareLocks[CURL_LOCK_DATA_LAST];
+
+static void share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr) {
+    Q_UNUSED(handle); Q_UNUSED(access); Q_UNUSED(userptr);
+    s_shareLocks[data].lock();
+}
+
+static void share_unlock(CURL* handle, curl_lock_data data, void* userptr) {
+    Q_UNUSED(handle); Q_UNUSED(userptr);
+    s_shareLocks[data].unlock();
+}
+
+static CURLSH* shared_handle() {
+    // 进程生命周期内只建一次，不释放
+    static CURLSH* share = []() {
+        CURLSH* sh = curl_share_init();
+        if (sh) {
+            curl_share_setopt(sh, CURLSHOPT_LOCKFUNC, share_lock);
+            curl_share_setopt(sh, CURLSHOPT_UNLOCKFUNC, share_unlock);
+            curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+        return sh;
+    }();
+    return share;
+}
+
+// --- 每个线程复用一个 easy handle ---
+// easy handle 自带连接缓存：curl_easy_reset 只清选项，连接保留。
+// 同一资产的几十张贴图都发往同一个 CDN 主机，池线程接连下载时省掉每个文件的 TCP/TLS 握手
+struct ThreadCurlHandle {
+    CURL* handle = nullptr;
+    ~ThreadCurlHandle() {
+        if (handle)
+            curl_easy_cleanup(handle);
+    }
+};
+
+static CURL* acquire_curl() {
+    static thread_local ThreadCurlHandle local;
+    if (!local.handle)
+        local.handle = curl_easy_init();
+    else
+        curl_easy_reset(local.handle);
+    return local.handle;
+}
+
+// --- trace：把一次 perform 按 libcurl 的分段计时拆成 dns / connect / tls / wait / transfer，另加累计的写盘时间 ---
+// 分段时间都是相对 perform 开始的累计微秒；连接复用时前几段为 0，不记录
+static void trace_curl_phases(CURL* curl, const TraceSpan& span) {
+    if (!span.active())
+        return;
+    const QString& detail = span.detail();
+    const qint64 performEnd = trace_now_ns();
+    const qint64 performStart = span.startNs();
+    curl_off_t nameLookup = 0, connect = 0, appConnect = 0, startTransfer = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    auto phase = [&](const char* name, curl_off_t from, curl_off_t to) {
+        if (to > from)
+            trace_record(name, "net", performStart + qint64(from) * 1000, performStart + qint64(to) * 1000, detail);
+    };
+    phase("dns", 0, nameLookup);
+    phase("connect", nameLookup, connect);
+    phase("tls", connect, appConnect);
+    const curl_off_t requestSent = qMax(connect, appConnect);
+    phase("wait", requestSent, startTransfer);
+    phase("transfer", startTransfer, total);
+
+    // 写盘穿插在 transfer 里，只知道总量：画在传输末尾
+    if (s_traceWriteNs > 0)
+        trace_record("write", "disk", performEnd - s_traceWriteNs, performEnd, detail);
+}
+
 // --- 内部通用配置函数 (减少重复代码) ---
 void setup_curl_common(CURL* curl, const char* url, QIODevice* device) {
     curl_easy_setopt(curl, CURLOPT_URL, url);
@@ -21,11 +164,16 @@ void setup_curl_common(CURL* curl, const char* url, QIODevice* device) {
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+
+    // 连接复用
+    if (CURLSH* share = shared_handle())
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 }
 
 // --- 2. GET: 获取小数据 (JSON/文本) ---
 QByteArray get(const QUrl& url) {
-    CURL* curl = curl_easy_init();
+    CURL* curl = acquire_curl();
     QByteArray data;
 
     if (curl) {
@@ -38,21 +186,46 @@ QByteArray get(const QUrl& url) {
 
         setup_curl_common(curl, urlBytes.constData(), &buffer);
 
-        CURLcode res = curl_easy_perform(curl);
+        TraceSpan span("get", "net", [&] { return url.path(); });
+        s_traceWriteNs = 0;
+        CURLcode res = perform_counted(curl, url);
+        trace_curl_phases(curl, span);
+        span.setBytes(data.size());
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        record_transfer_result(res, http_code);
         if (res != CURLE_OK) {
             qWarning() << "GET Error:" << curl_easy_strerror(res);
             data.clear();
         }
 
-        curl_easy_cleanup(curl);
         buffer.close();
     }
     return data;
 }
 
+// --- 进度回调：把 curl 的累计字节数换算成增量交给调用方 ---
+struct ProgressContext {
+    const TransferProgressFn* fn;
+    curl_off_t last;
+};
+
+static int xferinfo_callback(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    Q_UNUSED(dltotal); Q_UNUSED(ultotal); Q_UNUSED(ulnow);
+    ProgressContext* ctx = static_cast<ProgressContext*>(clientp);
+    qint64 delta = qint64(dlnow - ctx->last);
+    ctx->last = dlnow;
+    // 返回非 0 让 curl 以 CURLE_ABORTED_BY_CALLBACK 结束
+    return (*ctx->fn)(delta) ? 0 : 1;
+}
+
 // --- 3. DOWNLOAD: 下载大文件 (流式写入硬盘) ---
 bool download_file(const QUrl& url, const QString& dest) {
-    CURL* curl = curl_easy_init();
+    return download_file(url, dest, TransferProgressFn());
+}
+
+bool download_file(const QUrl& url, const QString& dest, const TransferProgressFn& progress) {
+    CURL* curl = acquire_curl();
     bool success = false;
 
     if (curl) {
@@ -63,13 +236,27 @@ bool download_file(const QUrl& url, const QString& dest) {
 
             setup_curl_common(curl, urlBytes.constData(), &file);
 
-            CURLcode res = curl_easy_perform(curl);
+            ProgressContext ctx{ &progress, 0 };
+            if (progress) {
+                curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, xferinfo_callback);
+                curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &ctx);
+                curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            }
+
+            TraceSpan span("download_file", "net", [&] { return QFileInfo(dest).fileName(); });
+            s_traceWriteNs = 0;
+            CURLcode res = perform_counted(curl, url);
+            trace_curl_phases(curl, span);
+            if (span.active())
+                span.setBytes(file.size());
 
             long http_code = 0;
             curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            record_transfer_result(res, http_code);
 
             if (res == CURLE_OK && http_code == 200) {
                 qInfo() << "下载成功";
+                success = true;
             }
             else {
                 qWarning() << "下载失败，HTTP代码:" << http_code;
@@ -81,7 +268,56 @@ bool download_file(const QUrl& url, const QString& dest) {
         else {
             qCritical() << "Cannot open file:" << dest;
         }
-        curl_easy_cleanup(curl);
     }
     return success;
+}
+
+bool download_file_resumable(const QUrl& url, const QString& dest, const TransferProgressFn& progress, qint64 resumeFrom) {
+    CURL* curl = acquire_curl();
+    if (!curl)
+        return false;
+
+    QFile file(dest);
+    // 续传时追加，否则从头写
+    const QIODevice::OpenMode mode = resumeFrom > 0 ? (QIODevice::WriteOnly | QIODevice::Append) : QIODevice::WriteOnly;
+    if (!file.open(mode)) {
+        qCritical() << "Cannot open file:" << dest;
+        return false;
+    }
+
+    QByteArray urlBytes = url.toEncoded();
+    setup_curl_common(curl, urlBytes.constData(), &file);
+    // 错误页不能追加进已下好的部分
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    if (resumeFrom > 0)
+        curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, curl_off_t(resumeFrom));
+
+    ProgressContext ctx{ &progress, 0 };
+    if (progress) {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, xferinfo_callback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &ctx);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    TraceSpan span("download_file_resumable", "net", [&] { return QFileInfo(dest).fileName(); });
+    s_traceWriteNs = 0;
+    CURLcode res = perform_counted(curl, url);
+    trace_curl_phases(curl, span);
+    if (span.active())
+        span.setBytes(file.size() - qMax<qint64>(resumeFrom, 0));
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    record_transfer_result(res, http_code);
+    file.close();
+
+    if (res == CURLE_OK && (http_code == 200 || http_code == 206))
+        return true;
+
+    // 服务器忽略 Range，或资源本身出错（404、416 等 4xx）：已有部分不可信，下次从头下；
+    // 429 / 5xx 与网络错误一样是暂时的，保留
+    qWarning() << "下载失败，HTTP代码:" << http_code << curl_easy_strerror(res);
+    const bool resourceError = res == CURLE_HTTP_RETURNED_ERROR && http_code >= 400 && http_code < 500 && http_code != 429;
+    if (res == CURLE_RANGE_ERROR || resourceError)
+        file.remove();
+    return false;
 }
\ No newline at end of file
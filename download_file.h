@@ -10,6 +10,7 @@
 #include <QtCore/qstring.h>
 #include <QtCore/qbytearray.h>
 #include <QtCore/qiodevice.h>
+#include <functional>
 //#include <stdio.h>
 //#include <iostream>
 
@@ -21,3 +22,19 @@ QByteArray get(const QUrl& url);
 
 bool download_file(const QUrl& url, const QString& dest);
 
+// 下载进度回调：参数为自上次回调以来新收到的字节数；返回 false 中止下载
+using TransferProgressFn = std::function<bool(qint64 deltaBytes)>;
+
+// 带进度回调的下载（回调在下载线程中执行）
+bool download_file(const QUrl& url, const QString& dest, const TransferProgressFn& progress);
+
+// 可续传的下载：从 resumeFrom 字节处追加（Range 请求）；
+// 网络中断、超时、取消时保留已写入的部分供下次续传，服务器不支持续传或返回错误状态码时删除
+bool download_file_resumable(const QUrl& url, const QString& dest, const TransferProgressFn& progress, qint64 resumeFrom);
+
+// 进程内累计的传输统计（下载调度器据此调整并发）
+// 已接收的字节数
+qint64 transfer_bytes_total();
+// 拥塞类失败次数：连接/超时等 curl 错误，以及 HTTP 429 / 5xx
+qint64 transfer_failures_total();
+
@@ -0,0 +1,252 @@
+﻿#include "download_scheduler.h"
+#include "download_file.h"
+#include "metrics.h"
+#include <algorithm>
+#include <iterator>
+
+// 默认阶段上限：元数据与缩略图都是几十 KB 的请求，大文件最多占窗口的一部分。
+// 本体原先固定 2 个名额；总并发改由 AIMD 窗口控制后，2 个名额会让窗口在带宽充足时也长不上去，
+// 放宽到 6，限流或拥塞时窗口减半自然会压下来
+static const int DEFAULT_STAGE_LIMITS[int(DownloadStage::Count)] = { 8, 8, 6 };
+static const int DEFAULT_CONCURRENCY_FLOOR = 2;
+static const int DEFAULT_CONCURRENCY_CEILING = 16;
+// runDetached 任务（列表请求、校验、预算淘汰、按需拉回的规划）的线程数
+static const int DETACHED_THREADS = 4;
+
+DownloadScheduler::DownloadScheduler()
+    : m_floor(DEFAULT_CONCURRENCY_FLOOR)
+    , m_ceiling(DEFAULT_CONCURRENCY_CEILING)
+    , m_window(DEFAULT_CONCURRENCY_FLOOR * 2)
+{
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        m_running[s] = 0;
+        m_limits[s] = DEFAULT_STAGE_LIMITS[s];
+    }
+    m_pool.setMaxThreadCount(m_ceiling);
+    m_detachedPool.setMaxThreadCount(DETACHED_THREADS);
+    m_sampleTimer.start();
+    m_lastBytes = transfer_bytes_total();
+    m_lastFailures = transfer_failures_total();
+}
+
+DownloadScheduler::~DownloadScheduler()
+{
+    QMutexLocker locker(&m_mutex);
+    m_shuttingDown = true;
+    for (QQueue<Job>& queue : m_queues) {
+        for (const Job& job : queue) {
+            if (job.task->autoDelete())
+                delete job.task;
+        }
+        queue.clear();
+    }
+    while (std::any_of(std::begin(m_running), std::end(m_running), [](int n) { return n > 0; }))
+        m_idle.wait(&m_mutex);
+    locker.unlock();
+    m_pool.waitForDone();
+    m_detachedPool.waitForDone();
+}
+
+void DownloadScheduler::setStageLimit(DownloadStage stage, int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits[int(stage)] = qMax(1, limit);
+    pumpLocked();
+}
+
+int DownloadScheduler::stageLimit(DownloadStage stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limits[int(stage)];
+}
+
+void DownloadScheduler::setConcurrencyBounds(int floor, int ceiling)
+{
+    QMutexLocker locker(&m_mutex);
+    m_floor = qMax(1, floor);
+    m_ceiling = qMax(m_floor, ceiling);
+    m_window = qBound(m_floor, m_window, m_ceiling);
+    m_pool.setMaxThreadCount(m_ceiling);
+    pumpLocked();
+}
+
+int DownloadScheduler::concurrencyFloor() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_floor;
+}
+
+int DownloadScheduler::concurrencyCeiling() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ceiling;
+}
+
+int DownloadScheduler::window() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_window;
+}
+
+void DownloadScheduler::enqueue(DownloadStage stage, const QString& slug, QRunnable* task, qint64 cost)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_shuttingDown) {
+        if (task->autoDelete())
+            delete task;
+        return;
+    }
+    Job job;
+    job.slug = slug;
+    job.task = task;
+    job.cost = cost;
+    job.boosted = m_boosted.contains(slug);
+    QQueue<Job>& queue = m_queues[int(stage)];
+    if (job.boosted) {
+        queue.prepend(job);
+    }
+    else {
+        // 从队尾往前找插入点：代价相同的保持先来先出（全为 0 时即普通 FIFO）
+        qsizetype pos = queue.size();
+        while (pos > 0 && !queue[pos - 1].boosted && queue[pos - 1].cost > cost)
+            --pos;
+        queue.insert(pos, job);
+    }
+    pumpLocked();
+}
+
+void DownloadScheduler::boost(const QString& slug)
+{
+    QMutexLocker locker(&m_mutex);
+    m_boosted.insert(slug);
+    for (QQueue<Job>& queue : m_queues) {
+        // 最近一次提权的资产排在最前面
+        QQueue<Job> moved;
+        for (auto it = queue.begin(); it != queue.end();) {
+            if (it->slug == slug) {
+                it->boosted = true;
+                moved.append(*it);
+                it = queue.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+        if (!moved.isEmpty())
+            queue = moved + queue;
+    }
+    pumpLocked();
+}
+
+int DownloadScheduler::pendingCount(DownloadStage stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queues[int(stage)].size();
+}
+
+int DownloadScheduler::runningCount(DownloadStage stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running[int(stage)];
+}
+
+void DownloadScheduler::runDetached(std::function<void()> fn)
+{
+    m_detachedPool.start(std::move(fn));
+}
+
+int DownloadScheduler::totalRunningLocked() const
+{
+    int total = 0;
+    for (int n : m_running)
+        total += n;
+    return total;
+}
+
+// 持锁调用：每个采样周期按吞吐和失败数调整一次窗口
+void DownloadScheduler::adaptLocked()
+{
+    const qint64 elapsedMs = m_sampleTimer.elapsed();
+    if (elapsedMs < SAMPLE_INTERVAL_MS)
+        return;
+
+    const qint64 bytes = transfer_bytes_total();
+    const qint64 failures = transfer_failures_total();
+    const double throughput = double(bytes - m_lastBytes) * 1000.0 / double(elapsedMs);
+
+    if (failures > m_lastFailures) {
+        // 乘性减：链路已经拥塞或服务端在限流
+        m_window = qMax(m_floor, m_window / 2);
+    }
+    else if (m_peakRunning >= m_window && throughput >= m_lastThroughput * 0.9) {
+        // 加性增：窗口已跑满且加线程没有拖慢吞吐
+        m_window = qMin(m_ceiling, m_window + 1);
+    }
+
+    m_lastBytes = bytes;
+    m_lastFailures = failures;
+    m_lastThroughput = throughput;
+    m_peakRunning = totalRunningLocked();
+    m_sampleTimer.restart();
+
+    // 每个采样周期同步一次到指标，供统计面板对照吞吐调并发上下界
+    static MetricGauge* const windowGauge = metrics_gauge("scheduler.window");
+    static MetricGauge* const runningGauge = metrics_gauge("scheduler.running");
+    windowGauge->set(m_window);
+    runningGauge->set(m_peakRunning);
+}
+
+void DownloadScheduler::unboost(const QString& slug)
+{
+    QMutexLocker locker(&m_mutex);
+    m_boosted.remove(slug);
+}
+
+// 持锁调用：按阶段优先级把空位补满
+void DownloadScheduler::pumpLocked()
+{
+    if (m_shuttingDown)
+        return;
+    int total = totalRunningLocked();
+
+    // 1. 提权任务只受 ceiling 约束
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        while (total < m_ceiling && !m_queues[s].isEmpty() && m_queues[s].head().boosted) {
+            startLocked(s);
+            ++total;
+        }
+    }
+
+    // 2. 后台任务同时受阶段上限和 AIMD 窗口约束
+    for (int s = 0; s < STAGE_COUNT && total < m_window; ++s) {
+        while (total < m_window && m_running[s] < m_limits[s] && !m_queues[s].isEmpty()) {
+            startLocked(s);
+            ++total;
+        }
+    }
+    m_peakRunning = qMax(m_peakRunning, total);
+}
+
+// 持锁调用：取出 stage 队首任务投递到线程池
+void DownloadScheduler::startLocked(int stage)
+{
+    Job job = m_queues[stage].dequeue();
+    ++m_running[stage];
+    QRunnable* task = job.task;
+    // 提权任务在线程池内部也排到最前
+    const int priority = job.boosted ? STAGE_COUNT : STAGE_COUNT - 1 - stage;
+    m_pool.start([this, stage, task]() { runTask(stage, task); }, priority);
+}
+
+void DownloadScheduler::runTask(int stage, QRunnable* task)
+{
+    task->run();
+    if (task->autoDelete())
+        delete task;
+
+    QMutexLocker locker(&m_mutex);
+    --m_running[stage];
+    adaptLocked();
+    pumpLocked();
+    m_idle.wakeAll();
+}
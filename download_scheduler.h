@@ -0,0 +1,121 @@
+﻿#ifndef DOWNLOAD_SCHEDULER_H
+#define DOWNLOAD_SCHEDULER_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qset.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtCore/qrunnable.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qelapsedtimer.h>
+#include <functional>
+
+// 单个资产的下载阶段（数值即调度优先级，越小越先）
+enum class DownloadStage {
+    Metadata = 0,   // /files 清单 -> info.json
+    Thumbnail,      // 缩略图
+    Payload,        // hdri/贴图/模型本体
+    Count
+};
+
+/**
+ * 分阶段下载调度器
+ * 每个阶段一条独立的 FIFO 队列和并发上限：大文件最多占 Payload 的名额，
+ * 不会堵住元数据和缩略图这类小请求；有空位时总是先从优先级高的阶段取任务。
+ * 任务跑在调度器私有的线程池上，不改动 Houdini 与其他插件共用的 QThreadPool::globalInstance()。
+ * 总并发由 AIMD 窗口控制：吞吐不降且窗口跑满时每个采样周期 +1，
+ * 出现拥塞类失败（超时 / 429 / 5xx）时减半，始终夹在 [floor, ceiling] 之间。
+ * 用户正在看/拖的资产可以被提权：其排队任务移到各队列最前，并且只受 ceiling 约束，
+ * 不再等阶段名额和 AIMD 窗口。
+ */
+class DownloadScheduler
+{
+public:
+    DownloadScheduler();
+
+    /** 丢弃尚未开始的任务并等待正在运行的任务结束 */
+    ~DownloadScheduler();
+
+    void setStageLimit(DownloadStage stage, int limit);
+    int stageLimit(DownloadStage stage) const;
+
+    /**
+     * 设置总并发的上下界（AIMD 窗口在其间自适应）
+     * @param floor 最少同时进行的任务数（至少 1）
+     * @param ceiling 最多同时进行的任务数（不小于 floor，也是私有线程池的线程数）
+     */
+    void setConcurrencyBounds(int floor, int ceiling);
+    int concurrencyFloor() const;
+    int concurrencyCeiling() const;
+
+    /** 当前 AIMD 窗口（同时进行的任务上限） */
+    int window() const;
+
+    /**
+     * 入队，有空位时立即开始
+     * @param stage 所属阶段
+     * @param slug 任务所属资产（用于提权）
+     * @param task 任务（autoDelete 时运行结束后由调度器释放）
+     * @param cost 排序代价（如文件字节数）；同一队列内代价小的先出，相同代价保持 FIFO
+     */
+    void enqueue(DownloadStage stage, const QString& slug, QRunnable* task, qint64 cost = 0);
+
+    /**
+     * 提权：把该资产所有排队中的任务移到队首；之后才入队的阶段（如本体）同样插队，
+     * 直到 unboost 为止
+     * @param slug 资产 slug
+     */
+    void boost(const QString& slug);
+
+    /** 资产全部阶段结束后撤销提权 */
+    void unboost(const QString& slug);
+
+    int pendingCount(DownloadStage stage) const;
+    int runningCount(DownloadStage stage) const;
+
+    /**
+     * 在另一个私有线程池上运行不参与阶段计数的任务（如资产列表请求、校验）
+     * 与阶段任务分开：长时间运行的任务不会占住窗口已经计入的线程
+     */
+    void runDetached(std::function<void()> fn);
+
+private:
+    static const int STAGE_COUNT = int(DownloadStage::Count);
+    static const qint64 SAMPLE_INTERVAL_MS = 1000;
+
+    QThreadPool m_pool;                     // 阶段任务，线程数即 ceiling
+    QThreadPool m_detachedPool;             // runDetached 任务
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    struct Job {
+        QString slug;
+        QRunnable* task = nullptr;
+        qint64 cost = 0;
+        bool boosted = false;
+    };
+
+    QQueue<Job> m_queues[STAGE_COUNT];      // 提权任务总在队首，其余按 cost 升序
+    QSet<QString> m_boosted;                // 已提权、尚未结束的资产
+    int m_running[STAGE_COUNT];
+    int m_limits[STAGE_COUNT];
+    bool m_shuttingDown = false;
+
+    // AIMD 状态（全部受 m_mutex 保护）
+    int m_floor;
+    int m_ceiling;
+    int m_window;
+    int m_peakRunning = 0;           // 本采样周期内的最大并发，判断窗口是否跑满
+    QElapsedTimer m_sampleTimer;
+    qint64 m_lastBytes = 0;
+    qint64 m_lastFailures = 0;
+    double m_lastThroughput = 0.0;   // 字节/秒
+
+    int totalRunningLocked() const;
+    void adaptLocked();
+    void pumpLocked();
+    void startLocked(int stage);
+    void runTask(int stage, QRunnable* task);
+};
+
+#endif // DOWNLOAD_SCHEDULER_H
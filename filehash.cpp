@@ -2,40 +2,311 @@
 #include <QtCore/QFile>
 #include <QtCore/QCryptographicHash>
 #include <QtCore/QDebug>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QtEndian>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 
-// 分块大小：与 Python 一致（8192 字节），平衡性能和内存占用
-static const qint64 CHUNK_SIZE = 8192;
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-QString filehash(const QString& filePath) {
-    // 打开文件（只读 + 二进制模式，与 Python 的 "rb" 一致）
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {  // Unbuffered 减少额外内存开销
-        qWarning() << "[filehash] Failed to open file for reading:" << filePath
-            << "Error:" << file.errorString();
-        return "";
+// 单文件调用的缓冲区：每次调用分配一次，不像批量那样长期占用 4 MB
+static const qint64 SINGLE_BUFFER_SIZE = 1024 * 1024;
+
+/* ---------- XXH64（按官方算法实现的流式版本） ---------- */
+namespace {
+
+const quint64 XXH_PRIME1 = 11400714785074694791ULL;
+const quint64 XXH_PRIME2 = 14029467366897019727ULL;
+const quint64 XXH_PRIME3 = 1609587929392839161ULL;
+const quint64 XXH_PRIME4 = 9650029242287828579ULL;
+const quint64 XXH_PRIME5 = 2870177450012600261ULL;
+
+inline quint64 xxh_rotl(quint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline quint64 xxh_read64(const uchar* p)
+{
+    quint64 v;
+    std::memcpy(&v, p, 8);
+    return qFromLittleEndian(v);
+}
+
+inline quint32 xxh_read32(const uchar* p)
+{
+    quint32 v;
+    std::memcpy(&v, p, 4);
+    return qFromLittleEndian(v);
+}
+
+inline quint64 xxh_round(quint64 acc, quint64 input)
+{
+    acc += input * XXH_PRIME2;
+    acc = xxh_rotl(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+inline quint64 xxh_merge_round(quint64 acc, quint64 val)
+{
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+class XxHash64
+{
+public:
+    explicit XxHash64(quint64 seed = 0)
+        : m_seed(seed)
+    {
+        m_acc[0] = seed + XXH_PRIME1 + XXH_PRIME2;
+        m_acc[1] = seed + XXH_PRIME2;
+        m_acc[2] = seed;
+        m_acc[3] = seed - XXH_PRIME1;
     }
 
-    // 初始化 MD5 哈希计算器（Qt 原生支持，与 Python hashlib.md5 一致）
-    QCryptographicHash hash(QCryptographicHash::Md5);
-    hash.reset();  // 确保初始状态干净
+    void addData(const char* data, qint64 size)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(data);
+        size_t len = size_t(size);
+        m_total += len;
 
-    // 分块读取文件并更新哈希（内存高效）
-    QByteArray chunk;
-    while (!(chunk = file.read(CHUNK_SIZE)).isEmpty()) {
-        hash.addData(chunk);  // 每次添加 8192 字节的块
+        if (m_memSize + len < 32) {
+            std::memcpy(m_mem + m_memSize, p, len);
+            m_memSize += len;
+            return;
+        }
+        if (m_memSize > 0) {
+            const size_t fill = 32 - m_memSize;
+            std::memcpy(m_mem + m_memSize, p, fill);
+            consume(m_mem);
+            p += fill;
+            len -= fill;
+            m_memSize = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32)
+            consume(p);
+        if (len > 0) {
+            std::memcpy(m_mem, p, len);
+            m_memSize = len;
+        }
     }
 
-    // 检查读取过程中是否出错
-    if (file.error() != QFile::NoError) {
-        qWarning() << "[filehash] Error reading file:" << filePath
-            << "Error:" << file.errorString();
-        file.close();
+    quint64 result() const
+    {
+        quint64 h;
+        if (m_total >= 32) {
+            h = xxh_rotl(m_acc[0], 1) + xxh_rotl(m_acc[1], 7) + xxh_rotl(m_acc[2], 12) + xxh_rotl(m_acc[3], 18);
+            for (quint64 acc : m_acc)
+                h = xxh_merge_round(h, acc);
+        }
+        else {
+            h = m_seed + XXH_PRIME5;
+        }
+        h += m_total;
+
+        const uchar* p = m_mem;
+        size_t len = m_memSize;
+        for (; len >= 8; p += 8, len -= 8) {
+            h ^= xxh_round(0, xxh_read64(p));
+            h = xxh_rotl(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+        }
+        if (len >= 4) {
+            h ^= quint64(xxh_read32(p)) * XXH_PRIME1;
+            h = xxh_rotl(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+            p += 4;
+            len -= 4;
+        }
+        for (; len > 0; ++p, --len) {
+            h ^= quint64(*p) * XXH_PRIME5;
+            h = xxh_rotl(h, 11) * XXH_PRIME1;
+        }
+
+        h ^= h >> 33;
+        h *= XXH_PRIME2;
+        h ^= h >> 29;
+        h *= XXH_PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    void consume(const uchar* p)
+    {
+        m_acc[0] = xxh_round(m_acc[0], xxh_read64(p));
+        m_acc[1] = xxh_round(m_acc[1], xxh_read64(p + 8));
+        m_acc[2] = xxh_round(m_acc[2], xxh_read64(p + 16));
+        m_acc[3] = xxh_round(m_acc[3], xxh_read64(p + 24));
+    }
+
+    quint64 m_seed;
+    quint64 m_acc[4];
+    quint64 m_total = 0;
+    uchar m_mem[32];
+    size_t m_memSize = 0;
+};
+
+/* ---------- 顺序读：带预读提示的原生文件句柄 ---------- */
+class SequentialReader
+{
+public:
+    SequentialReader(const QString& filePath, bool dropCache)
+        : m_dropCache(dropCache)
+    {
+#ifdef Q_OS_WIN
+        m_handle = CreateFileW(reinterpret_cast<LPCWSTR>(filePath.utf16()), GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+#else
+        m_fd = ::open(QFile::encodeName(filePath).constData(), O_RDONLY | O_CLOEXEC);
+#if defined(Q_OS_LINUX)
+        if (m_fd >= 0)
+            posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(Q_OS_MACOS)
+        if (m_fd >= 0)
+            fcntl(m_fd, F_RDAHEAD, 1);
+#endif
+#endif
+    }
+
+    ~SequentialReader()
+    {
+#ifdef Q_OS_WIN
+        if (m_handle != INVALID_HANDLE_VALUE)
+            CloseHandle(m_handle);
+#else
+        if (m_fd >= 0) {
+#if defined(Q_OS_LINUX)
+            // 只读一遍的数据不留在页缓存里
+            if (m_dropCache)
+                posix_fadvise(m_fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+            ::close(m_fd);
+        }
+#endif
+    }
+
+    SequentialReader(const SequentialReader&) = delete;
+    SequentialReader& operator=(const SequentialReader&) = delete;
+
+    bool isOpen() const
+    {
+#ifdef Q_OS_WIN
+        return m_handle != INVALID_HANDLE_VALUE;
+#else
+        return m_fd >= 0;
+#endif
+    }
+
+    /** @return 读到的字节数，0 表示结束，-1 表示出错 */
+    qint64 read(char* data, qint64 maxSize)
+    {
+#ifdef Q_OS_WIN
+        DWORD n = 0;
+        if (!ReadFile(m_handle, data, DWORD(qMin<qint64>(maxSize, 0x7fffffff)), &n, nullptr))
+            return -1;
+        return qint64(n);
+#else
+        for (;;) {
+            const ssize_t n = ::read(m_fd, data, size_t(maxSize));
+            if (n < 0 && errno == EINTR)
+                continue;
+            return qint64(n);
+        }
+#endif
+    }
+
+private:
+    bool m_dropCache;
+#ifdef Q_OS_WIN
+    HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace
+
+quint64 xxhash64(const char* data, qint64 size, quint64 seed)
+{
+    XxHash64 hash(seed);
+    hash.addData(data, size);
+    return hash.result();
+}
+
+QString filehash(const QString& filePath) {
+    // 整个文件复用同一块缓冲区，不再每 8 KB 分配一个 QByteArray
+    QByteArray buffer(SINGLE_BUFFER_SIZE, Qt::Uninitialized);
+    return filehash(filePath, HashAlgorithm::Md5, buffer);
+}
+
+QString filehash(const QString& filePath, QByteArray& buffer) {
+    return filehash(filePath, HashAlgorithm::Md5, buffer);
+}
+
+QString filehash(const QString& filePath, HashAlgorithm algorithm, QByteArray& buffer, bool dropCache) {
+    SequentialReader reader(filePath, dropCache);
+    if (!reader.isOpen()) {
+        qWarning() << "[filehash] Failed to open file for reading:" << filePath;
         return "";
     }
+    if (buffer.isEmpty())
+        buffer.resize(HASH_BUFFER_SIZE);
 
-    // 关闭文件
-    file.close();
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    XxHash64 xxh;
+    qint64 n = 0;
+    while ((n = reader.read(buffer.data(), buffer.size())) > 0) {
+        if (algorithm == HashAlgorithm::Md5)
+            md5.addData(QByteArrayView(buffer.constData(), n));
+        else
+            xxh.addData(buffer.constData(), n);
+    }
+    if (n < 0) {
+        qWarning() << "[filehash] Error reading file:" << filePath;
+        return "";
+    }
 
     // 生成哈希字符串（小写，与 Python 的 hexdigest() 一致）
-    return hash.result().toHex().toLower();
-}
\ No newline at end of file
+    if (algorithm == HashAlgorithm::Md5)
+        return md5.result().toHex().toLower();
+    return QString("%1").arg(xxh.result(), 16, 16, QChar('0'));
+}
+
+QStringList filehash_batch(const QStringList& filePaths, HashAlgorithm algorithm, int threadCount,
+    const FileHashProgressFn& progress)
+{
+    const int total = filePaths.size();
+    QVector<QString> digests(total);
+    if (total == 0)
+        return QStringList();
+
+    const int threads = qMin(total, threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount()));
+    std::atomic<int> next{ 0 };
+    std::atomic<int> done{ 0 };
+    std::atomic<bool> cancelled{ false };
+    QString* out = digests.data();
+
+    // 独立线程池：不占用 globalInstance，也不和下载调度器抢线程
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int t = 0; t < threads; ++t) {
+        pool.start([&]() {
+            QByteArray buffer(HASH_BUFFER_SIZE, Qt::Uninitialized);
+            for (;;) {
+                const int i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= total || cancelled.load(std::memory_order_relaxed))
+                    break;
+                out[i] = filehash(filePaths[i], algorithm, buffer, true);
+                const int finished = done.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (progress && !progress(finished, total))
+                    cancelled.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+    pool.waitForDone();
+    return QStringList(digests.cbegin(), digests.cend());
+}
@@ -1,11 +1,16 @@
 ﻿#include "get_asset_lib.h"
 #include <QtCore/qfile.h>
 #include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonarray.h>
 #include <QtCore/QJsonParseError>
 #include <QtCore/qdir.h>
 #include <QtCore/qfileinfo.h>
 #include <QtCore/qdebug.h>
-#include "startwindow.h"
+#include <QtCore/qmutex.h>
+
+// 资产库路径：界面线程写，拉取线程 / 线程池读
+static QMutex s_assetLibMutex;
+static QString s_assetLibPath;
 
 
 
@@ -33,10 +38,22 @@ static QList<int> jsonIntArrayToList(const QJsonArray& arr)
     return list;
 }
 
-// 实现全局函数：获取资产库根路径（需根据实际项目修改逻辑）
+// 实现全局函数：获取资产库根路径
 QString get_asset_lib_path()
 {
-    return StartWindow::s_lastPath;
+    QMutexLocker locker(&s_assetLibMutex);
+    return s_assetLibPath;
+}
+
+void set_asset_lib_path(const QString& path)
+{
+    QMutexLocker locker(&s_assetLibMutex);
+    s_assetLibPath = path;
+}
+
+QString load_asset_lib_path(const QSettings& settings)
+{
+    return settings.value(SETTINGS_LIBRARY_PATH_KEY).toString();
 }
 
 
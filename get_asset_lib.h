@@ -5,7 +5,7 @@
 #include <QtCore/qstring.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qmap.h>
-#include "phaPullFromPolyhaven.h"
+#include <QtCore/qsettings.h>
 #include "constants.h"
 
 
@@ -17,12 +17,25 @@
 
 
 /**
- * 获取 Poly Haven 资产库路径（从 polyhaven_config.json 读取）
+ * 获取 Poly Haven 资产库路径（由 set_asset_lib_path 注入）
  * 对应 Python: get_asset_lib_path()
- * @return 资产库绝对路径（空字符串表示失败）
+ * @return 资产库绝对路径（空字符串表示未配置）
  */
 QString get_asset_lib_path();
 
+/**
+ * 注入资产库路径：浏览器在读取 / 更换路径时设置，命令行由参数或配置设置（线程安全）
+ * @param path 资产库绝对路径
+ */
+void set_asset_lib_path(const QString& path);
+
+/**
+ * 从配置读取上次使用的资产库路径（浏览器和命令行共用同一个键）
+ * @param settings 配置来源
+ * @return 资产库路径（未配置时为空）
+ */
+QString load_asset_lib_path(const QSettings& settings);
+
 /**
  * 获取资产列表缓存文件路径（asset_list_cache.json）
  * 对应 Python: asset_list_cache_path()
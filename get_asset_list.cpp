@@ -1,4 +1,7 @@
 ﻿#include "get_asset_list.h"
+#include "service_urls.h"
+#include "trace.h"
+#include "metrics.h"
 #include <QtCore/qdebug.h>
 
 // 外部常量声明（需在 constants.h 中定义）
@@ -11,6 +14,7 @@ extern const bool early_access;  // 对应 Python 中的 early_access（是否
 // -----------------------------------------------------------------------------
 QMap<QString, QJsonObject> get_asset_list(const QString& asset_type, bool force, QString& error)
 {
+    TraceSpan span("get_asset_list", "catalogue", asset_type);
     QMap<QString, QJsonObject> assetList;
     error.clear();
 
@@ -29,6 +33,8 @@ QMap<QString, QJsonObject> get_asset_list(const QString& asset_type, bool force,
 
         if (cacheAgeDays <= 7.0) {  // 缓存未过期（7天内）
             if (cacheFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                TraceSpan cacheSpan("read_cache", "catalogue");
+                cacheSpan.setBytes(cacheFile.size());
                 QJsonParseError jsonError;
                 QJsonDocument jsonDoc = QJsonDocument::fromJson(cacheFile.readAll(), &jsonError);
                 cacheFile.close();
@@ -52,58 +58,122 @@ QMap<QString, QJsonObject> get_asset_list(const QString& asset_type, bool force,
     }
 
     // 4. 从 API 获取数据
-    QString apiUrl = QString("https://api.polyhaven.com/assets?t=%1").arg(asset_type);
+    QByteArray jsonData = fetch_asset_list_raw(asset_type, error);
+    if (!error.isEmpty()) {
+        return assetList;
+    }
+
+    // 5. 解析 JSON
+    assetList = parse_asset_list_raw(jsonData, error);
+    if (!error.isEmpty()) {
+        return assetList;
+    }
+
+    // 6. 缓存数据到本地（原始字节直接落盘）
+    write_asset_list_cache(jsonData);
+
+    return assetList;
+}
+
+// -----------------------------------------------------------------------------
+// 只读缓存：不检查有效期，按类型过滤（缓存里可能是上次 "all" 的结果）
+// -----------------------------------------------------------------------------
+QMap<QString, QJsonObject> load_cached_asset_list(const QString& asset_type)
+{
+    QMap<QString, QJsonObject> assetList;
+
+    QFile cacheFile(QDir(get_asset_lib_path()).filePath("asset_list_cache.json"));
+    if (!cacheFile.exists() || !cacheFile.open(QIODevice::ReadOnly)) {
+        return assetList;
+    }
+
+    QJsonParseError jsonError;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(cacheFile.readAll(), &jsonError);
+    cacheFile.close();
+    if (jsonError.error != QJsonParseError::NoError || !jsonDoc.isObject()) {
+        return assetList;
+    }
+
+    // 对应 /assets 中的 type 字段：0:hdris 1:textures 2:models
+    int wantedType = -1;
+    if (asset_type == "hdris") wantedType = 0;
+    else if (asset_type == "textures") wantedType = 1;
+    else if (asset_type == "models") wantedType = 2;
+
+    QMap<QString, QJsonObject> all = parseAssetJson(jsonDoc.object());
+    for (auto it = all.constBegin(); it != all.constEnd(); ++it) {
+        if (wantedType < 0 || it.value().value("type").toInt() == wantedType) {
+            assetList.insert(it.key(), it.value());
+        }
+    }
+    return assetList;
+}
+
+// -----------------------------------------------------------------------------
+// 网络请求：只负责取回原始字节
+// -----------------------------------------------------------------------------
+QByteArray fetch_asset_list_raw(const QString& asset_type, QString& error)
+{
+    error.clear();
+
+    QString apiUrl = QString("%1/assets?t=%2").arg(api_base_url(), asset_type);
     if (early_access) {
         apiUrl += "&future=true";
     }
     LOG_DEBUG(QString("Getting asset list from %1").arg(apiUrl));
-    QUrl url = QString(apiUrl);
 
-    // 5. 发起 HTTPS 请求（WinHTTP 实现）
-    
-    QByteArray jsonData = get(url);
-    
-    
+    QByteArray jsonData = get(QUrl(apiUrl));
+    if (jsonData.isEmpty()) {
+        error = QString("Empty response from %1").arg(apiUrl);
+        LOG_ERROR(error);
+    }
+    return jsonData;
+}
+
+QMap<QString, QJsonObject> parse_asset_list_raw(const QByteArray& raw, QString& error)
+{
+    TraceSpan span("parse_asset_list", "catalogue");
+    span.setBytes(raw.size());
+    static MetricHistogram* const parseTime = metrics_histogram("catalogue.parse_us");
+    MetricTimer timer(parseTime);
+    error.clear();
 
-    // 6. 解析 JSON
     QJsonParseError json_error;
-    
-    QJsonDocument json_doc = QJsonDocument::fromJson(jsonData, &json_error);
+    QJsonDocument json_doc = QJsonDocument::fromJson(raw, &json_error);
 
-    
     if (json_error.error != QJsonParseError::NoError) {
         error = QString("JSON parse failed: %1 ")
             .arg(json_error.errorString());
-            
         LOG_ERROR(error);
-        return assetList;
+        return QMap<QString, QJsonObject>();
     }
 
     if (!json_doc.isObject()) {
         error = "API response is not a valid JSON object";
         LOG_ERROR(error);
-        return assetList;
+        return QMap<QString, QJsonObject>();
     }
 
-    QJsonObject jsonObj = json_doc.object();
-    assetList = parseAssetJson(jsonObj);
+    return parseAssetJson(json_doc.object());
+}
 
-    // 7. 缓存数据到本地
+bool write_asset_list_cache(const QByteArray& raw)
+{
+    QFileInfo cacheFileInfo(QDir(get_asset_lib_path()).filePath("asset_list_cache.json"));
     QDir cacheDir(cacheFileInfo.path());
     if (!cacheDir.exists()) {
         cacheDir.mkpath(".");
     }
 
-    if (cacheFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        cacheFile.write(json_doc.toJson(QJsonDocument::Indented));
-        cacheFile.close();
-        LOG_DEBUG("Asset list cached successfully");
-    }
-    else {
+    QFile cacheFile(cacheFileInfo.filePath());
+    if (!cacheFile.open(QIODevice::WriteOnly)) {
         LOG_ERROR(QString("Failed to write cache file: %1").arg(cacheFile.errorString()));
+        return false;
     }
-
-    return assetList;
+    cacheFile.write(raw);
+    cacheFile.close();
+    LOG_DEBUG("Asset list cached successfully");
+    return true;
 }
 
 // -----------------------------------------------------------------------------
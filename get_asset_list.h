@@ -1,7 +1,6 @@
 ﻿#ifndef GET_ASSET_LIST_H
 #define GET_ASSET_LIST_H
 
-#include "ui/phaPullFromPolyhaven.h"
 #include <QtCore/qmap.h>
 #include <QtCore/qdatetime.h>
 #include <QtCore/qjsondocument.h>
@@ -16,6 +15,7 @@
 
 //#include"AssetInfo.h"
 #include "abspath.h"
+#include "download_file.h"
 #include "get_asset_lib.h"
 #include "constants.h"
 
@@ -35,6 +35,35 @@ QMap<QString, QJsonObject> get_asset_list(const QString& asset_type = "all",
 
 QMap<QString, QJsonObject> parseAssetJson(const QJsonObject& jsonObj);
 
+/**
+ * 只读本地缓存的资产列表（不论是否过期，不发网络请求），并按资产类型过滤
+ * 供拉取流程在网络列表返回前先行派发已知资产
+ * @param asset_type 资产类型："all"/"hdris"/"textures"/"models"
+ * @return 资产列表；缓存不存在或损坏时为空
+ */
+QMap<QString, QJsonObject> load_cached_asset_list(const QString& asset_type = "all");
+
+/**
+ * 从 API 拉取资产列表原始 JSON（阻塞，调用方负责放到后台线程）
+ * @param asset_type 资产类型
+ * @param error 输出参数：错误信息（成功则为空）
+ * @return 响应原始字节
+ */
+QByteArray fetch_asset_list_raw(const QString& asset_type, QString& error);
+
+/**
+ * 解析资产列表原始 JSON
+ * @param raw fetch_asset_list_raw 的结果
+ * @param error 输出参数：错误信息（成功则为空）
+ */
+QMap<QString, QJsonObject> parse_asset_list_raw(const QByteArray& raw, QString& error);
+
+/**
+ * 将原始 JSON 原样写入 asset_list_cache.json（不再解析后重新缩进序列化）
+ * @return 是否写入成功
+ */
+bool write_asset_list_cache(const QByteArray& raw);
+
 
 
 #endif // GET_ASSET_LIST_H
\ No newline at end of file
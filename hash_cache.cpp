@@ -0,0 +1,129 @@
+﻿#include "hash_cache.h"
+#include "content_store.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qsavefile.h>
+
+// 缓存文件（放在资产库根目录）
+static const char* HASH_CACHE_FILE_NAME = ".hashcache.json";
+
+void HashCache::setLibraryPath(const QString& libraryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString root = libraryPath.isEmpty() ? QString() : QDir(libraryPath).absolutePath();
+    if (root == m_root)
+        return;
+    m_root = root;
+    m_entries.clear();
+    m_dirty = false;
+    if (m_root.isEmpty())
+        return;
+
+    QFile file(QDir(m_root).filePath(HASH_CACHE_FILE_NAME));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    // inode 可能超过 2^53（NTFS file index 高位带序号），按字符串存
+    const QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    for (auto it = json.constBegin(); it != json.constEnd(); ++it) {
+        const QJsonObject record = it.value().toObject();
+        Entry entry;
+        entry.size = qint64(record["s"].toDouble());
+        entry.mtime = qint64(record["m"].toDouble());
+        entry.device = record["d"].toString().toULongLong();
+        entry.inode = record["i"].toString().toULongLong();
+        entry.md5 = record["h"].toString();
+        if (!entry.md5.isEmpty())
+            m_entries.insert(it.key(), entry);
+    }
+}
+
+bool HashCache::lookup(const QString& filePath, QString& md5) const
+{
+    Entry cached;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.constFind(relativeLocked(filePath));
+        if (it == m_entries.constEnd())
+            return false;
+        cached = it.value();
+    }
+
+    // stat 不持锁，多个校验线程互不阻塞
+    Entry current;
+    if (!statFile(filePath, current))
+        return false;
+    if (current.size != cached.size || current.mtime != cached.mtime
+        || current.device != cached.device || current.inode != cached.inode)
+        return false;
+    md5 = cached.md5;
+    return true;
+}
+
+void HashCache::insert(const QString& filePath, const QString& md5)
+{
+    Entry entry;
+    if (md5.isEmpty() || !statFile(filePath, entry))
+        return;
+    entry.md5 = md5.toLower();
+
+    QMutexLocker locker(&m_mutex);
+    const QString rel = relativeLocked(filePath);
+    if (rel.isEmpty())
+        return;
+    m_entries.insert(rel, entry);
+    m_dirty = true;
+}
+
+bool HashCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty || m_root.isEmpty())
+        return true;
+
+    QJsonObject json;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QJsonObject record;
+        record.insert("s", double(it->size));
+        record.insert("m", double(it->mtime));
+        record.insert("d", QString::number(it->device));
+        record.insert("i", QString::number(it->inode));
+        record.insert("h", it->md5);
+        json.insert(it.key(), record);
+    }
+
+    QSaveFile file(QDir(m_root).filePath(HASH_CACHE_FILE_NAME));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        return false;
+    m_dirty = false;
+    return true;
+}
+
+bool HashCache::statFile(const QString& filePath, Entry& entry)
+{
+    const QFileInfo info(filePath);
+    if (!info.exists())
+        return false;
+    const FileIdentity id = file_identity(filePath);
+    entry.size = info.size();
+    entry.mtime = info.lastModified().toMSecsSinceEpoch();
+    entry.device = id.device;
+    entry.inode = id.inode;
+    return true;
+}
+
+QString HashCache::relativeLocked(const QString& filePath) const
+{
+    if (m_root.isEmpty() || filePath.isEmpty())
+        return QString();
+    const QString rel = QDir(m_root).relativeFilePath(QFileInfo(filePath).absoluteFilePath());
+    if (rel.startsWith("..") || QDir::isAbsolutePath(rel))
+        return QString();
+    return rel;
+}
@@ -0,0 +1,57 @@
+﻿#ifndef HASH_CACHE_H
+#define HASH_CACHE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
+
+/**
+ * 持久化的文件哈希缓存（<资产库>/.hashcache.json）
+ * 以（路径, 大小, mtime, inode）为键：四者都没变的文件直接复用上次的 md5，不再读内容；
+ * 任何一项变化（重新下载、被替换、硬链接指向别的 blob）都视为未命中。
+ * 所有接口线程安全，校验线程可并发查询 / 写入。
+ */
+class HashCache
+{
+public:
+    HashCache() = default;
+
+    /**
+     * 切换资产库（与当前不同时重新读取缓存文件）
+     * @param libraryPath 资产库根目录
+     */
+    void setLibraryPath(const QString& libraryPath);
+
+    /**
+     * 查询文件的缓存哈希
+     * @param filePath 资产库内的文件路径
+     * @param md5 输出：缓存的 md5（小写）
+     * @return 有记录且大小 / mtime / inode 均未变化时为 true
+     */
+    bool lookup(const QString& filePath, QString& md5) const;
+
+    /** 记录文件当前状态下的 md5（文件不存在时忽略） */
+    void insert(const QString& filePath, const QString& md5);
+
+    /** 有改动时写回缓存文件 */
+    bool save();
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 mtime = 0;       // 毫秒
+        quint64 device = 0;
+        quint64 inode = 0;
+        QString md5;
+    };
+
+    mutable QMutex m_mutex;
+    QString m_root;
+    QHash<QString, Entry> m_entries;   // 相对资产库的路径 -> 记录
+    bool m_dirty = false;
+
+    static bool statFile(const QString& filePath, Entry& entry);
+    QString relativeLocked(const QString& filePath) const;
+};
+
+#endif // HASH_CACHE_H
@@ -0,0 +1,347 @@
+﻿#include "headless_pull.h"
+#include "phaPullFromPolyhaven.h"
+#include "get_asset_list.h"
+#include "asset_index.h"
+#include "sync_plan.h"
+#include "trace.h"
+#include "metrics.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QMutex>
+#include <QtCore/QSemaphore>
+#include <QtCore/QSettings>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+/* ---------- 控制台输出（引擎信号在工作线程 / 池线程里直接回调，这里统一加锁） ---------- */
+namespace {
+
+class HeadlessConsole
+{
+public:
+    HeadlessConsole(const char* command, const HeadlessOptions& options)
+        : m_command(command)
+        , m_options(options)
+    {
+    }
+
+    void attach(phaPullFromPolyhaven* worker)
+    {
+        // 不带上下文对象的 connect 是直连：回调在发信号的线程里执行，调用线程只需阻塞等待
+        QObject::connect(worker, &phaPullFromPolyhaven::report, [this](const QString& type, const QString& content) {
+            if (type == "INFO" && !m_options.verbose)
+                return;
+            line(type == "INFO" ? stdout : stderr, QString("%1: %2").arg(type, content));
+        });
+        QObject::connect(worker, &phaPullFromPolyhaven::progressUpdated, [this](int current, int total, const QString&) {
+            m_current.store(current, std::memory_order_relaxed);
+            m_total.store(total, std::memory_order_relaxed);
+        });
+        // 字节进度每秒一次，正好作为进度行的节拍
+        QObject::connect(worker, &phaPullFromPolyhaven::byteProgressUpdated,
+            [this](qint64 doneBytes, qint64 totalBytes, double bytesPerSecond, qint64 etaSeconds) {
+                if (m_options.quiet)
+                    return;
+                line(stdout, QString("%1/%2 assets, %3 / %4, %5/s, ETA %6")
+                    .arg(m_current.load(std::memory_order_relaxed))
+                    .arg(m_total.load(std::memory_order_relaxed))
+                    .arg(format_bytes(doneBytes), format_bytes(totalBytes),
+                        format_bytes(qint64(bytesPerSecond)), format_duration(etaSeconds)));
+            });
+        QObject::connect(worker, &phaPullFromPolyhaven::planReady, [this](int, qint64, const QString& summary) {
+            line(stdout, summary);
+        });
+        QObject::connect(worker, &phaPullFromPolyhaven::finished, [this](int downloadedCount, int failedCount) {
+            m_failed.store(failedCount, std::memory_order_relaxed);
+            line(stdout, QString("%1 assets up to date, %2 failed").arg(downloadedCount).arg(failedCount));
+        });
+    }
+
+    void line(FILE* stream, const QString& text)
+    {
+        QMutexLocker locker(&m_mutex);
+        std::fprintf(stream, "[%s] %s\n", m_command, text.toUtf8().constData());
+        // 农场日志通常是管道，不 flush 的话进度会攒到结束才出现
+        std::fflush(stream);
+    }
+
+    int failedCount() const { return m_failed.load(std::memory_order_relaxed); }
+
+private:
+    const char* m_command;
+    HeadlessOptions m_options;
+    QMutex m_mutex;
+    std::atomic<int> m_current{ 0 };
+    std::atomic<int> m_total{ 0 };
+    std::atomic<int> m_failed{ 0 };
+};
+
+// hbatch / hython 里可能还没有 Qt 应用对象；工作线程的事件循环需要它
+void ensure_core_application()
+{
+    if (QCoreApplication::instance())
+        return;
+    static int argc = 1;
+    static char appName[] = "cmd_polyhaven";
+    static char* argv[] = { appName, nullptr };
+    // 进程内只建一次，随 Houdini 退出
+    new QCoreApplication(argc, argv);
+}
+
+// 配置来源：指定了 ini 文件就读它，否则读浏览器共用的配置
+std::unique_ptr<QSettings> open_settings(const HeadlessOptions& options)
+{
+    if (!options.settingsFile.isEmpty())
+        return std::make_unique<QSettings>(options.settingsFile, QSettings::IniFormat);
+    return std::make_unique<QSettings>(SETTINGS_ORG_NAME, SETTINGS_APP_NAME);
+}
+
+// 资产库路径：显式指定优先；其次沿用进程里已注入的路径（Houdini 里浏览器已打开），最后读配置。
+// 路径是进程全局的，Houdini 里浏览器也在用：命令结束（引擎析构之后）恢复原值
+class ScopedLibraryPath
+{
+public:
+    ScopedLibraryPath(const HeadlessOptions& options, const QSettings& settings)
+        : m_previous(get_asset_lib_path())
+    {
+        if (!options.libraryPath.isEmpty())
+            set_asset_lib_path(options.libraryPath);
+        else if (m_previous.isEmpty())
+            set_asset_lib_path(load_asset_lib_path(settings));
+    }
+
+    ~ScopedLibraryPath()
+    {
+        set_asset_lib_path(m_previous);
+    }
+
+private:
+    QString m_previous;
+};
+
+int exit_code(int resultCode, int failedCount)
+{
+    switch (resultCode) {
+    case 0:
+        return failedCount > 0 ? PH_EXIT_FAILURES : PH_EXIT_OK;
+    case 1:
+        return PH_EXIT_CANCELLED;
+    case -1:
+    case -2:
+        return PH_EXIT_LIBRARY;
+    case -3:
+        return PH_EXIT_NETWORK;
+    default:
+        return PH_EXIT_FAILURES;
+    }
+}
+
+} // namespace
+
+bool headless_is_asset_type(const QString& assetType)
+{
+    static const QStringList TYPES = { "all", "hdris", "textures", "models" };
+    return TYPES.contains(assetType);
+}
+
+int headless_sync(const HeadlessOptions& options)
+{
+    ensure_core_application();
+    const char* command = options.dryRun ? "plan" : (options.slugs.isEmpty() ? "sync" : "fetch");
+    // 控制台要比引擎活得久：引擎析构时仍可能有收尾任务在发 report
+    HeadlessConsole console(command, options);
+    const std::unique_ptr<QSettings> settings = open_settings(options);
+    const ScopedLibraryPath libraryPath(options, *settings);
+    phaPullFromPolyhaven worker;
+    worker.loadSettings(*settings);
+    if (options.jobs > 0)
+        worker.setConcurrencyBounds(qMin(2, options.jobs), options.jobs);
+    worker.setAssetType(options.assetType);
+    // 点名拉取的资产一律重新请求清单
+    worker.setRevalidate(options.revalidate || !options.slugs.isEmpty());
+    worker.setDryRun(options.dryRun);
+    worker.setSlugFilter(options.slugs);
+    console.attach(&worker);
+
+    QSemaphore done;
+    std::atomic<int> resultCode{ 0 };
+    QObject::connect(&worker, &phaPullFromPolyhaven::executeFinished, [&](int code) {
+        resultCode.store(code);
+        done.release();
+    });
+    worker.executeAsync();
+    done.acquire();
+
+    const int status = exit_code(resultCode.load(), console.failedCount());
+    if (status != PH_EXIT_OK)
+        console.line(stderr, QString("finished with exit status %1").arg(status));
+    return status;
+}
+
+int headless_verify(const HeadlessOptions& options)
+{
+    ensure_core_application();
+    HeadlessConsole console("verify", options);
+    const std::unique_ptr<QSettings> settings = open_settings(options);
+    const ScopedLibraryPath libraryPath(options, *settings);
+    phaPullFromPolyhaven worker;
+    worker.loadSettings(*settings);
+    worker.setAssetType(options.assetType);
+    console.attach(&worker);
+
+    // 校验只发 progressUpdated，没有字节进度：每 5% 输出一行
+    std::atomic<int> lastPercent{ -1 };
+    if (!options.quiet) {
+        QObject::connect(&worker, &phaPullFromPolyhaven::progressUpdated, [&](int current, int total, const QString&) {
+            if (total <= 0)
+                return;
+            const int percent = current * 100 / total;
+            if (percent / 5 > lastPercent.load() / 5 || percent == 100) {
+                lastPercent.store(percent);
+                console.line(stdout, QString("%1/%2 files (%3%)").arg(current).arg(total).arg(percent));
+            }
+        });
+    }
+
+    QSemaphore done;
+    int checked = 0;
+    int hashed = 0;
+    QStringList mismatches;
+    QObject::connect(&worker, &phaPullFromPolyhaven::verifyFinished,
+        [&](int checkedCount, int hashedCount, const QStringList& files) {
+            checked = checkedCount;
+            hashed = hashedCount;
+            mismatches = files;
+            done.release();
+        });
+    worker.verifyAsync();
+    done.acquire();
+
+    for (const QString& path : mismatches)
+        console.line(stdout, QString("MISMATCH %1").arg(path));
+    console.line(stdout, QString("%1 files checked (%2 read, %3 from hash cache), %4 mismatches")
+        .arg(checked).arg(hashed).arg(checked - hashed).arg(mismatches.size()));
+    return mismatches.isEmpty() ? PH_EXIT_OK : PH_EXIT_FAILURES;
+}
+
+int headless_search(const HeadlessOptions& options, const QStringList& words, int limit)
+{
+    const ScopedLibraryPath libraryPath(options, *open_settings(options));
+    // 列表缓存 7 天内直接用，过期才联网
+    QString error;
+    const QMap<QString, QJsonObject> assets = get_asset_list("all", false, error);
+    if (assets.isEmpty()) {
+        std::fprintf(stderr, "[search] Failed to load asset list: %s\n", error.toUtf8().constData());
+        return PH_EXIT_NETWORK;
+    }
+
+    AssetIndex index;
+    index.build(assets);
+    QBitArray bits = index.allBits();
+    for (const QString& word : words) {
+        const QString text = word.trimmed().toLower();
+        if (!text.isEmpty())
+            bits = index.matchText(text, bits);
+    }
+
+    static const char* TYPE_NAMES[] = { "hdri", "texture", "model" };
+    const QVector<int> rows = index.sortedRows(bits, AssetIndex::SortByDownloads, true);
+    int printed = 0;
+    for (int row : rows) {
+        if (limit > 0 && printed >= limit)
+            break;
+        const QJsonObject& details = index.details(row);
+        const int type = details["type"].toInt();
+        std::printf("%s\t%s\t%s\n", index.slug(row).toUtf8().constData(),
+            type >= 0 && type < 3 ? TYPE_NAMES[type] : "?",
+            details["name"].toString().toUtf8().constData());
+        ++printed;
+    }
+    std::printf("[search] %d of %d assets match\n", int(rows.size()), index.size());
+    std::fflush(stdout);
+    return PH_EXIT_OK;
+}
+
+int headless_trace(const QStringList& args)
+{
+    const QString action = args.value(0);
+    if (action == "start" && args.size() == 1) {
+        trace_start();
+        std::printf("[trace] recording\n");
+    }
+    else if (action == "stop" && args.size() == 1) {
+        trace_stop();
+        std::printf("[trace] stopped\n");
+    }
+    else if (action == "save" && args.size() == 2) {
+        const QString error = trace_write_file(args[1]);
+        if (!error.isEmpty()) {
+            std::fprintf(stderr, "[trace] %s\n", error.toUtf8().constData());
+            return PH_EXIT_FAILURES;
+        }
+        std::printf("[trace] written to %s\n", args[1].toUtf8().constData());
+    }
+    else {
+        return PH_EXIT_USAGE;
+    }
+    std::fflush(stdout);
+    return PH_EXIT_OK;
+}
+
+int headless_metrics(const QStringList& args)
+{
+    if (args.size() > 1)
+        return PH_EXIT_USAGE;
+    const QString error = metrics_write_file(args.value(0, "-"));
+    if (!error.isEmpty()) {
+        std::fprintf(stderr, "[metrics] %s\n", error.toUtf8().constData());
+        return PH_EXIT_FAILURES;
+    }
+    return PH_EXIT_OK;
+}
+
+namespace {
+
+int dispatch(const QString& subcommand, const QStringList& args, HeadlessOptions options)
+{
+    if (subcommand == "sync" || subcommand == "plan" || subcommand == "verify") {
+        options.assetType = args.value(0, "all");
+        options.dryRun = subcommand == "plan";
+        if (args.size() > 1 || !headless_is_asset_type(options.assetType))
+            return PH_EXIT_USAGE;
+        return subcommand == "verify" ? headless_verify(options) : headless_sync(options);
+    }
+    if (subcommand == "fetch" && !args.isEmpty()) {
+        options.slugs = args;
+        return headless_sync(options);
+    }
+    if (subcommand == "search" && !args.isEmpty())
+        return headless_search(options, args);
+    if (subcommand == "trace")
+        return headless_trace(args);
+    if (subcommand == "metrics")
+        return headless_metrics(args);
+    return PH_EXIT_USAGE;
+}
+
+} // namespace
+
+int headless_run(const QString& subcommand, const QStringList& args, HeadlessOptions options)
+{
+    if (!options.traceFile.isEmpty())
+        trace_start();
+    const int status = dispatch(subcommand, args, options);
+
+    if (!options.traceFile.isEmpty()) {
+        trace_stop();
+        const QString error = trace_write_file(options.traceFile);
+        if (!error.isEmpty())
+            std::fprintf(stderr, "[trace] %s\n", error.toUtf8().constData());
+    }
+    if (!options.metricsFile.isEmpty() && status != PH_EXIT_USAGE) {
+        const QString error = metrics_write_file(options.metricsFile);
+        if (!error.isEmpty())
+            std::fprintf(stderr, "[metrics] %s\n", error.toUtf8().constData());
+    }
+    return status;
+}
@@ -0,0 +1,86 @@
+﻿#ifndef HEADLESS_PULL_H
+#define HEADLESS_PULL_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+
+/**
+ * cmd_polyhaven 子命令的无界面实现（渲染节点预热资产库、夜间任务）
+ * 复用 phaPullFromPolyhaven 拉取引擎，不创建任何 Qt 控件；进度逐行写到 stdout，警告和错误写到 stderr，
+ * 调用阻塞到引擎结束，返回下面的退出码。
+ * 只依赖 QtCore 和 libcurl：Houdini 里的 cmd_polyhaven 和独立的 polyhaven_cli 共用这套实现，
+ * 资产库路径和配置由 HeadlessOptions 注入，不读浏览器窗口的状态。
+ */
+
+// 退出码
+enum HeadlessExitCode {
+    PH_EXIT_OK = 0,
+    PH_EXIT_FAILURES = 1,    // 部分资产失败 / 校验发现不符的文件
+    PH_EXIT_USAGE = 2,       // 参数错误
+    PH_EXIT_LIBRARY = 3,     // 资产库未配置或路径不存在
+    PH_EXIT_NETWORK = 4,     // 资产列表获取失败
+    PH_EXIT_CANCELLED = 5
+};
+
+struct HeadlessOptions {
+    QString assetType = "all";   // all / hdris / textures / models
+    QStringList slugs;           // 非空时只拉取这些资产（fetch）
+    bool revalidate = false;     // 已有资产也重新请求文件清单（/files）
+    bool dryRun = false;         // 只规划不下载（plan）
+    int jobs = 0;                // 下载并发上限（<=0 时沿用配置）
+    bool quiet = false;          // 不输出进度
+    bool verbose = false;        // 输出引擎的 INFO 日志
+    QString libraryPath;         // 资产库根目录（为空时读配置里浏览器上次使用的路径）
+    QString settingsFile;        // ini 配置文件（为空时读浏览器共用的配置）
+    QString traceFile;           // 非空时记录本次运行的 trace，结束后写成 Chrome trace JSON
+    QString metricsFile;         // 非空时结束后导出指标快照 JSON（"-" 为 stdout）
+};
+
+/** 资产类型参数是否有效 */
+bool headless_is_asset_type(const QString& assetType);
+
+/**
+ * 同步 / 规划 / 按 slug 拉取
+ * @return HeadlessExitCode
+ */
+int headless_sync(const HeadlessOptions& options);
+
+/**
+ * 校验本地文件，不符的文件逐行输出
+ * @return HeadlessExitCode
+ */
+int headless_verify(const HeadlessOptions& options);
+
+/**
+ * 在资产列表中检索（每个词都要命中 name / tags / categories），按下载量从高到低输出
+ * @param options 只用到资产库路径和配置
+ * @param words 检索词
+ * @param limit 最多输出条数（<=0 不限制）
+ * @return HeadlessExitCode
+ */
+int headless_search(const HeadlessOptions& options, const QStringList& words, int limit = 0);
+
+/**
+ * trace 控制：start 开始记录，stop 停止，save <file> 导出 Chrome trace JSON
+ * 用于在 Houdini 里按需抓取浏览器本身（检索、缩略图、下载）的 trace
+ * @return HeadlessExitCode
+ */
+int headless_trace(const QStringList& args);
+
+/**
+ * 导出当前进程的指标快照（Houdini 里即浏览器累计的吞吐、延迟、缓存命中等）
+ * @param args 可选的输出文件，缺省为 stdout
+ * @return HeadlessExitCode
+ */
+int headless_metrics(const QStringList& args);
+
+/**
+ * 按子命令分派（sync / plan / verify / search / fetch / trace / metrics）
+ * @param subcommand 子命令
+ * @param args 子命令之后的参数
+ * @param options 已解析的选项
+ * @return HeadlessExitCode；子命令或参数无效时为 PH_EXIT_USAGE，由调用方输出用法
+ */
+int headless_run(const QString& subcommand, const QStringList& args, HeadlessOptions options);
+
+#endif // HEADLESS_PULL_H
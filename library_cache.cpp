@@ -0,0 +1,325 @@
+﻿#include "library_cache.h"
+#include "content_store.h"
+#include "sync_plan.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qdiriterator.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qregularexpression.h>
+#include <QtCore/qsavefile.h>
+#include <algorithm>
+
+// 访问记录文件（放在资产库根目录，不在任何资产目录里）
+static const char* ACCESS_FILE_NAME = ".access.json";
+// 断点续传的半成品（见 SyncJournal::partPath），不计入占用也不参与淘汰
+static const char* PART_SUFFIX = ".part";
+
+static int resolution_k(const QString& res)
+{
+    QString digits = res.trimmed().toLower();
+    if (digits.endsWith('k'))
+        digits.chop(1);
+    bool ok = false;
+    const int k = digits.toInt(&ok);
+    return ok ? k : 0;
+}
+
+QString EvictionReport::summary() const
+{
+    if (!error.isEmpty())
+        return error;
+    if (evictedFiles == 0)
+        return QString("Library uses %1, within budget").arg(format_bytes(usageBefore));
+    return QString("Evicted %1 files (%2) to stay within budget; library now uses %3")
+        .arg(evictedFiles)
+        .arg(format_bytes(usageBefore - usageAfter))
+        .arg(format_bytes(usageAfter));
+}
+
+bool LibraryCache::isHighResolution(const QString& fileName, const QString& keepRes)
+{
+    static const QRegularExpression RES_TOKEN("(?:^|[_.\\-])(\\d+)k(?=[_.\\-]|$)",
+        QRegularExpression::CaseInsensitiveOption);
+
+    // 取最后一个分辨率记号（slug 本身可能带数字）
+    int k = 0;
+    QRegularExpressionMatchIterator it = RES_TOKEN.globalMatch(QFileInfo(fileName).fileName());
+    while (it.hasNext())
+        k = it.next().captured(1).toInt();
+    return k > 0 && k > resolution_k(keepRes);
+}
+
+void LibraryCache::setLibraryPath(const QString& libraryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString root = libraryPath.isEmpty() ? QString() : QDir(libraryPath).absolutePath();
+    if (root == m_root)
+        return;
+    if (m_dirty)
+        saveLocked();
+    m_root = root;
+    loadLocked();
+}
+
+QString LibraryCache::libraryPath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+void LibraryCache::setBudget(qint64 bytes, const QString& keepRes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = qMax<qint64>(0, bytes);
+    m_keepRes = keepRes;
+}
+
+qint64 LibraryCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+void LibraryCache::touch(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString rel = relativeLocked(filePath);
+    if (rel.isEmpty())
+        return;
+    m_access[rel] = QDateTime::currentSecsSinceEpoch();
+    m_dirty = true;
+}
+
+void LibraryCache::touchAsset(const QString& slug)
+{
+    const QString root = libraryPath();
+    if (root.isEmpty() || slug.isEmpty())
+        return;
+
+    // 遍历目录不持锁，期间其他线程仍可查询淘汰状态
+    const QDir rootDir(root);
+    QStringList touched;
+    QDirIterator it(rootDir.filePath(slug), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!path.endsWith(PART_SUFFIX))
+            touched.append(rootDir.relativeFilePath(path));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (root != m_root || touched.isEmpty())
+        return;
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    for (const QString& rel : touched)
+        m_access[rel] = now;
+    m_dirty = true;
+}
+
+bool LibraryCache::isEvicted(const QString& filePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_evicted.isEmpty() && m_evicted.contains(relativeLocked(filePath));
+}
+
+QStringList LibraryCache::evictedFiles(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList files;
+    const QString prefix = slug + '/';
+    for (const QString& rel : m_evicted) {
+        if (rel.startsWith(prefix))
+            files.append(QDir(m_root).filePath(rel));
+    }
+    return files;
+}
+
+void LibraryCache::markFetched(const QString& filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString rel = relativeLocked(filePath);
+    if (rel.isEmpty())
+        return;
+    // 普通下载也会走到这里，只在确实有淘汰记录时标记待写
+    if (m_evicted.remove(rel)) {
+        m_access[rel] = QDateTime::currentSecsSinceEpoch();
+        m_dirty = true;
+    }
+}
+
+void LibraryCache::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_dirty)
+        saveLocked();
+}
+
+EvictionReport LibraryCache::enforceBudget()
+{
+    EvictionReport report;
+
+    QString root;
+    qint64 budget = 0;
+    QString keepRes;
+    QHash<QString, qint64> access;
+    {
+        QMutexLocker locker(&m_mutex);
+        root = m_root;
+        budget = m_budget;
+        keepRes = m_keepRes;
+        access = m_access;
+    }
+    if (root.isEmpty()) {
+        report.error = "Library cache has no library path";
+        return report;
+    }
+
+    // 同一身份（硬链接）的所有路径归为一组：占用只计一次，淘汰时整组删除才真正释放空间
+    struct Group {
+        qint64 size = 0;
+        QStringList paths;        // 资产目录中的链接（相对路径）
+        QString blob;             // 内容仓库中的 blob（绝对路径）
+        bool evictable = true;
+        qint64 lastAccess = 0;
+    };
+    QHash<FileIdentity, Group> groups;
+    quint64 anonymous = 0;
+
+    auto groupFor = [&](const QFileInfo& info) -> Group& {
+        FileIdentity id = file_identity(info.filePath());
+        if (!id.isValid()) {
+            // 拿不到 inode：按独立文件处理
+            id.device = ~quint64(0);
+            id.inode = ++anonymous;
+        }
+        Group& group = groups[id];
+        group.size = info.size();
+        return group;
+    };
+
+    const QDir rootDir(root);
+    const QFileInfoList entries = rootDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden);
+    for (const QFileInfo& entry : entries) {
+        const bool isStore = entry.fileName() == ".store";
+        if (!isStore && entry.fileName().startsWith('.'))
+            continue;
+
+        QDirIterator it(entry.filePath(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            if (info.fileName().endsWith(PART_SUFFIX))
+                continue;
+            Group& group = groupFor(info);
+            if (isStore) {
+                group.blob = info.filePath();
+                continue;
+            }
+            const QString rel = rootDir.relativeFilePath(info.filePath());
+            group.paths.append(rel);
+            group.evictable = group.evictable && isHighResolution(rel, keepRes);
+            group.lastAccess = qMax(group.lastAccess,
+                access.value(rel, info.lastModified().toSecsSinceEpoch()));
+        }
+    }
+
+    QVector<Group*> candidates;
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        report.usageBefore += it->size;
+        // 没有任何资产引用的孤立 blob 也可回收，lastAccess 为 0 排在最前
+        if (it->evictable)
+            candidates.append(&it.value());
+    }
+    report.usageAfter = report.usageBefore;
+    if (budget <= 0 || report.usageBefore <= budget)
+        return report;
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Group* a, const Group* b) { return a->lastAccess < b->lastAccess; });
+
+    QStringList evicted;
+    for (Group* group : candidates) {
+        if (report.usageAfter <= budget)
+            break;
+        bool removed = true;
+        for (const QString& rel : group->paths)
+            removed = QFile::remove(rootDir.filePath(rel)) && removed;
+        if (!group->blob.isEmpty())
+            removed = QFile::remove(group->blob) && removed;
+        if (!removed)
+            continue;   // 文件被占用（如正在 Houdini 中打开），留给下一次
+        report.usageAfter -= group->size;
+        report.evictedFiles += group->paths.size();
+        evicted += group->paths;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (root != m_root)
+        return report;
+    for (const QString& rel : evicted) {
+        m_evicted.insert(rel);
+        m_access.remove(rel);
+    }
+    if (!evicted.isEmpty())
+        saveLocked();
+    return report;
+}
+
+/* ---------- 访问记录读写（调用方持锁） ---------- */
+void LibraryCache::loadLocked()
+{
+    m_access.clear();
+    m_evicted.clear();
+    m_dirty = false;
+    if (m_root.isEmpty())
+        return;
+
+    QFile file(QDir(m_root).filePath(ACCESS_FILE_NAME));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject access = json.value("access").toObject();
+    for (auto it = access.constBegin(); it != access.constEnd(); ++it)
+        m_access.insert(it.key(), qint64(it.value().toDouble()));
+    for (const QJsonValue& v : json.value("evicted").toArray())
+        m_evicted.insert(v.toString());
+}
+
+void LibraryCache::saveLocked()
+{
+    if (m_root.isEmpty()) {
+        m_dirty = false;
+        return;
+    }
+
+    QJsonObject access;
+    for (auto it = m_access.constBegin(); it != m_access.constEnd(); ++it)
+        access.insert(it.key(), double(it.value()));
+    QJsonArray evicted;
+    for (const QString& rel : m_evicted)
+        evicted.append(rel);
+    QJsonObject json;
+    json.insert("access", access);
+    json.insert("evicted", evicted);
+
+    // 先写临时文件再替换，崩溃时不会留下半截记录
+    QSaveFile file(QDir(m_root).filePath(ACCESS_FILE_NAME));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    // 写失败时保留待写标记，下次 flush 再试
+    m_dirty = !file.commit();
+}
+
+QString LibraryCache::relativeLocked(const QString& filePath) const
+{
+    if (m_root.isEmpty() || filePath.isEmpty())
+        return QString();
+    const QString rel = QDir(m_root).relativeFilePath(QFileInfo(filePath).absoluteFilePath());
+    if (rel.startsWith("..") || QDir::isAbsolutePath(rel))
+        return QString();
+    return rel;
+}
@@ -0,0 +1,94 @@
+﻿#ifndef LIBRARY_CACHE_H
+#define LIBRARY_CACHE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qmutex.h>
+
+/** 一次按预算淘汰的结果 */
+struct EvictionReport {
+    qint64 usageBefore = 0;   // 资产目录 + 内容仓库实际占用（硬链接只计一次）
+    qint64 usageAfter = 0;
+    int evictedFiles = 0;     // 删除的资产目录文件数（不含随之删除的仓库 blob）
+    QString error;
+
+    /** 一行文字报告 */
+    QString summary() const;
+};
+
+/**
+ * 资产库缓存管理：记录本体文件的最近访问时间，超出磁盘预算时按 LRU 淘汰高分辨率本体
+ * info.json、缩略图和不高于保留分辨率的文件永不淘汰，浏览器和默认导入始终可用；
+ * 被淘汰的文件记入 <资产库>/.access.json，之后的同步不再补齐，用到时再按需拉回。
+ * 访问记录先改内存，flush() 时才写盘，调用方在拉取结束或定时器里统一保存。
+ * 占用按文件身份（inode）去重，同一内容的硬链接和仓库 blob 只计一次，淘汰时一起删除。
+ * 所有接口线程安全。
+ */
+class LibraryCache
+{
+public:
+    LibraryCache() = default;
+
+    /**
+     * 切换资产库（与当前不同时重新读取访问记录）
+     * @param libraryPath 资产库根目录
+     */
+    void setLibraryPath(const QString& libraryPath);
+    QString libraryPath() const;
+
+    /**
+     * 设置磁盘预算
+     * @param bytes 上限字节数（<=0 表示不限制）
+     * @param keepRes 保留分辨率，不高于它的文件不淘汰（如 "1k"）
+     */
+    void setBudget(qint64 bytes, const QString& keepRes = "1k");
+    qint64 budget() const;
+
+    /** 记录文件被使用（导入、拖入场景） */
+    void touch(const QString& filePath);
+
+    /** 记录资产目录下全部文件被使用（遍历目录时不持锁，宜在后台线程调用） */
+    void touchAsset(const QString& slug);
+
+    /** 文件是否已被淘汰（同步时跳过） */
+    bool isEvicted(const QString& filePath) const;
+
+    /** 资产下被淘汰的文件（绝对路径） */
+    QStringList evictedFiles(const QString& slug) const;
+
+    /** 文件已重新下载：清除淘汰标记并记为刚访问 */
+    void markFetched(const QString& filePath);
+
+    /**
+     * 扫描资产库，超出预算时按最近访问时间从旧到新删除可淘汰文件，直到回到预算内
+     * 未设置预算时只统计占用
+     */
+    EvictionReport enforceBudget();
+
+    /** 有未保存的访问记录时写回 .access.json */
+    void flush();
+
+    /**
+     * 文件名中的分辨率（"_4k."、".16k." 等）是否高于保留分辨率
+     * @param fileName 文件名
+     * @param keepRes 保留分辨率，如 "1k"
+     */
+    static bool isHighResolution(const QString& fileName, const QString& keepRes);
+
+private:
+    mutable QMutex m_mutex;
+    QString m_root;
+    qint64 m_budget = 0;
+    QString m_keepRes = "1k";
+    QHash<QString, qint64> m_access;   // 相对资产库的路径 -> 最近访问时间（秒）
+    QSet<QString> m_evicted;           // 相对资产库的路径
+    bool m_dirty = false;              // 内存中的记录比 .access.json 新
+
+    void loadLocked();
+    void saveLocked();
+    QString relativeLocked(const QString& filePath) const;
+};
+
+#endif // LIBRARY_CACHE_H
@@ -0,0 +1,275 @@
+﻿#include "library_presence.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qregularexpression.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qvector.h>
+#include <atomic>
+
+#ifdef Q_OS_WIN
+#include <QtCore/qdiriterator.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+static const char* THUMBNAIL_FILE_NAME = "thumbnail.webp";
+static const char* PART_SUFFIX = ".part";
+
+// 登记一个文件，并从文件名里提取分辨率和格式
+static void add_file(AssetPresence& presence, const QString& relative, qint64 size)
+{
+    static const QRegularExpression RES_TOKEN("(?:^|[_.\\-])(\\d+k)(?=[_.\\-]|$)",
+        QRegularExpression::CaseInsensitiveOption);
+
+    if (relative.endsWith(PART_SUFFIX))
+        return;
+    if (relative == THUMBNAIL_FILE_NAME)
+        presence.hasThumbnail = true;
+    presence.files.insert(relative, size);
+
+    const QString fileName = relative.section('/', -1);
+    QRegularExpressionMatchIterator it = RES_TOKEN.globalMatch(fileName);
+    QString res;
+    while (it.hasNext())
+        res = it.next().captured(1).toLower();
+    if (!res.isEmpty())
+        presence.resolutions.insert(res);
+    const int dot = fileName.lastIndexOf('.');
+    if (dot > 0)
+        presence.formats.insert(fileName.mid(dot + 1).toLower());
+}
+
+#ifdef Q_OS_WIN
+static void walk_directory(const QString& path, const QString& prefix, AssetPresence& presence)
+{
+    // FindFirstFile / FindNextFile 的结果里已有大小，fileInfo() 不会再单独 stat
+    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        const QString relative = prefix + info.fileName();
+        if (info.isDir()) {
+            presence.directories.append(relative);
+            walk_directory(info.filePath(), relative + '/', presence);
+        }
+        else {
+            add_file(presence, relative, info.size());
+        }
+    }
+}
+#else
+static void walk_directory(const QString& path, const QString& prefix, AssetPresence& presence)
+{
+    DIR* dir = opendir(QFile::encodeName(path).constData());
+    if (!dir)
+        return;
+    const int fd = dirfd(dir);
+    // readdir 每次从 libc 缓冲里取一项，缓冲空了才发一次 getdents，一个目录通常一两次系统调用
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+        const QString relative = prefix + QFile::decodeName(name);
+
+        bool isDir = entry->d_type == DT_DIR;
+        qint64 size = 0;
+        if (entry->d_type != DT_DIR) {
+            // 普通文件要大小；符号链接和不报类型的文件系统（部分网络盘）跟随链接判断
+            struct stat st;
+            if (fstatat(fd, name, &st, 0) != 0)
+                continue;
+            isDir = S_ISDIR(st.st_mode);
+            if (!isDir && !S_ISREG(st.st_mode))
+                continue;
+            size = qint64(st.st_size);
+        }
+        if (isDir) {
+            presence.directories.append(relative);
+            walk_directory(path + '/' + QFile::decodeName(name), relative + '/', presence);
+        }
+        else {
+            add_file(presence, relative, size);
+        }
+    }
+    closedir(dir);
+}
+#endif
+
+bool LibraryPresence::scanAsset(const QString& assetPath, AssetPresence& presence)
+{
+    presence = AssetPresence();
+    if (!QFileInfo(assetPath).isDir())
+        return false;
+    walk_directory(assetPath, QString(), presence);
+    return true;
+}
+
+bool LibraryPresence::scan(const QString& libraryPath, int threadCount)
+{
+    const QString root = libraryPath.isEmpty() ? QString() : QDir::cleanPath(QDir(libraryPath).absolutePath());
+    QDir rootDir(root);
+    if (root.isEmpty() || !rootDir.exists())
+        return false;
+
+    // 资产目录名即 slug；.store 等以点开头的内部目录不算资产
+    const QStringList slugs = rootDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    const int total = slugs.size();
+    QVector<AssetPresence> results(total);
+    QVector<bool> found(total, false);
+
+    const int threads = qMax(1, qMin(total, threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount())));
+    std::atomic<int> next{ 0 };
+    AssetPresence* out = results.data();
+    bool* ok = found.data();
+
+    // 与 filehash_batch 相同：私有线程池，从共享下标领取资产目录，大目录不会拖住其他线程
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int t = 0; t < threads; ++t) {
+        pool.start([&]() {
+            for (;;) {
+                const int i = next.fetch_add(1, std::memory_order_relaxed);
+                if (i >= total)
+                    break;
+                ok[i] = scanAsset(rootDir.filePath(slugs[i]), out[i]);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    QHash<QString, AssetPresence> assets;
+    assets.reserve(total);
+    for (int i = 0; i < total; ++i) {
+        if (found[i])
+            assets.insert(slugs[i], std::move(results[i]));
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_root = root;
+    m_assets = std::move(assets);
+    m_ready = true;
+    return true;
+}
+
+void LibraryPresence::rescanAsset(const QString& slug)
+{
+    QString root;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_ready || slug.isEmpty())
+            return;
+        root = m_root;
+    }
+
+    // 目录遍历不持锁
+    AssetPresence presence;
+    const bool exists = scanAsset(QDir(root).filePath(slug), presence);
+
+    QMutexLocker locker(&m_mutex);
+    if (root != m_root)
+        return;
+    if (exists)
+        m_assets.insert(slug, std::move(presence));
+    else
+        m_assets.remove(slug);
+}
+
+QString LibraryPresence::libraryPath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+bool LibraryPresence::isReady() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_ready;
+}
+
+bool LibraryPresence::contains(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_assets.contains(slug);
+}
+
+bool LibraryPresence::hasThumbnail(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_assets.constFind(slug);
+    return it != m_assets.constEnd() && it->hasThumbnail;
+}
+
+AssetPresence LibraryPresence::asset(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_assets.value(slug);
+}
+
+QStringList LibraryPresence::slugs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_assets.keys();
+}
+
+bool LibraryPresence::splitLocked(const QString& localPath, QString& slug, QString& relative) const
+{
+    if (!m_ready || m_root.isEmpty())
+        return false;
+    const QString path = QDir::cleanPath(localPath);
+    if (!path.startsWith(m_root + '/'))
+        return false;
+    const QString rest = path.mid(m_root.size() + 1);
+    const int slash = rest.indexOf('/');
+    if (slash <= 0)
+        return false;
+    slug = rest.left(slash);
+    relative = rest.mid(slash + 1);
+    return !relative.isEmpty();
+}
+
+bool LibraryPresence::lookup(const QString& localPath, qint64& size) const
+{
+    QMutexLocker locker(&m_mutex);
+    QString slug;
+    QString relative;
+    if (!splitLocked(localPath, slug, relative))
+        return false;
+    auto it = m_assets.constFind(slug);
+    size = it == m_assets.constEnd() ? -1 : it->files.value(relative, -1);
+    return true;
+}
+
+void LibraryPresence::recordFile(const QString& localPath, qint64 size)
+{
+    QMutexLocker locker(&m_mutex);
+    QString slug;
+    QString relative;
+    if (!splitLocked(localPath, slug, relative))
+        return;
+    AssetPresence& presence = m_assets[slug];
+    add_file(presence, relative, size);
+    // 新建的子目录（如 textures/）也要纳入监视
+    const QString parent = relative.section('/', 0, -2);
+    if (!parent.isEmpty() && !presence.directories.contains(parent))
+        presence.directories.append(parent);
+}
+
+QStringList LibraryPresence::directories() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList dirs;
+    if (!m_ready)
+        return dirs;
+    dirs.append(m_root);
+    for (auto it = m_assets.constBegin(); it != m_assets.constEnd(); ++it) {
+        const QString assetPath = m_root + '/' + it.key();
+        dirs.append(assetPath);
+        for (const QString& sub : it->directories)
+            dirs.append(assetPath + '/' + sub);
+    }
+    return dirs;
+}
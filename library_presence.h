@@ -0,0 +1,83 @@
+﻿#ifndef LIBRARY_PRESENCE_H
+#define LIBRARY_PRESENCE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qmutex.h>
+
+/** 单个资产目录在磁盘上的内容 */
+struct AssetPresence {
+    bool hasThumbnail = false;      // thumbnail.webp
+    QHash<QString, qint64> files;   // 相对资产目录的路径 -> 字节数（不含 .part）
+    QSet<QString> resolutions;      // 文件名中出现的分辨率，如 "1k"、"4k"
+    QSet<QString> formats;          // 扩展名，如 "hdr"、"jpg"、"gltf"
+    QStringList directories;        // 子目录（相对资产目录），供监视用
+};
+
+/**
+ * 资产库在库表：一次并行扫描整个资产库，记下每个资产目录下实际有哪些文件（路径 + 大小）
+ * 扫描用 readdir 批量取目录项（glibc 底层一次 getdents 取一整块），按 d_type 区分文件和目录，
+ * 只对文件做一次 fstatat 取大小；Windows 上 FindFirstFile 本身就带大小。
+ * 扫描之后由 LibraryWatcher 按目录变化逐个资产重扫，浏览器和同步规划都查这张表，不再逐个 stat。
+ * 所有接口线程安全。
+ */
+class LibraryPresence
+{
+public:
+    LibraryPresence() = default;
+
+    /**
+     * 全量扫描资产库（每个资产目录一个任务，多线程并行）
+     * @param libraryPath 资产库根目录
+     * @param threadCount 线程数（<=0 时取 CPU 核数）
+     * @return 资产库目录不存在时为 false
+     */
+    bool scan(const QString& libraryPath, int threadCount = 0);
+
+    /** 重扫单个资产目录（目录已不存在时从表中移除） */
+    void rescanAsset(const QString& slug);
+
+    QString libraryPath() const;
+
+    /** 是否已完成过一次全量扫描；之前的查询一律视为不可用，调用方自行 stat */
+    bool isReady() const;
+
+    bool contains(const QString& slug) const;
+    bool hasThumbnail(const QString& slug) const;
+    AssetPresence asset(const QString& slug) const;
+    QStringList slugs() const;
+
+    /**
+     * 按表查询文件大小
+     * @param localPath 资产库内的文件路径
+     * @param size 输出：字节数；文件不存在时为 -1
+     * @return 表可用且路径在资产库内时为 true（此时 size 即为准），否则调用方需自行 stat
+     */
+    bool lookup(const QString& localPath, qint64& size) const;
+
+    /** 下载、链接完成后立即登记，不必等目录变化通知 */
+    void recordFile(const QString& localPath, qint64 size);
+
+    /** 需要监视的目录（资产库根目录、各资产目录及其子目录，绝对路径） */
+    QStringList directories() const;
+
+    /**
+     * 扫描单个资产目录（不修改表，可在任意线程调用）
+     * @param assetPath 资产目录
+     * @param presence 输出
+     * @return 目录不存在时为 false
+     */
+    static bool scanAsset(const QString& assetPath, AssetPresence& presence);
+
+private:
+    mutable QMutex m_mutex;
+    QString m_root;
+    bool m_ready = false;
+    QHash<QString, AssetPresence> m_assets;   // slug -> 目录内容
+
+    bool splitLocked(const QString& localPath, QString& slug, QString& relative) const;
+};
+
+#endif // LIBRARY_PRESENCE_H
@@ -0,0 +1,173 @@
+﻿#include "metadata_store.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qsavefile.h>
+
+// 元数据库文件（放在资产库根目录）
+static const char* METADATA_FILE_NAME = ".metadata.jsonl";
+// 旧版每个资产目录下的元数据文件
+static const char* INFO_FILE_NAME = "info.json";
+
+static QByteArray record_line(const QString& slug, const QJsonObject& info)
+{
+    QJsonObject record;
+    record.insert("slug", slug);
+    record.insert("info", info);
+    return QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n';
+}
+
+MetadataStore::~MetadataStore()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void MetadataStore::setLibraryPath(const QString& libraryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString root = libraryPath.isEmpty() ? QString() : QDir(libraryPath).absolutePath();
+    if (root == m_root)
+        return;
+    if (m_file.isOpen())
+        m_file.close();
+    m_root = root;
+    m_entries.clear();
+    if (m_root.isEmpty())
+        return;
+
+    m_file.setFileName(QDir(m_root).filePath(METADATA_FILE_NAME));
+    if (!m_file.exists()) {
+        migrateLocked();
+    }
+    else {
+        // 同一资产反复更新会留下旧行，过半是旧行时压缩一次
+        const int lines = loadLocked();
+        if (lines > 2 * m_entries.size() + 64)
+            rewriteLocked();
+    }
+    m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+QString MetadataStore::libraryPath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_root;
+}
+
+void MetadataStore::setExportInfoJson(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_exportInfoJson = enabled;
+}
+
+/* ---------- 读入：逐行重放，后写的覆盖先写的；返回有效行数 ---------- */
+int MetadataStore::loadLocked()
+{
+    QFile file(m_file.fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    int lines = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        // 崩溃时最后一行可能只写了一半，解析失败的行直接跳过
+        const QJsonObject record = QJsonDocument::fromJson(line).object();
+        const QString slug = record["slug"].toString();
+        if (slug.isEmpty())
+            continue;
+        m_entries.insert(slug, record["info"].toObject());
+        ++lines;
+    }
+    return lines;
+}
+
+/* ---------- 迁移：旧资产库只有各目录下的 info.json，读一遍写成一个文件 ---------- */
+void MetadataStore::migrateLocked()
+{
+    QDir root(m_root);
+    for (const QFileInfo& entry : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile file(QDir(entry.filePath()).filePath(INFO_FILE_NAME));
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        const QJsonObject info = QJsonDocument::fromJson(file.readAll()).object();
+        if (!info.isEmpty())
+            m_entries.insert(entry.fileName(), info);
+    }
+    if (!m_entries.isEmpty())
+        rewriteLocked();
+}
+
+/* ---------- 压缩：每个资产只留一行 ---------- */
+bool MetadataStore::rewriteLocked()
+{
+    QSaveFile file(m_file.fileName());
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it)
+        file.write(record_line(it.key(), it.value()));
+    return file.commit();
+}
+
+bool MetadataStore::contains(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(slug);
+}
+
+QJsonObject MetadataStore::value(const QString& slug) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.value(slug);
+}
+
+QStringList MetadataStore::slugs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.keys();
+}
+
+bool MetadataStore::isStale(const QString& slug, const QJsonObject& listing) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(slug);
+    if (it == m_entries.constEnd())
+        return true;
+    // 列表里没有 files_hash（旧接口、离线缓存）时无从判断，按未过期处理
+    const QString fresh = listing["files_hash"].toString();
+    return !fresh.isEmpty() && fresh != it.value()["files_hash"].toString();
+}
+
+QString MetadataStore::insert(const QString& slug, const QJsonObject& info)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return QString("Metadata store is not open: %1").arg(m_file.fileName());
+    const QByteArray line = record_line(slug, info);
+    if (m_file.write(line) != line.size())
+        return QString("Failed to write metadata for %1: %2").arg(slug).arg(m_file.errorString());
+    m_entries.insert(slug, info);
+
+    if (m_exportInfoJson) {
+        // 同步的元数据阶段不建资产目录，新资产的目录在这里先建出来
+        const QDir assetDir(QDir(m_root).filePath(slug));
+        if (!assetDir.exists() && !assetDir.mkpath("."))
+            return QString("Failed to create asset directory: %1").arg(assetDir.path());
+        QSaveFile infoFile(assetDir.filePath(INFO_FILE_NAME));
+        if (!infoFile.open(QIODevice::WriteOnly | QIODevice::Text))
+            return QString("Failed to write info.json for %1: %2").arg(slug).arg(infoFile.errorString());
+        infoFile.write(QJsonDocument(info).toJson(QJsonDocument::Indented));
+        if (!infoFile.commit())
+            return QString("Failed to write info.json for %1: %2").arg(slug).arg(infoFile.errorString());
+    }
+    return "";
+}
+
+void MetadataStore::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen())
+        m_file.flush();
+}
@@ -0,0 +1,76 @@
+﻿#ifndef METADATA_STORE_H
+#define METADATA_STORE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qjsonobject.h>
+
+/**
+ * 资产元数据库（<资产库>/.metadata.jsonl）
+ * 每个资产的列表条目 + /files 清单合在一个对象里，每次写入追加一行 {"slug", "info"}，同一 slug 以最后一行为准；
+ * 打开时整库读入内存索引，之后的存在性和过期判断都不再碰磁盘。
+ * 首次打开旧资产库时从各资产目录的 info.json 迁移；可选地继续导出 info.json 给外部工具用。
+ * 所有接口线程安全。
+ */
+class MetadataStore
+{
+public:
+    MetadataStore() = default;
+    ~MetadataStore();
+
+    MetadataStore(const MetadataStore&) = delete;
+    MetadataStore& operator=(const MetadataStore&) = delete;
+
+    /**
+     * 切换资产库（与当前不同时重新读入；没有元数据库时从 info.json 迁移）
+     * @param libraryPath 资产库根目录
+     */
+    void setLibraryPath(const QString& libraryPath);
+    QString libraryPath() const;
+
+    /** 写入时是否同时导出 <资产目录>/info.json（默认不导出） */
+    void setExportInfoJson(bool enabled);
+
+    bool contains(const QString& slug) const;
+
+    /** 资产的元数据（列表条目 + "files" 清单）；没有时为空对象 */
+    QJsonObject value(const QString& slug) const;
+
+    /** 已记录的全部 slug */
+    QStringList slugs() const;
+
+    /**
+     * 已记录的清单是否过期：列表条目的 files_hash 与记录时不同，说明 Poly Haven 更新了文件
+     * @param slug 资产 slug
+     * @param listing 本次拉到的列表条目
+     * @return 没有记录或 files_hash 变化时为 true
+     */
+    bool isStale(const QString& slug, const QJsonObject& listing) const;
+
+    /**
+     * 记录资产的元数据（追加一行并更新索引）
+     * @param slug 资产 slug
+     * @param info 列表条目 + "files" 清单
+     * @return 错误信息；成功返回空字符串
+     */
+    QString insert(const QString& slug, const QJsonObject& info);
+
+    /** 把追加的记录刷到磁盘 */
+    void flush();
+
+private:
+    mutable QMutex m_mutex;
+    QString m_root;
+    QFile m_file;
+    QHash<QString, QJsonObject> m_entries;   // slug -> 元数据
+    bool m_exportInfoJson = false;
+
+    int loadLocked();
+    void migrateLocked();
+    bool rewriteLocked();
+};
+
+#endif // METADATA_STORE_H
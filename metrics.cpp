@@ -0,0 +1,195 @@
+﻿#include "metrics.h"
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QMutex>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <memory>
+
+/* ---------- MetricHistogram ---------- */
+MetricHistogram::MetricHistogram()
+    : m_min(std::numeric_limits<qint64>::max())
+{
+    for (std::atomic<qint64>& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+// 小于 16 的值各占一格；之后每个 [2^e, 2^(e+1)) 按最高 4 位之后的位等分 16 格
+int MetricHistogram::bucketIndex(qint64 value)
+{
+    const quint64 v = value > 0 ? quint64(value) : 0;
+    if (v < quint64(SUB_BUCKETS))
+        return int(v);
+    int exponent = 63;
+    while (!(v >> exponent))
+        --exponent;
+    const int shift = exponent - SUB_BUCKET_BITS;
+    const int mantissa = int((v >> shift) & (SUB_BUCKETS - 1));
+    return (shift + 1) * SUB_BUCKETS + mantissa;
+}
+
+qint64 MetricHistogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+    const int shift = index / SUB_BUCKETS - 1;
+    const quint64 lower = quint64(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    const quint64 upper = lower + (quint64(1) << shift) - 1;
+    return upper > quint64(std::numeric_limits<qint64>::max()) ? std::numeric_limits<qint64>::max() : qint64(upper);
+}
+
+void MetricHistogram::record(qint64 value)
+{
+    value = qMax<qint64>(0, value);
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    qint64 current = m_min.load(std::memory_order_relaxed);
+    while (value < current && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+    current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+qint64 MetricHistogram::min() const
+{
+    const qint64 value = m_min.load(std::memory_order_relaxed);
+    return value == std::numeric_limits<qint64>::max() ? 0 : value;
+}
+
+qint64 MetricHistogram::percentile(double quantile) const
+{
+    // 各格计数与总数不是同一时刻读的：以各格之和为准
+    qint64 counts[BUCKET_COUNT];
+    qint64 total = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0)
+        return 0;
+
+    const qint64 rank = qMax<qint64>(1, qint64(qBound(0.0, quantile, 1.0) * double(total) + 0.5));
+    qint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts[i];
+        if (seen >= rank)
+            return qMin(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+QJsonObject MetricHistogram::toJson() const
+{
+    const qint64 n = count();
+    QJsonObject obj;
+    obj["count"] = n;
+    obj["sum"] = sum();
+    obj["min"] = min();
+    obj["max"] = max();
+    obj["mean"] = n > 0 ? double(sum()) / double(n) : 0.0;
+    obj["p50"] = percentile(0.50);
+    obj["p90"] = percentile(0.90);
+    obj["p99"] = percentile(0.99);
+    obj["p999"] = percentile(0.999);
+    return obj;
+}
+
+/* ---------- 注册表 ---------- */
+namespace {
+
+struct MetricsRegistry {
+    QMutex mutex;
+    // 按名字排序，导出和面板都按名字分组显示
+    std::map<QString, std::unique_ptr<MetricCounter>> counters;
+    std::map<QString, std::unique_ptr<MetricGauge>> gauges;
+    std::map<QString, std::unique_ptr<MetricHistogram>> histograms;
+    QElapsedTimer uptime;
+
+    MetricsRegistry() { uptime.start(); }
+
+    bool taken(const QString& name) const
+    {
+        return counters.count(name) || gauges.count(name) || histograms.count(name);
+    }
+};
+
+// 函数内静态：其他翻译单元的静态初始化里也可以安全注册
+MetricsRegistry& registry()
+{
+    static MetricsRegistry* instance = new MetricsRegistry;
+    return *instance;
+}
+
+template <typename T>
+T* find_or_create(MetricsRegistry& reg, std::map<QString, std::unique_ptr<T>>& metrics, const QString& name)
+{
+    QMutexLocker locker(&reg.mutex);
+    auto it = metrics.find(name);
+    if (it != metrics.end())
+        return it->second.get();
+    if (reg.taken(name))
+        return nullptr;
+    T* metric = new T;
+    metrics.emplace(name, std::unique_ptr<T>(metric));
+    return metric;
+}
+
+} // namespace
+
+MetricCounter* metrics_counter(const QString& name)
+{
+    return find_or_create(registry(), registry().counters, name);
+}
+
+MetricGauge* metrics_gauge(const QString& name)
+{
+    return find_or_create(registry(), registry().gauges, name);
+}
+
+MetricHistogram* metrics_histogram(const QString& name)
+{
+    return find_or_create(registry(), registry().histograms, name);
+}
+
+QJsonObject metrics_snapshot()
+{
+    MetricsRegistry& reg = registry();
+    QMutexLocker locker(&reg.mutex);
+
+    QJsonObject counters;
+    for (const auto& entry : reg.counters)
+        counters[entry.first] = entry.second->value();
+    QJsonObject gauges;
+    for (const auto& entry : reg.gauges)
+        gauges[entry.first] = entry.second->value();
+    QJsonObject histograms;
+    for (const auto& entry : reg.histograms)
+        histograms[entry.first] = entry.second->toJson();
+
+    QJsonObject snapshot;
+    snapshot["uptime_ms"] = reg.uptime.elapsed();
+    snapshot["counters"] = counters;
+    snapshot["gauges"] = gauges;
+    snapshot["histograms"] = histograms;
+    return snapshot;
+}
+
+QString metrics_write_file(const QString& path)
+{
+    const QByteArray json = QJsonDocument(metrics_snapshot()).toJson(QJsonDocument::Indented);
+    if (path == "-") {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        std::fflush(stdout);
+        return QString();
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return QString("Failed to open metrics file %1: %2").arg(path, file.errorString());
+    if (file.write(json) != json.size())
+        return QString("Failed to write metrics file %1: %2").arg(path, file.errorString());
+    return QString();
+}
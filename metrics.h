@@ -0,0 +1,123 @@
+﻿#ifndef METRICS_H
+#define METRICS_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qelapsedtimer.h>
+#include <atomic>
+
+/**
+ * 进程内指标：计数器、瞬时值和延迟直方图，供调并发、核算带宽使用
+ * 指标按名字注册一次、永不释放，返回的指针可以缓存在调用点（函数内 static）；
+ * 记录只做原子加减，不加锁。浏览器里的统计面板定时读取，命令行结束时可导出为 JSON。
+ * 命名：<模块>.<指标>[.<主机>]，时间类指标以 _us 结尾（微秒）。
+ */
+
+/** 单调递增的计数器 */
+class MetricCounter
+{
+public:
+    void add(qint64 delta = 1) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value{ 0 };
+};
+
+/** 瞬时值（正在进行的传输数、并发窗口等） */
+class MetricGauge
+{
+public:
+    void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(qint64 delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value{ 0 };
+};
+
+/**
+ * HDR 式对数-线性直方图：每个 2 的幂区间再等分 16 格，相对误差不超过 1/16，
+ * 覆盖 0 ~ 2^63 不需要预设量程；每格一个原子计数，记录不加锁。
+ */
+class MetricHistogram
+{
+public:
+    MetricHistogram();
+
+    /** 记录一个样本（负数按 0 记） */
+    void record(qint64 value);
+
+    qint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    qint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+    qint64 min() const;
+    qint64 max() const { return m_max.load(std::memory_order_relaxed); }
+
+    /**
+     * 分位数（所在格的上界，偏保守）
+     * @param quantile 0~1
+     * @return 没有样本时为 0
+     */
+    qint64 percentile(double quantile) const;
+
+    /** count / sum / min / max / mean / p50 / p90 / p99 / p999 */
+    QJsonObject toJson() const;
+
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketUpperBound(int index);
+
+private:
+    std::atomic<qint64> m_buckets[BUCKET_COUNT];
+    std::atomic<qint64> m_count{ 0 };
+    std::atomic<qint64> m_sum{ 0 };
+    std::atomic<qint64> m_min;
+    std::atomic<qint64> m_max{ 0 };
+};
+
+/** 作用域计时：析构时把经过的微秒数记入直方图（直方图为空时什么都不做） */
+class MetricTimer
+{
+public:
+    explicit MetricTimer(MetricHistogram* histogram)
+        : m_histogram(histogram)
+    {
+        m_timer.start();
+    }
+    ~MetricTimer()
+    {
+        if (m_histogram)
+            m_histogram->record(m_timer.nsecsElapsed() / 1000);
+    }
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+private:
+    MetricHistogram* m_histogram;
+    QElapsedTimer m_timer;
+};
+
+/**
+ * 按名字取指标，不存在时注册（加锁查找：高频调用点应把返回值缓存到 static）
+ * 同一个名字只能注册为一种类型，类型不符时返回 nullptr
+ */
+MetricCounter* metrics_counter(const QString& name);
+MetricGauge* metrics_gauge(const QString& name);
+MetricHistogram* metrics_histogram(const QString& name);
+
+/** 所有指标的快照：{"uptime_ms", "counters": {...}, "gauges": {...}, "histograms": {name: {...}}} */
+QJsonObject metrics_snapshot();
+
+/**
+ * 把快照写成 JSON
+ * @param path 文件路径；"-" 表示 stdout
+ * @return 错误信息（空表示成功）
+ */
+QString metrics_write_file(const QString& path);
+
+#endif // METRICS_H
@@ -0,0 +1,45 @@
+﻿#include "service_urls.h"
+#include <QtCore/qmutex.h>
+
+static const char* DEFAULT_API_BASE_URL = "https://api.polyhaven.com";
+static const char* DEFAULT_CDN_BASE_URL = "https://cdn.polyhaven.com";
+
+// 注入的地址；为空时取环境变量或默认值
+static QMutex s_urlMutex;
+static QString s_apiBaseUrl;
+static QString s_cdnBaseUrl;
+
+static QString normalized(const QString& url)
+{
+    QString out = url.trimmed();
+    while (out.endsWith('/'))
+        out.chop(1);
+    return out;
+}
+
+static QString resolve(const QString& injected, const char* envName, const char* fallback)
+{
+    if (!injected.isEmpty())
+        return injected;
+    const QString env = normalized(qEnvironmentVariable(envName));
+    return env.isEmpty() ? QString::fromLatin1(fallback) : env;
+}
+
+QString api_base_url()
+{
+    QMutexLocker locker(&s_urlMutex);
+    return resolve(s_apiBaseUrl, "PH_API_BASE_URL", DEFAULT_API_BASE_URL);
+}
+
+QString cdn_base_url()
+{
+    QMutexLocker locker(&s_urlMutex);
+    return resolve(s_cdnBaseUrl, "PH_CDN_BASE_URL", DEFAULT_CDN_BASE_URL);
+}
+
+void set_service_base_urls(const QString& api, const QString& cdn)
+{
+    QMutexLocker locker(&s_urlMutex);
+    s_apiBaseUrl = normalized(api);
+    s_cdnBaseUrl = normalized(cdn);
+}
@@ -0,0 +1,26 @@
+﻿#ifndef SERVICE_URLS_H
+#define SERVICE_URLS_H
+
+#include <QtCore/qstring.h>
+
+/**
+ * Poly Haven 服务根地址
+ * 默认为官方地址；可由环境变量 PH_API_BASE_URL / PH_CDN_BASE_URL 覆盖，
+ * 或由配置（ApiBaseUrl / CdnBaseUrl）注入，指向镜像站或本地假服务器（bench/fake_polyhaven_server）。
+ * 所有接口线程安全。
+ */
+
+/** API 根地址（/assets、/files/<slug>），不带末尾斜杠 */
+QString api_base_url();
+
+/** 缩略图 CDN 根地址（/asset_img/thumbs/<slug>.png），不带末尾斜杠 */
+QString cdn_base_url();
+
+/**
+ * 注入根地址
+ * @param api API 根地址（空字符串表示恢复默认）
+ * @param cdn CDN 根地址（空字符串表示恢复默认）
+ */
+void set_service_base_urls(const QString& api, const QString& cdn);
+
+#endif // SERVICE_URLS_H
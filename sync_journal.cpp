@@ -0,0 +1,258 @@
+﻿#include "sync_journal.h"
+#include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qsavefile.h>
+
+// 日志文件（放在资产库根目录）
+static const char* JOURNAL_FILE_NAME = ".sync-journal.jsonl";
+
+static QJsonObject file_record(const SyncFile& file)
+{
+    QJsonObject record;
+    record.insert("op", "plan");
+    record.insert("slug", file.slug);
+    record.insert("url", file.url);
+    record.insert("path", file.localPath);
+    record.insert("size", double(file.size));
+    record.insert("md5", file.md5);
+    if (file.stale)
+        record.insert("stale", true);
+    return record;
+}
+
+SyncJournal::~SyncJournal()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+QString SyncJournal::partPath(const QString& localPath)
+{
+    return localPath + ".part";
+}
+
+bool SyncJournal::open(const QString& libraryPath)
+{
+    QMutexLocker locker(&m_mutex);
+    if (libraryPath.isEmpty())
+        return false;
+    const QString path = QDir(libraryPath).filePath(JOURNAL_FILE_NAME);
+    if (path == m_path && m_file.isOpen())
+        return true;
+
+    if (m_file.isOpen())
+        m_file.close();
+    m_path = path;
+    m_order.clear();
+    m_pending.clear();
+    m_offsets.clear();
+    replayLocked();
+
+    m_file.setFileName(m_path);
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+void SyncJournal::replayLocked()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        // 崩溃时最后一行可能只写了一半，解析失败的行直接跳过
+        const QJsonDocument doc = QJsonDocument::fromJson(line);
+        if (doc.isObject())
+            applyLocked(doc.object());
+    }
+}
+
+void SyncJournal::applyLocked(const QJsonObject& record)
+{
+    const QString op = record["op"].toString();
+    const QString path = record["path"].toString();
+    if (op == "run") {
+        m_order.clear();
+        m_pending.clear();
+        m_offsets.clear();
+    }
+    else if (op == "plan" && !path.isEmpty()) {
+        SyncFile file;
+        file.slug = record["slug"].toString();
+        file.url = record["url"].toString();
+        file.localPath = path;
+        file.size = qint64(record["size"].toDouble());
+        file.md5 = record["md5"].toString();
+        file.stale = record["stale"].toBool();
+        if (!m_pending.contains(path))
+            m_order.append(path);
+        m_pending.insert(path, file);
+    }
+    else if (op == "part") {
+        m_offsets.insert(path, qint64(record["offset"].toDouble()));
+    }
+    else if (op == "done") {
+        m_pending.remove(path);
+        m_offsets.remove(path);
+    }
+    // fail：保持未完成，下次继续
+}
+
+void SyncJournal::appendLocked(const QJsonObject& record)
+{
+    if (!m_file.isOpen())
+        return;
+    applyLocked(record);
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    m_file.write(line);
+    // 只 flush 到系统缓冲：进程崩溃不丢，断电最多丢最后几条（文件本体 .part 仍在）
+    m_file.flush();
+}
+
+QVector<SyncFile> SyncJournal::pendingFiles() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<SyncFile> files;
+    for (const QString& path : m_order) {
+        auto it = m_pending.constFind(path);
+        if (it != m_pending.constEnd())
+            files.append(it.value());
+    }
+    return files;
+}
+
+qint64 SyncJournal::pendingOffset(const QString& localPath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_offsets.value(localPath, 0);
+}
+
+void SyncJournal::beginRun()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return;
+    rewriteLocked();
+}
+
+void SyncJournal::settleAsset(const QString& slug, const QVector<SyncFile>& planned)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return;
+    QSet<QString> plannedPaths;
+    for (const SyncFile& file : planned)
+        plannedPaths.insert(file.localPath);
+    for (const QString& path : m_order) {
+        auto it = m_pending.constFind(path);
+        if (it == m_pending.constEnd() || it.value().slug != slug || plannedPaths.contains(path))
+            continue;
+        QJsonObject record;
+        record.insert("op", "done");
+        record.insert("path", path);
+        appendLocked(record);
+    }
+}
+
+void SyncJournal::recordPlanned(const QVector<SyncFile>& files)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen() || files.isEmpty())
+        return;
+    QByteArray lines;
+    for (const SyncFile& file : files) {
+        const QJsonObject record = file_record(file);
+        applyLocked(record);
+        lines += QJsonDocument(record).toJson(QJsonDocument::Compact);
+        lines += '\n';
+    }
+    m_file.write(lines);
+    m_file.flush();
+}
+
+void SyncJournal::recordProgress(const QString& localPath, qint64 offset)
+{
+    QJsonObject record;
+    record.insert("op", "part");
+    record.insert("path", localPath);
+    record.insert("offset", double(offset));
+    QMutexLocker locker(&m_mutex);
+    appendLocked(record);
+}
+
+void SyncJournal::recordCompleted(const QString& localPath)
+{
+    QJsonObject record;
+    record.insert("op", "done");
+    record.insert("path", localPath);
+    QMutexLocker locker(&m_mutex);
+    appendLocked(record);
+}
+
+void SyncJournal::recordFailed(const QString& localPath, const QString& error)
+{
+    QJsonObject record;
+    record.insert("op", "fail");
+    record.insert("path", localPath);
+    record.insert("error", error);
+    QMutexLocker locker(&m_mutex);
+    appendLocked(record);
+}
+
+void SyncJournal::finishRun()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return;
+    if (m_pending.isEmpty()) {
+        // 下次 open 时重新创建
+        m_file.close();
+        QFile::remove(m_path);
+        m_order.clear();
+        m_offsets.clear();
+        return;
+    }
+    rewriteLocked();
+}
+
+/* ---------- 压缩：只保留未完成文件的 plan / part 记录 ---------- */
+void SyncJournal::rewriteLocked()
+{
+    QByteArray lines;
+    QJsonObject run;
+    run.insert("op", "run");
+    run.insert("time", double(QDateTime::currentSecsSinceEpoch()));
+    lines += QJsonDocument(run).toJson(QJsonDocument::Compact) + '\n';
+
+    QVector<QString> order;
+    for (const QString& path : m_order) {
+        auto it = m_pending.constFind(path);
+        if (it == m_pending.constEnd())
+            continue;
+        order.append(path);
+        lines += QJsonDocument(file_record(it.value())).toJson(QJsonDocument::Compact) + '\n';
+        if (m_offsets.contains(path)) {
+            QJsonObject part;
+            part.insert("op", "part");
+            part.insert("path", path);
+            part.insert("offset", double(m_offsets.value(path)));
+            lines += QJsonDocument(part).toJson(QJsonDocument::Compact) + '\n';
+        }
+    }
+    m_order = order;
+
+    // 先写临时文件再替换：截断和写入之间崩溃会丢掉全部未完成记录。
+    // 替换失败时旧日志原样保留，重放结果不变，继续往里追加即可
+    m_file.close();
+    QSaveFile file(m_path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(lines);
+        file.commit();
+    }
+    m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
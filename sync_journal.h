@@ -0,0 +1,87 @@
+﻿#ifndef SYNC_JOURNAL_H
+#define SYNC_JOURNAL_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qset.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qjsonobject.h>
+#include "sync_plan.h"
+
+/**
+ * 同步任务日志（<资产库>/.sync-journal.jsonl，只追加）
+ * 每行一条记录：run（一次拉取开始）、plan（计划中的文件）、part（部分文件的字节偏移）、
+ * done（完成）、fail（失败，下次继续）。崩溃、关闭 Houdini 或取消后，
+ * 下次打开时重放日志即可得到未完成的文件，直接进入本体下载，不必重新拉列表和清单。
+ * 文件本体先写到 <路径>.part，完成后改名；续传以磁盘上 .part 的大小为准，日志里的偏移是检查点。
+ * 所有接口线程安全。
+ */
+class SyncJournal
+{
+public:
+    SyncJournal() = default;
+    ~SyncJournal();
+
+    SyncJournal(const SyncJournal&) = delete;
+    SyncJournal& operator=(const SyncJournal&) = delete;
+
+    /**
+     * 打开资产库的日志并重放（已打开同一资产库时什么都不做）
+     * @param libraryPath 资产库根目录
+     * @return 是否成功打开
+     */
+    bool open(const QString& libraryPath);
+
+    /** 上次中断时未完成的文件（按计划顺序） */
+    QVector<SyncFile> pendingFiles() const;
+
+    /** 未完成文件中已写入 .part 的字节数（按日志检查点） */
+    qint64 pendingOffset(const QString& localPath) const;
+
+    /**
+     * 开始新的一次拉取：日志压缩为上次仍未完成的文件，这些文件在本次重新规划后由 settleAsset 了结；
+     * 本次没有涉及的资产（类型或 slug 过滤）的未完成文件保留，下次仍可续传
+     */
+    void beginRun();
+
+    /**
+     * 资产已重新规划：该资产下不在新计划里的未完成文件视为已了结（本地已完整，或不再是下载目标）
+     * @param slug 资产 slug
+     * @param planned 本次为该资产规划的文件
+     */
+    void settleAsset(const QString& slug, const QVector<SyncFile>& planned);
+
+    /** 记录一批计划中的文件（一次写入、一次 flush） */
+    void recordPlanned(const QVector<SyncFile>& files);
+
+    /** 记录部分文件的字节偏移 */
+    void recordProgress(const QString& localPath, qint64 offset);
+
+    void recordCompleted(const QString& localPath);
+    void recordFailed(const QString& localPath, const QString& error);
+
+    /**
+     * 拉取结束：日志压缩为只含仍未完成的文件；全部完成时删除日志
+     */
+    void finishRun();
+
+    /** .part 路径 */
+    static QString partPath(const QString& localPath);
+
+private:
+    mutable QMutex m_mutex;
+    QString m_path;
+    QFile m_file;
+    QVector<QString> m_order;                  // 计划顺序（含已完成的，读取时跳过）
+    QHash<QString, SyncFile> m_pending;        // localPath -> 文件
+    QHash<QString, qint64> m_offsets;          // localPath -> 检查点偏移
+
+    void replayLocked();
+    void applyLocked(const QJsonObject& record);
+    void appendLocked(const QJsonObject& record);
+    void rewriteLocked();
+};
+
+#endif // SYNC_JOURNAL_H
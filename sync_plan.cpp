@@ -0,0 +1,335 @@
+﻿#include "sync_plan.h"
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qurl.h>
+#include <algorithm>
+#include <climits>
+
+void SyncPlan::addAsset(const QVector<SyncFile>& assetFiles)
+{
+    if (assetFiles.isEmpty()) {
+        ++upToDateAssets;
+        return;
+    }
+    ++plannedAssets;
+    for (const SyncFile& file : assetFiles) {
+        files.append(file);
+        if (file.inStore) {
+            ++storeHits;
+            continue;
+        }
+        totalBytes += file.size;
+        if (file.stale)
+            ++staleCount;
+    }
+}
+
+void SyncPlan::clear()
+{
+    *this = SyncPlan();
+}
+
+QString SyncPlan::summary() const
+{
+    return QString("%1 files (%2) to transfer for %3 assets: %4 missing, %5 stale, %6 linked from store; %7 assets up to date")
+        .arg(files.size() - storeHits)
+        .arg(format_bytes(totalBytes))
+        .arg(plannedAssets)
+        .arg(files.size() - staleCount - storeHits)
+        .arg(staleCount)
+        .arg(storeHits)
+        .arg(upToDateAssets);
+}
+
+QString select_hdri_file(const QString& slug, const QJsonObject& infoJson, const QString& res,
+    const QString& format, QJsonObject& fileJson)
+{
+    //TODO 有些info.json层级不一样 不知道为什么
+    if (!infoJson.contains("files") || !infoJson["files"].isObject()) {
+        return QString("Asset %1 has no 'hdri' node in info.json").arg(slug);
+    }
+
+    QJsonObject filesJson = infoJson["files"].toObject();
+    if (!filesJson.contains("hdri") || !filesJson["hdri"].isObject()) {
+        return QString("Asset %1 has no '%2' hdri in files").arg(slug).arg("hdri");
+    }
+
+    QJsonObject hdriJson = filesJson["hdri"].toObject();
+    if (!hdriJson.contains(res) || !hdriJson[res].isObject()) {
+        return QString("Asset %1 has no '%2' quality in hdri").arg(slug).arg(res);
+    }
+
+    QJsonObject qualityJson = hdriJson[res].toObject();
+    if (!qualityJson.contains(format) || !qualityJson[format].isObject()) {
+        return QString("Asset %1 has no '%2' format in %3 quality").arg(slug).arg(format).arg(res);
+    }
+
+    fileJson = qualityJson[format].toObject();
+    if (fileJson["url"].toString().isEmpty()) {
+        return QString("Asset %1 has empty URL for %2-%3").arg(slug).arg(res).arg(format);
+    }
+    return "";
+}
+
+// 带 include 树的打包格式，其余 format 视为贴图格式
+static bool is_package_format(const QString& format)
+{
+    static const QStringList formats = { "blend", "gltf", "fbx", "usd", "mtlx" };
+    return formats.contains(format);
+}
+
+QString select_manifest_files(const QString& slug, const QJsonObject& infoJson, const DownloadTarget& target,
+    QVector<ManifestEntry>& entries)
+{
+    const QJsonObject filesJson = infoJson["files"].toObject();
+    if (filesJson.isEmpty()) {
+        return QString("Asset %1 has no 'files' node in info.json").arg(slug);
+    }
+
+    const auto fileName = [](const QJsonObject& fileJson) {
+        return QFileInfo(QUrl(fileJson["url"].toString()).path()).fileName();
+    };
+
+    if (is_package_format(target.format)) {
+        const QJsonObject node = filesJson[target.format].toObject()[target.res].toObject()[target.format].toObject();
+        if (node["url"].toString().isEmpty()) {
+            return QString("Asset %1 has no '%2' package at %3").arg(slug).arg(target.format).arg(target.res);
+        }
+        entries.append({ fileName(node), node });
+
+        // include 的 key 就是主文件引用它时用的相对路径（如 textures/xxx_diff_1k.jpg）
+        const QJsonObject includes = node["include"].toObject();
+        for (auto it = includes.constBegin(); it != includes.constEnd(); ++it) {
+            // 相对路径不允许跳出资产目录
+            if (it.key().contains("..") || QDir::isAbsolutePath(it.key()))
+                continue;
+            const QJsonObject include = it.value().toObject();
+            if (!include["url"].toString().isEmpty())
+                entries.append({ it.key(), include });
+        }
+        return "";
+    }
+
+    for (auto it = filesJson.constBegin(); it != filesJson.constEnd(); ++it) {
+        if (is_package_format(it.key()))
+            continue;
+        const QJsonObject fileJson = it.value().toObject()[target.res].toObject()[target.format].toObject();
+        if (!fileJson["url"].toString().isEmpty())
+            entries.append({ fileName(fileJson), fileJson });
+    }
+    if (entries.isEmpty()) {
+        return QString("Asset %1 has no '%2' maps at %3").arg(slug).arg(target.format).arg(target.res);
+    }
+    return "";
+}
+
+// 本地文件大小：在库表可用时查表，否则 stat；不存在返回 -1
+static qint64 local_file_size(const QString& localPath, const LibraryPresence* presence)
+{
+    qint64 size = -1;
+    if (presence && presence->lookup(localPath, size))
+        return size;
+    QFileInfo local(localPath);
+    return local.exists() ? local.size() : -1;
+}
+
+QString plan_asset_files(const QString& slug, const QDir& assetDir, const QJsonObject& infoJson,
+    const QVector<DownloadTarget>& targets, QVector<SyncFile>& files, QStringList& skipped,
+    const ContentStore* store, const HashCache* hashes, const LibraryPresence* presence)
+{
+    const int assetType = infoJson["type"].toInt();
+    QStringList errors;
+    QStringList plannedPaths;
+    int available = 0;
+
+    for (const DownloadTarget& target : targets) {
+        if (target.assetType >= 0 && target.assetType != assetType)
+            continue;
+
+        QVector<ManifestEntry> entries;
+        QString err;
+        if (assetType == 0) {
+            QJsonObject fileJson;
+            err = select_hdri_file(slug, infoJson, target.res, target.format, fileJson);
+            if (err.isEmpty()) {
+                QString fileName = QFileInfo(QUrl(fileJson["url"].toString()).path()).fileName();//xxx_1k.hdr
+                if (fileName.isEmpty()) {
+                    fileName = QString("%1_%2.%3").arg(slug).arg(target.res).arg(target.format);
+                }
+                entries.append({ fileName, fileJson });
+            }
+        }
+        else {
+            err = select_manifest_files(slug, infoJson, target, entries);
+        }
+        if (!err.isEmpty()) {
+            errors.append(err);
+            continue;
+        }
+        ++available;
+
+        for (const ManifestEntry& entry : entries) {
+            SyncFile file;
+            file.slug = slug;
+            file.url = entry.fileJson["url"].toString();
+            file.size = qint64(entry.fileJson["size"].toDouble());
+            file.md5 = entry.fileJson["md5"].toString();
+            file.localPath = assetDir.filePath(entry.relativePath);
+            // 多个目标（如 gltf 与 jpg 贴图）引用同一文件时只计一次
+            if (plannedPaths.contains(file.localPath))
+                continue;
+            plannedPaths.append(file.localPath);
+
+            const qint64 localSize = local_file_size(file.localPath, presence);
+            if (localSize > 0) {
+                // 清单没给大小时只要本地非空就视为已有；校验记录过内容不符的除外
+                QString cachedMd5;
+                const bool corrupt = hashes && !file.md5.isEmpty() && hashes->lookup(file.localPath, cachedMd5)
+                    && cachedMd5.compare(file.md5, Qt::CaseInsensitive) != 0;
+                if ((file.size <= 0 || localSize == file.size) && !corrupt)
+                    continue;
+                file.stale = true;
+            }
+            // 本地内容已坏时仓库里的 blob 可能就是同一份，重新下载
+            file.inStore = !file.stale && store && store->contains(file.md5, file.size);
+            files.append(file);
+        }
+    }
+
+    if (available == 0) {
+        if (errors.isEmpty())
+            return QString("No download target configured for asset %1 (type %2)").arg(slug).arg(assetType);
+        return errors.join("; ");
+    }
+    skipped = errors;
+    return "";
+}
+
+// 递归遍历清单：带 url 的对象是文件节点，其 include 的 key 即相对路径
+static void collect_manifest_node(const QString& slug, const QDir& assetDir, const QString& relativePath,
+    const QJsonObject& node, QStringList& seen, QVector<SyncFile>& files, const LibraryPresence* presence)
+{
+    const QString url = node["url"].toString();
+    if (url.isEmpty()) {
+        for (auto it = node.constBegin(); it != node.constEnd(); ++it) {
+            if (it.value().isObject())
+                collect_manifest_node(slug, assetDir, QString(), it.value().toObject(), seen, files, presence);
+        }
+        return;
+    }
+
+    const QString rel = relativePath.isEmpty() ? QFileInfo(QUrl(url).path()).fileName() : relativePath;
+    SyncFile file;
+    file.slug = slug;
+    file.url = url;
+    file.size = qint64(node["size"].toDouble());
+    file.md5 = node["md5"].toString();
+    file.localPath = assetDir.filePath(rel);
+    if (!rel.isEmpty() && !file.md5.isEmpty() && !seen.contains(file.localPath)
+        && local_file_size(file.localPath, presence) >= 0) {
+        seen.append(file.localPath);
+        files.append(file);
+    }
+
+    const QJsonObject includes = node["include"].toObject();
+    for (auto it = includes.constBegin(); it != includes.constEnd(); ++it) {
+        if (it.key().contains("..") || QDir::isAbsolutePath(it.key()))
+            continue;
+        collect_manifest_node(slug, assetDir, it.key(), it.value().toObject(), seen, files, presence);
+    }
+}
+
+void collect_local_manifest_files(const QString& slug, const QDir& assetDir, const QJsonObject& infoJson,
+    QVector<SyncFile>& files, const LibraryPresence* presence)
+{
+    QStringList seen;
+    collect_manifest_node(slug, assetDir, QString(), infoJson["files"].toObject(), seen, files, presence);
+}
+
+// "4k" -> 4；无法识别的排在最后
+static int target_resolution_rank(const QString& res)
+{
+    bool ok = false;
+    int k = res.left(res.size() - 1).toInt(&ok);
+    return ok && res.endsWith('k', Qt::CaseInsensitive) ? k : INT_MAX;
+}
+
+void sort_download_targets(QVector<DownloadTarget>& targets)
+{
+    QVector<DownloadTarget> unique;
+    for (const DownloadTarget& t : targets) {
+        if (!unique.contains(t))
+            unique.append(t);
+    }
+    std::stable_sort(unique.begin(), unique.end(), [](const DownloadTarget& a, const DownloadTarget& b) {
+        return target_resolution_rank(a.res) < target_resolution_rank(b.res);
+    });
+    targets = unique;
+}
+
+// 省略类型前缀时按格式推断：对所有类型生效的目标会让 "4k:exr" 同时拉取贴图和模型的全部 exr 贴图，
+// "1k:hdr" 则在每个贴图 / 模型上报错。推断不出的格式须写明类型
+static int infer_asset_type(const QString& format)
+{
+    static const QStringList hdriFormats = { "hdr", "exr" };
+    static const QStringList textureFormats = { "jpg", "png", "mtlx" };
+    static const QStringList modelFormats = { "gltf", "blend", "fbx", "usd" };
+    if (hdriFormats.contains(format))
+        return 0;
+    if (textureFormats.contains(format))
+        return 1;
+    if (modelFormats.contains(format))
+        return 2;
+    return -1;
+}
+
+QVector<DownloadTarget> parse_download_targets(const QString& text)
+{
+    QVector<DownloadTarget> targets;
+    static const QStringList typeNames = { "hdris", "textures", "models" };
+    for (const QString& item : text.split(',', Qt::SkipEmptyParts)) {
+        QStringList parts = item.trimmed().toLower().split(':');
+        for (QString& part : parts)
+            part = part.trimmed();
+
+        DownloadTarget target;
+        if (parts.size() == 3) {
+            target.assetType = int(typeNames.indexOf(parts.takeFirst()));
+            if (target.assetType < 0)
+                continue;
+        }
+        if (parts.size() != 2 || parts[0].isEmpty() || parts[1].isEmpty())
+            continue;
+        target.res = parts[0];
+        target.format = parts[1];
+        if (target.assetType < 0)
+            target.assetType = infer_asset_type(target.format);
+        if (target.assetType < 0)
+            continue;
+        targets.append(target);
+    }
+    sort_download_targets(targets);
+    return targets;
+}
+
+QString format_bytes(qint64 bytes)
+{
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    double value = double(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 4) {
+        value /= 1024.0;
+        ++unit;
+    }
+    return unit == 0 ? QString("%1 B").arg(bytes)
+                     : QString("%1 %2").arg(value, 0, 'f', 1).arg(units[unit]);
+}
+
+QString format_duration(qint64 seconds)
+{
+    if (seconds < 0)
+        return "--:--";
+    const qint64 h = seconds / 3600;
+    const qint64 m = (seconds % 3600) / 60;
+    const qint64 s = seconds % 60;
+    return QString("%1:%2:%3").arg(h).arg(m, 2, 10, QChar('0')).arg(s, 2, 10, QChar('0'));
+}
@@ -0,0 +1,139 @@
+﻿#ifndef SYNC_PLAN_H
+#define SYNC_PLAN_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qdir.h>
+#include <QtCore/qstringlist.h>
+#include "content_store.h"
+#include "hash_cache.h"
+#include "library_presence.h"
+
+/**
+ * 下载目标：一组（分辨率, 格式），例如 1k/hdr、4k/exr
+ * textures/models 的 format 可以是贴图格式（jpg/png/exr，下载该分辨率的全部贴图），
+ * 也可以是打包格式（blend/gltf/fbx/usd/mtlx，下载主文件及其 include 树）
+ */
+struct DownloadTarget {
+    QString res;
+    QString format;
+    int assetType = -1;     // 0:HDRIs,1:Textures,2:Models；-1 表示对所有类型生效（配置解析不会产生）
+
+    bool operator==(const DownloadTarget& other) const
+    {
+        return res == other.res && format == other.format && assetType == other.assetType;
+    }
+};
+
+/** /files 清单中的一个文件条目（相对资产目录的路径 + { url, size, md5 }） */
+struct ManifestEntry {
+    QString relativePath;
+    QJsonObject fileJson;
+};
+
+/** 计划中的单个待传输文件 */
+struct SyncFile {
+    QString slug;
+    QString url;
+    QString localPath;
+    qint64 size = 0;        // /files 清单中的字节数（0 表示未知）
+    QString md5;
+    bool stale = false;     // 本地已有但大小与清单不符
+    QString sourcePath;     // 非空时不走网络，直接从本地这份（其他资产刚下好的同一文件）复制
+    bool inStore = false;   // 内容仓库里已有，只需建链接，不计入传输字节
+};
+
+/**
+ * 一次同步的整体计划
+ * 元数据阶段每完成一个资产就并入一次，dry-run 报告和字节进度 / ETA 都以它为准。
+ */
+struct SyncPlan {
+    QVector<SyncFile> files;
+    qint64 totalBytes = 0;    // 需要经网络传输的字节（不含仓库命中）
+    int staleCount = 0;       // 本地已有但过期、需重新下载的文件数（不含仓库命中）
+    int storeHits = 0;        // 内容仓库命中、只需建链接的文件数
+    int plannedAssets = 0;    // 至少有一个文件要传输的资产数
+    int upToDateAssets = 0;   // 本地已完整的资产数
+
+    void addAsset(const QVector<SyncFile>& assetFiles);
+    void clear();
+
+    /** 一行文字报告：文件数、总字节、缺失/过期数 */
+    QString summary() const;
+};
+
+/**
+ * 从 info.json（含 /files 清单）中取出 hdri 指定分辨率 / 格式的文件条目
+ * @param slug 资产 slug（仅用于错误信息）
+ * @param infoJson 元数据阶段得到的 info.json
+ * @param res 分辨率，如 "1k"
+ * @param format 格式，如 "hdr"
+ * @param fileJson 输出：{ url, size, md5 }
+ * @return 错误信息（空表示成功）
+ */
+QString select_hdri_file(const QString& slug, const QJsonObject& infoJson, const QString& res,
+    const QString& format, QJsonObject& fileJson);
+
+/**
+ * 从 textures/models 的 /files 清单中取出目标对应的全部文件
+ * 贴图格式：遍历每张贴图（Diffuse、nor_gl、Rough...）取 <map>.<res>.<format>；
+ * 打包格式：取 <format>.<res>.<format> 主文件，并展开其 include（贴图等相对路径引用）
+ * @param slug 资产 slug（仅用于错误信息）
+ * @param infoJson 元数据阶段得到的 info.json
+ * @param target 下载目标
+ * @param entries 输出：文件条目
+ * @return 错误信息（空表示成功）
+ */
+QString select_manifest_files(const QString& slug, const QJsonObject& infoJson, const DownloadTarget& target,
+    QVector<ManifestEntry>& entries);
+
+/**
+ * 对照本地文件一次性规划单个资产在所有目标下需要传输的文件（缺失，或大小与清单不符）
+ * 只做 stat，不读文件内容；多个目标指向同一文件时只计一次
+ * @param slug 资产 slug
+ * @param assetDir 资产目录
+ * @param infoJson 元数据阶段得到的 info.json
+ * @param targets 下载目标（应已按 sort_download_targets 排好）
+ * @param files 输出：需要传输的文件（为空表示已是最新）
+ * @param skipped 输出：该资产清单里没有的目标及原因
+ * @param store 可选的内容仓库；缺失文件在仓库中已有时标记 inStore
+ * @param hashes 可选的哈希缓存；大小相符但缓存的 md5 与清单不符（校验发现损坏）时标记 stale
+ * @param presence 可选的在库表；已扫描时按表判断本地文件，不再 stat
+ * @return 错误信息（所有目标都不可用时非空）
+ */
+QString plan_asset_files(const QString& slug, const QDir& assetDir, const QJsonObject& infoJson,
+    const QVector<DownloadTarget>& targets, QVector<SyncFile>& files, QStringList& skipped,
+    const ContentStore* store = nullptr, const HashCache* hashes = nullptr,
+    const LibraryPresence* presence = nullptr);
+
+/**
+ * 列出资产本地已有、且清单给出了 md5 的全部文件（不限目标：所有分辨率 / 格式 / include）
+ * 供校验使用
+ * @param slug 资产 slug
+ * @param assetDir 资产目录
+ * @param infoJson info.json（含 /files 清单）
+ * @param files 输出：追加到末尾
+ * @param presence 可选的在库表；已扫描时按表判断文件是否存在
+ */
+void collect_local_manifest_files(const QString& slug, const QDir& assetDir, const QJsonObject& infoJson,
+    QVector<SyncFile>& files, const LibraryPresence* presence = nullptr);
+
+/**
+ * 解析目标列表，如 "1k:hdr, textures:2k:jpg, models:1k:gltf"；
+ * 类型前缀可省略，此时按格式推断（hdr/exr -> hdris，jpg/png/mtlx -> textures，gltf/blend/fbx/usd -> models），
+ * 推断不出类型的项忽略。去重后按分辨率从小到大排序
+ * @return 解析结果（无有效项时为空）
+ */
+QVector<DownloadTarget> parse_download_targets(const QString& text);
+
+/** 目标按分辨率（"1k" < "2k" < ... < "16k"）从小到大排序并去重 */
+void sort_download_targets(QVector<DownloadTarget>& targets);
+
+/** 字节数格式化（B / KB / MB / GB） */
+QString format_bytes(qint64 bytes);
+
+/** 秒数格式化为 h:mm:ss（负数表示未知，返回 "--:--"） */
+QString format_duration(qint64 seconds);
+
+#endif // SYNC_PLAN_H
@@ -0,0 +1,106 @@
+﻿#include "tag_trie.h"
+#include <algorithm>
+
+void TagTrie::build(const QHash<QString, int>& termCounts)
+{
+    m_terms.clear();
+    m_counts.clear();
+    m_nodes.clear();
+    m_edgeChars.clear();
+    m_edgeTargets.clear();
+    m_top.clear();
+
+    m_terms.reserve(termCounts.size());
+    for (auto it = termCounts.constBegin(); it != termCounts.constEnd(); ++it) {
+        if (!it.key().isEmpty())
+            m_terms.append(it.key());
+    }
+    std::sort(m_terms.begin(), m_terms.end());
+
+    m_counts.reserve(m_terms.size());
+    for (const QString& term : m_terms)
+        m_counts.append(termCounts.value(term));
+
+    if (!m_terms.isEmpty())
+        buildNode(0, m_terms.size(), 0);
+}
+
+// [lo, hi) 中的词共享长度为 depth 的前缀；返回新节点 id
+int TagTrie::buildNode(int lo, int hi, int depth)
+{
+    const int id = m_nodes.size();
+    m_nodes.append(Node());
+
+    QVector<int> candidates;
+    QVector<QPair<QChar, int>> children;
+
+    int i = lo;
+    // 字典序下恰好等于前缀的词排在最前
+    if (i < hi && m_terms[i].size() == depth) {
+        candidates.append(i);
+        ++i;
+    }
+
+    while (i < hi) {
+        const QChar c = m_terms[i][depth];
+        int j = i;
+        while (j < hi && m_terms[j][depth] == c)
+            ++j;
+
+        const int child = buildNode(i, j, depth + 1);
+        children.append(qMakePair(c, child));
+
+        // 子树候选只需合并子节点已经选好的 TOP_K
+        const Node& childNode = m_nodes[child];
+        for (int t = 0; t < childNode.topCount; ++t)
+            candidates.append(m_top[childNode.topBegin + t]);
+        i = j;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [this](int a, int b) {
+        return m_counts[a] != m_counts[b] ? m_counts[a] > m_counts[b] : a < b;
+    });
+    if (candidates.size() > TOP_K)
+        candidates.resize(TOP_K);
+
+    // 子节点递归完成后再写本节点的出边与候选，保证各自连续
+    Node& node = m_nodes[id];
+    node.firstEdge = m_edgeChars.size();
+    node.edgeCount = children.size();
+    for (const auto& child : children) {
+        m_edgeChars.append(child.first);
+        m_edgeTargets.append(child.second);
+    }
+    node.topBegin = m_top.size();
+    node.topCount = candidates.size();
+    m_top += candidates;
+
+    return id;
+}
+
+QVector<QPair<QString, int>> TagTrie::complete(const QString& prefix, int k) const
+{
+    QVector<QPair<QString, int>> result;
+    if (m_nodes.isEmpty() || k <= 0)
+        return result;
+
+    int node = 0;
+    for (const QChar c : prefix) {
+        const Node& n = m_nodes[node];
+        auto begin = m_edgeChars.constBegin() + n.firstEdge;
+        auto end = begin + n.edgeCount;
+        auto it = std::lower_bound(begin, end, c);
+        if (it == end || *it != c)
+            return result;
+        node = m_edgeTargets[n.firstEdge + int(it - begin)];
+    }
+
+    const Node& n = m_nodes[node];
+    const int count = qMin(k, n.topCount);
+    result.reserve(count);
+    for (int t = 0; t < count; ++t) {
+        const int term = m_top[n.topBegin + t];
+        result.append(qMakePair(m_terms[term], m_counts[term]));
+    }
+    return result;
+}
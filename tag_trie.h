@@ -0,0 +1,56 @@
+﻿#ifndef TAG_TRIE_H
+#define TAG_TRIE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qpair.h>
+
+/**
+ * tags / categories 前缀补全（扁平数组存储的前缀树）
+ * 每个节点预存子树内资产数最多的 TOP_K 个词，查询只需沿前缀走一遍再截取列表，
+ * 复杂度 O(前缀长度 + k)，与词库大小无关。
+ */
+class TagTrie
+{
+public:
+    // 每个节点预存的候选数（也是单次查询能返回的上限）
+    static const int TOP_K = 8;
+
+    TagTrie() = default;
+
+    /**
+     * 重建前缀树
+     * @param termCounts 词（小写）-> 含该词的资产数
+     */
+    void build(const QHash<QString, int>& termCounts);
+
+    /**
+     * 前缀补全
+     * @param prefix 已小写的前缀
+     * @param k 返回个数（不超过 TOP_K）
+     * @return (词, 资产数)，按资产数从高到低
+     */
+    QVector<QPair<QString, int>> complete(const QString& prefix, int k = TOP_K) const;
+
+    bool isEmpty() const { return m_terms.isEmpty(); }
+
+private:
+    struct Node {
+        int firstEdge = 0;
+        int edgeCount = 0;
+        int topBegin = 0;
+        int topCount = 0;
+    };
+
+    QVector<QString> m_terms;       // 字典序
+    QVector<int> m_counts;
+    QVector<Node> m_nodes;          // 0 为根
+    QVector<QChar> m_edgeChars;     // 每个节点的出边连续存放且按字符排序
+    QVector<int> m_edgeTargets;
+    QVector<int> m_top;             // 每个节点的候选词 id，连续存放
+
+    int buildNode(int lo, int hi, int depth);
+};
+
+#endif // TAG_TRIE_H
@@ -0,0 +1,247 @@
+﻿#include "trace.h"
+
+#ifndef PH_NO_TRACE
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <chrono>
+#include <cstring>
+
+std::atomic<bool> trace_detail::g_enabled{ false };
+
+/* ---------- 每线程缓冲区 ---------- */
+namespace {
+
+const int CHUNK_EVENTS = 1024;
+const int MAX_CHUNKS = 256;        // 每线程最多 26 万条，超出的计入 dropped
+const int DETAIL_CAPACITY = 48;
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    qint64 start;
+    qint64 end;
+    qint64 bytes;
+    char detail[DETAIL_CAPACITY];
+};
+
+// 只有所属线程写 count 和 chunks；导出方按 acquire 读到的 count 读取之前的事件
+struct ThreadBuffer {
+    quint64 tid = 0;
+    QString threadName;
+    bool inUse = true;             // 所属线程仍在（g_registryMutex 保护）
+    std::atomic<quint64> generation{ 0 };
+    std::atomic<int> count{ 0 };
+    std::atomic<int> dropped{ 0 };
+    std::atomic<TraceEvent*> chunks[MAX_CHUNKS] = {};
+};
+
+std::atomic<quint64> g_generation{ 0 };
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+// 注册表只在线程第一次记录和线程退出时加锁
+QMutex g_registryMutex;
+QVector<ThreadBuffer*> g_buffers;
+quint64 g_nextTid = 1;
+
+// 线程退出时把缓冲区交还注册表：QThreadPool 的空闲线程 30 秒后退出，
+// 长时间开着 trace 时新线程复用旧缓冲区（连同已分配的块），不再每个线程泄漏一份
+struct ThreadBufferOwner {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferOwner()
+    {
+        if (!buffer)
+            return;
+        QMutexLocker locker(&g_registryMutex);
+        buffer->inUse = false;
+    }
+};
+
+ThreadBuffer* thread_buffer()
+{
+    thread_local ThreadBufferOwner owner;
+    if (owner.buffer)
+        return owner.buffer;
+    QThread* thread = QThread::currentThread();
+    const quint64 generation = g_generation.load();
+    QMutexLocker locker(&g_registryMutex);
+    // 已退出线程的缓冲区里若还有本轮的记录，留到导出之后（下次 trace_start 换代）再复用
+    ThreadBuffer* buffer = nullptr;
+    for (ThreadBuffer* candidate : g_buffers) {
+        if (!candidate->inUse && (candidate->generation.load(std::memory_order_relaxed) != generation
+                || candidate->count.load(std::memory_order_relaxed) == 0)) {
+            buffer = candidate;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new ThreadBuffer;
+        g_buffers.append(buffer);
+    }
+    buffer->inUse = true;
+    buffer->tid = g_nextTid++;
+    buffer->threadName = thread && !thread->objectName().isEmpty()
+        ? thread->objectName()
+        : QString("thread %1").arg(buffer->tid);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    buffer->count.store(0, std::memory_order_relaxed);
+    buffer->generation.store(generation, std::memory_order_release);
+    owner.buffer = buffer;
+    return buffer;
+}
+
+void append_escaped(QByteArray& out, const char* text)
+{
+    for (const char* p = text; *p; ++p) {
+        const char c = *p;
+        if (c == '"' || c == '\\') {
+            out.append('\\');
+            out.append(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            out.append(' ');
+        }
+        else {
+            out.append(c);
+        }
+    }
+}
+
+} // namespace
+
+/* ---------- 开关 ---------- */
+void trace_start()
+{
+    // 换代：各线程下次记录时发现代数不同就从头写，旧记录不再导出
+    g_generation.fetch_add(1);
+    trace_detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void trace_stop()
+{
+    trace_detail::g_enabled.store(false, std::memory_order_relaxed);
+}
+
+qint64 trace_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+/* ---------- 记录 ---------- */
+void trace_record(const char* name, const char* category, qint64 startNs, qint64 endNs,
+    const QString& detail, qint64 bytes)
+{
+    if (!trace_enabled())
+        return;
+    ThreadBuffer* buffer = thread_buffer();
+    const quint64 generation = g_generation.load(std::memory_order_relaxed);
+    if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+        buffer->generation.store(generation, std::memory_order_relaxed);
+        buffer->dropped.store(0, std::memory_order_relaxed);
+        buffer->count.store(0, std::memory_order_release);
+    }
+
+    const int index = buffer->count.load(std::memory_order_relaxed);
+    const int chunkIndex = index / CHUNK_EVENTS;
+    if (chunkIndex >= MAX_CHUNKS) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent* chunk = buffer->chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new TraceEvent[CHUNK_EVENTS];
+        buffer->chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+
+    TraceEvent& event = chunk[index % CHUNK_EVENTS];
+    event.name = name;
+    event.category = category;
+    event.start = startNs;
+    event.end = qMax(startNs, endNs);
+    event.bytes = bytes;
+    const QByteArray utf8 = detail.toUtf8();
+    const int length = qMin(int(utf8.size()), DETAIL_CAPACITY - 1);
+    std::memcpy(event.detail, utf8.constData(), length);
+    event.detail[length] = '\0';
+    buffer->count.store(index + 1, std::memory_order_release);
+}
+
+/* ---------- 导出 ---------- */
+QByteArray trace_export_json()
+{
+    const quint64 generation = g_generation.load();
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out;
+    out.reserve(1 << 16);
+    out.append("{\"traceEvents\":[");
+    bool first = true;
+    qint64 dropped = 0;
+
+    QMutexLocker locker(&g_registryMutex);
+    for (const ThreadBuffer* buffer : g_buffers) {
+        if (buffer->generation.load(std::memory_order_relaxed) != generation)
+            continue;
+        const int count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0)
+            continue;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+        if (!first)
+            out.append(',');
+        first = false;
+        out.append(QString("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%1,\"tid\":%2,\"args\":{\"name\":\"")
+            .arg(pid).arg(buffer->tid).toUtf8());
+        append_escaped(out, buffer->threadName.toUtf8().constData());
+        out.append("\"}}");
+
+        for (int i = 0; i < count; ++i) {
+            const TraceEvent& event = buffer->chunks[i / CHUNK_EVENTS].load(std::memory_order_acquire)[i % CHUNK_EVENTS];
+            out.append(",{\"ph\":\"X\",\"name\":\"");
+            append_escaped(out, event.name);
+            out.append("\",\"cat\":\"");
+            append_escaped(out, event.category);
+            // 时间单位为微秒，保留到纳秒精度
+            out.append(QString("\",\"pid\":%1,\"tid\":%2,\"ts\":%3,\"dur\":%4")
+                .arg(pid).arg(buffer->tid)
+                .arg(event.start / 1000.0, 0, 'f', 3)
+                .arg((event.end - event.start) / 1000.0, 0, 'f', 3).toUtf8());
+            if (event.detail[0] != '\0' || event.bytes >= 0) {
+                out.append(",\"args\":{");
+                if (event.detail[0] != '\0') {
+                    out.append("\"detail\":\"");
+                    append_escaped(out, event.detail);
+                    out.append('"');
+                }
+                if (event.bytes >= 0) {
+                    if (event.detail[0] != '\0')
+                        out.append(',');
+                    out.append("\"bytes\":");
+                    out.append(QByteArray::number(event.bytes));
+                }
+                out.append('}');
+            }
+            out.append('}');
+        }
+    }
+    out.append("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":");
+    out.append(QByteArray::number(dropped));
+    out.append("}}");
+    return out;
+}
+
+QString trace_write_file(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return QString("Failed to open trace file %1: %2").arg(path, file.errorString());
+    const QByteArray json = trace_export_json();
+    if (file.write(json) != json.size())
+        return QString("Failed to write trace file %1: %2").arg(path, file.errorString());
+    return QString();
+}
+
+#endif // PH_NO_TRACE
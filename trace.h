@@ -0,0 +1,143 @@
+﻿#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtCore/qstring.h>
+#include <QtCore/qbytearray.h>
+#include <atomic>
+#include <type_traits>
+
+/**
+ * 轻量 trace：作用域 span（线程、起止时间、资产 slug 或文件名、字节数），按需导出为 Chrome trace JSON
+ * （chrome://tracing、ui.perfetto.dev 可直接打开）。
+ * 每个线程写自己的缓冲区，只有本线程推进写位置，记录时不加锁、不分配（缓冲区按 1024 条一块按需增长）；
+ * 未开启时每个 span 只多一次 relaxed 原子读；需要拼接的 detail 传 lambda，未开启时不求值。
+ * 定义 PH_NO_TRACE 时 TraceSpan 为空类，调用点整体被编译器消掉。
+ * trace_start / trace_export_json 应由同一个控制方调用（命令行、cmd_polyhaven trace 子命令），不要并发。
+ */
+
+#ifndef PH_NO_TRACE
+
+namespace trace_detail {
+extern std::atomic<bool> g_enabled;
+}
+
+/** 是否正在记录 */
+inline bool trace_enabled()
+{
+    return trace_detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+/** 开始记录（丢弃之前的记录） */
+void trace_start();
+
+/** 停止记录（已记录的保留，供导出） */
+void trace_stop();
+
+/** trace 时间轴上的当前时间（纳秒，单调时钟） */
+qint64 trace_now_ns();
+
+/**
+ * 记录一段已结束的 span（供 libcurl 分段计时这类事后才知道起止时间的场合）
+ * @param name 名称（须为静态字符串，只保存指针）
+ * @param category 分类（同上）
+ * @param startNs 开始时间（trace_now_ns）
+ * @param endNs 结束时间
+ * @param detail 资产 slug 或文件名（超出 47 字节截断）
+ * @param bytes 字节数（<0 表示不适用）
+ */
+void trace_record(const char* name, const char* category, qint64 startNs, qint64 endNs,
+    const QString& detail = QString(), qint64 bytes = -1);
+
+/** 导出已记录的 span（Trace Event Format，"X" 完整事件 + 线程名元数据） */
+QByteArray trace_export_json();
+
+/**
+ * 导出到文件
+ * @return 错误信息（空表示成功）
+ */
+QString trace_write_file(const QString& path);
+
+/** 作用域 span：构造时取开始时间，析构时记录 */
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(name)
+        , m_category(category)
+        , m_start(trace_enabled() ? trace_now_ns() : -1)
+    {
+    }
+
+    TraceSpan(const char* name, const char* category, const QString& detail)
+        : TraceSpan(name, category)
+    {
+        if (m_start >= 0)
+            m_detail = detail;
+    }
+
+    /**
+     * detail 只在正在记录时才求值，如
+     * TraceSpan span("download_file", "net", [&] { return QFileInfo(dest).fileName(); });
+     */
+    template <typename DetailFn, typename = std::enable_if_t<std::is_invocable_r_v<QString, DetailFn&>>>
+    TraceSpan(const char* name, const char* category, DetailFn&& detail)
+        : TraceSpan(name, category)
+    {
+        if (m_start >= 0)
+            m_detail = detail();
+    }
+
+    ~TraceSpan()
+    {
+        if (m_start >= 0)
+            trace_record(m_name, m_category, m_start, trace_now_ns(), m_detail, m_bytes);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    bool active() const { return m_start >= 0; }
+    qint64 startNs() const { return m_start; }
+    const QString& detail() const { return m_detail; }
+    void setDetail(const QString& detail)
+    {
+        if (m_start >= 0)
+            m_detail = detail;
+    }
+    void setBytes(qint64 bytes) { m_bytes = bytes; }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    qint64 m_start;
+    qint64 m_bytes = -1;
+    QString m_detail;
+};
+
+#else // PH_NO_TRACE
+
+inline bool trace_enabled() { return false; }
+inline void trace_start() {}
+inline void trace_stop() {}
+inline qint64 trace_now_ns() { return 0; }
+inline void trace_record(const char*, const char*, qint64, qint64, const QString& = QString(), qint64 = -1) {}
+inline QByteArray trace_export_json() { return QByteArray("{\"traceEvents\":[]}"); }
+inline QString trace_write_file(const QString&) { return QString("Tracing is compiled out (PH_NO_TRACE)"); }
+
+class TraceSpan
+{
+public:
+    TraceSpan(const char*, const char*) {}
+    TraceSpan(const char*, const char*, const QString&) {}
+    template <typename DetailFn, typename = std::enable_if_t<std::is_invocable_r_v<QString, DetailFn&>>>
+    TraceSpan(const char*, const char*, DetailFn&&) {}
+    bool active() const { return false; }
+    qint64 startNs() const { return 0; }
+    QString detail() const { return QString(); }
+    void setDetail(const QString&) {}
+    void setBytes(qint64) {}
+};
+
+#endif // PH_NO_TRACE
+
+#endif // TRACE_H
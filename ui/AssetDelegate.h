@@ -16,6 +16,8 @@
 
 // 自定义角色：存储目录完整路径（与 Python 中的 CATALOG_PATH_ROLE 对应）
 const int CATALOG_PATH_ROLE = Qt::UserRole + 100;
+// 自定义角色：目录节点 id（对应 AssetIndex 中的分类位图下标）
+const int CATALOG_NODE_ROLE = Qt::UserRole + 101;
 
 class AssetDelegate : public QStyledItemDelegate
 {
@@ -33,6 +35,11 @@ public:
     void setThumbCache(QCache<QString, QPixmap>* cache);
 
     void loadThumbInThread(const QString& imgPath) const;
+
+Q_SIGNALS:
+    // 开始拖动某个资产（拖进场景前先把它的下载提到最前）
+    void assetDragged(const QString& assetId);
+
 private:
     void startDrag(const QModelIndex& index);
     // 新增：判断 WebP 文件是否完整
@@ -1,9 +1,12 @@
 ﻿#include "AssetDownloadTask.h"
+#include "trace.h"
 /* ---------- AssetDownloadTask ---------- */
 
 
-AssetDownloadTask::AssetDownloadTask(const QMap<QString, QJsonObject>& asset, const QDir& libDir, bool revalidate, phaPullFromPolyhaven* parent)
-    : m_asset(asset), m_libDir(libDir), m_revalidate(revalidate), m_parent(parent)
+AssetDownloadTask::AssetDownloadTask(const QMap<QString, QJsonObject>& asset, const QDir& libDir, bool revalidate, phaPullFromPolyhaven* parent,
+    DownloadStage stage, const SyncFile& file)
+    : m_asset(asset), m_libDir(libDir), m_revalidate(revalidate), m_parent(parent), m_stage(stage), m_file(file)
+    , m_queuedNs(trace_enabled() ? trace_now_ns() : -1)
 {
     setAutoDelete(true);
 }
@@ -14,11 +17,39 @@ void AssetDownloadTask::run()
     //result.slug = m_asset.slug;
     
     result.slug = m_asset.keys().constFirst();
-    if (m_parent->m_isCancelled.load(std::memory_order_relaxed) || PHPlugin::PH_PROGRESS_CANCEL) {
+    result.stage = m_stage;
+
+    // 排队等待（入队到线程池线程开始执行）和本阶段的执行各记一段
+    static const char* STAGE_NAMES[] = { "metadata", "thumbnail", "payload" };
+    const char* stageName = STAGE_NAMES[qBound(0, int(m_stage), 2)];
+    if (m_queuedNs >= 0)
+        trace_record("queued", "task", m_queuedNs, trace_now_ns(), result.slug);
+    TraceSpan span(stageName, "task", result.slug);
+    if (m_stage == DownloadStage::Payload)
+        span.setBytes(m_file.size);
+
+    if (m_stage == DownloadStage::Payload)
+        result.files.append(m_file);
+    if (m_parent->m_isCancelled.load(std::memory_order_relaxed)) {
         result.error = "Task cancelled";
         Q_EMIT taskFinished(result);
         return;
     }
-    result = m_parent->updateAsset(m_asset, m_libDir, false);
+
+    QDir assetDir(m_libDir.filePath(result.slug));
+    switch (m_stage) {
+    case DownloadStage::Metadata:
+        result = m_parent->updateAsset(m_asset, m_libDir);
+        break;
+    case DownloadStage::Thumbnail:
+        result.error = m_parent->downloadThumbnail(result.slug, assetDir);
+        break;
+    case DownloadStage::Payload:
+        result.error = m_parent->downloadPlannedFile(m_file);
+        break;
+    default:
+        break;
+    }
+    result.stage = m_stage;
     Q_EMIT taskFinished(result);
 }
\ No newline at end of file
@@ -5,7 +5,6 @@
 #include <QtCore/QRunnable>
 #include <QtCore/QDir>
 #include <QtCore/QJsonArray>
-#include <QtWidgets/QProgressDialog>
 #include <atomic>          // ← 新增
 //#include "AssetInfo.h"
 #include "phaPullFromPolyhaven.h"
@@ -15,7 +14,12 @@ class AssetDownloadTask : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    AssetDownloadTask(const QMap<QString, QJsonObject>& asset, const QDir& libDir, bool revalidate, phaPullFromPolyhaven* parent);
+    /**
+     * @param stage 本任务执行的阶段
+     * @param file Payload 阶段要下载的文件（由 Metadata 阶段规划），其他阶段为空
+     */
+    AssetDownloadTask(const QMap<QString, QJsonObject>& asset, const QDir& libDir, bool revalidate, phaPullFromPolyhaven* parent,
+        DownloadStage stage = DownloadStage::Metadata, const SyncFile& file = SyncFile());
     ~AssetDownloadTask() override = default;
     void run() override;
 Q_SIGNALS:
@@ -25,6 +29,9 @@ private:
     QDir m_libDir;
     bool m_revalidate;
     phaPullFromPolyhaven* m_parent;
+    DownloadStage m_stage;
+    SyncFile m_file;
+    qint64 m_queuedNs;     // 入队时间（trace 关闭时为 -1）
 };
 
 #endif
\ No newline at end of file
@@ -9,6 +9,12 @@ AssetModel::AssetModel(const QMap<QString, QJsonObject>& assets, QObject* parent
 {
 }
 
+AssetModel::AssetModel(const AssetIndex& index, const QVector<int>& rows, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_assets(convertRowsToList(index, rows))
+{
+}
+
 // 重写：返回数据总行数（QListView必须）
 int AssetModel::rowCount(const QModelIndex& parent) const
 {
@@ -45,14 +51,17 @@ QVariant AssetModel::data(const QModelIndex& index, int role) const
         assetData["categories"] = details.value("categories");
         assetData["authors"] = details.value("authors").toObject().keys().first();
         assetData["local_thumbnail_path"] = getLocalThumbnailPath(assetId);
+        // 在库表已确认缩略图存在：Delegate 不必再 stat
+        assetData["thumbnail_present"] = m_presence && m_presence->isReady() && m_presence->hasThumbnail(assetId);
         return assetData;
     }
 
     // 3. 自定义角色：返回缩略图图标（直接返回QIcon，UI可直接使用）
     else if (role == ThumbnailRole) {
         const QString thumbnailPath = getLocalThumbnailPath(assetId);
-        // 若图片不存在，返回系统默认"图片缺失"图标
-        if (QFile::exists(thumbnailPath)) {
+        // 若图片不存在，返回系统默认"图片缺失"图标（在库表可用时空路径即不存在，不再 stat）
+        const bool presenceReady = m_presence && m_presence->isReady();
+        if (!thumbnailPath.isEmpty() && (presenceReady || QFile::exists(thumbnailPath))) {
             return QIcon(thumbnailPath);
         }
         else {
@@ -82,6 +91,29 @@ void AssetModel::updateAssets(const QMap<QString, QJsonObject>& newAssets)
     endResetModel();    // 结束重置（通知UI刷新）
 }
 
+void AssetModel::updateAssets(const AssetIndex& index, const QVector<int>& rows)
+{
+    beginResetModel();
+    m_assets = convertRowsToList(index, rows);
+    endResetModel();
+}
+
+void AssetModel::appendRows(const AssetIndex& index, const QVector<int>& rows)
+{
+    QVector<AssetItem> items = convertRowsToList(index, rows);
+    if (items.isEmpty())
+        return;
+
+    beginInsertRows(QModelIndex(), m_assets.size(), m_assets.size() + items.size() - 1);
+    m_assets += items;
+    endInsertRows();
+}
+
+void AssetModel::setPresence(const LibraryPresence* presence)
+{
+    m_presence = presence;
+}
+
 // 辅助函数：将QMap转换为QVector（适配列表索引访问）
 QVector<AssetModel::AssetItem> AssetModel::convertMapToList(const QMap<QString, QJsonObject>& assets) const
 {
@@ -99,19 +131,32 @@ QVector<AssetModel::AssetItem> AssetModel::convertMapToList(const QMap<QString,
     return assetList;
 }
 
-// 辅助函数：获取本地缩略图路径（.webp格式）
-QString AssetModel::getLocalThumbnailPath(const QString& assetId) const
+// 辅助函数：按索引行号提取资产（顺序即 rows 顺序）
+QVector<AssetModel::AssetItem> AssetModel::convertRowsToList(const AssetIndex& index, const QVector<int>& rows) const
 {
-    // 构建路径：资产库根路径 / 资产ID / thumbnail.webp
-    const QString thumbnailFolder = QString("%1/%2").arg(get_asset_lib_path()).arg(assetId);
-    const QString thumbnailPath = QString("%1/thumbnail.webp").arg(thumbnailFolder);
-
-    // 确保文件夹存在（不存在则创建）
-    QDir dir(thumbnailFolder);
-    if (!dir.exists()) {
-        dir.mkpath(".");  // 创建多级目录（包括父目录）
-        qDebug() << "[AssetModel] 创建缩略图文件夹：" << thumbnailFolder;
+    QVector<AssetItem> assetList;
+    assetList.reserve(rows.size());
+
+    for (int row : rows) {
+        if (row < 0 || row >= index.size()) continue;
+        AssetItem item;
+        item.assetId = index.slug(row);
+        item.details = index.details(row);
+        assetList.append(item);
     }
 
-    return thumbnailPath;
+    return assetList;
+}
+
+// 辅助函数：获取本地缩略图路径（.webp格式）；在库表显示没有缩略图时返回空字符串
+// data() 每次绘制都会调用，这里不碰磁盘：目录由下载缩略图时创建
+QString AssetModel::getLocalThumbnailPath(const QString& assetId) const
+{
+    if (m_presence && m_presence->isReady()) {
+        if (!m_presence->hasThumbnail(assetId))
+            return QString();
+        return QString("%1/%2/thumbnail.webp").arg(m_presence->libraryPath()).arg(assetId);
+    }
+    // 构建路径：资产库根路径 / 资产ID / thumbnail.webp
+    return QString("%1/%2/thumbnail.webp").arg(get_asset_lib_path()).arg(assetId);
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define ASSETMODEL_H
 
 #include "get_asset_lib.h"
+#include "asset_index.h"
+#include "library_presence.h"
 #include <QtCore/QAbstractListModel>
 #include <QtCore/QMap>
 #include <QtCore/QVariant>
@@ -32,6 +34,9 @@ public:
     explicit AssetModel(const QMap<QString, QJsonObject>& assets = QMap<QString, QJsonObject>(),
         QObject* parent = nullptr);
 
+    // 构造函数：按 AssetIndex 行号列表构建（行号已按排序置换排好，不再按 QMap 顺序）
+    AssetModel(const AssetIndex& index, const QVector<int>& rows, QObject* parent = nullptr);
+
     // QAbstractListModel 纯虚函数重写（必须实现）
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
@@ -41,6 +46,11 @@ public:
 
     // 公共接口：更新资产数据（支持动态刷新UI）
     void updateAssets(const QMap<QString, QJsonObject>& newAssets);
+    void updateAssets(const AssetIndex& index, const QVector<int>& rows);
+    // 追加行（启动时分批插入，避免一次性构建大模型）
+    void appendRows(const AssetIndex& index, const QVector<int>& rows);
+    // 缩略图是否存在查在库表（不持有）；未设置或尚未扫描完时退回按路径判断
+    void setPresence(const LibraryPresence* presence);
 
 private:
     // 资产存储结构（适配列表索引访问）
@@ -50,10 +60,14 @@ private:
     };
 
     QVector<AssetItem> m_assets;  // 存储资产列表（QVector比QList更适合连续访问）
+    const LibraryPresence* m_presence = nullptr;
 
     // 辅助函数：将QMap转换为QVector（适配列表模型）
     QVector<AssetItem> convertMapToList(const QMap<QString, QJsonObject>& assets) const;
 
+    // 辅助函数：按索引行号提取资产（QJsonObject 隐式共享，不做深拷贝）
+    QVector<AssetItem> convertRowsToList(const AssetIndex& index, const QVector<int>& rows) const;
+
     // 辅助函数：获取本地缩略图路径
     QString getLocalThumbnailPath(const QString& assetId) const;
 };
@@ -0,0 +1,127 @@
+﻿#include "LibraryWatcher.h"
+#include <QtCore/QDir>
+#include <QtCore/QDebug>
+
+// 目录变化通知合并的时间窗（毫秒）
+static const int CHANGE_DEBOUNCE_MS = 300;
+
+LibraryWatcher::LibraryWatcher(LibraryPresence* presence, QObject* parent)
+    : QObject(parent)
+    , m_presence(presence)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounce(new QTimer(this))
+{
+    m_debounce->setSingleShot(true);
+    m_debounce->setInterval(CHANGE_DEBOUNCE_MS);
+    connect(m_debounce, &QTimer::timeout, this, &LibraryWatcher::flushChanges);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &LibraryWatcher::onDirectoryChanged);
+    m_pool.setMaxThreadCount(1);
+}
+
+LibraryWatcher::~LibraryWatcher()
+{
+    // 池任务里捕获了 this，必须在成员析构前结束
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void LibraryWatcher::start(const QString& libraryPath)
+{
+    const QStringList watched = m_watcher->directories();
+    if (!watched.isEmpty())
+        m_watcher->removePaths(watched);
+    m_dirty.clear();
+    m_rootDirty = false;
+    m_root = QDir::cleanPath(QDir(libraryPath).absolutePath());
+    if (libraryPath.isEmpty())
+        return;
+
+    // 扫描本身用 LibraryPresence 的私有线程池并行，这里只是不占 GUI 线程；
+    // 旧资产库排队中的重扫不再需要
+    const int generation = ++m_generation;
+    LibraryPresence* presence = m_presence;
+    m_pool.clear();
+    m_pool.start([this, presence, libraryPath, generation]() {
+        const bool ok = presence->scan(libraryPath);
+        QMetaObject::invokeMethod(this, [this, ok, generation]() {
+            // 期间又换了资产库，丢弃旧结果
+            if (generation != m_generation)
+                return;
+            if (!ok) {
+                qWarning() << "[LibraryWatcher] Asset library not found:" << m_root;
+                return;
+            }
+            watchDirectories();
+            Q_EMIT scanFinished(m_presence->slugs().size());
+        }, Qt::QueuedConnection);
+    });
+}
+
+void LibraryWatcher::watchDirectories()
+{
+    const QStringList wanted = m_presence->directories();
+    const QStringList current = m_watcher->directories();
+    const QSet<QString> watched(current.cbegin(), current.cend());
+    QStringList added;
+    for (const QString& dir : wanted) {
+        if (!watched.contains(dir))
+            added.append(dir);
+    }
+    if (added.isEmpty())
+        return;
+    // inotify 监视数有上限（max_user_watches），加不上的目录只能靠同步时的登记和下次启动扫描
+    const QStringList failed = m_watcher->addPaths(added);
+    if (!failed.isEmpty())
+        qWarning() << "[LibraryWatcher] Failed to watch" << failed.size() << "directories";
+}
+
+void LibraryWatcher::onDirectoryChanged(const QString& path)
+{
+    const QString cleaned = QDir::cleanPath(path);
+    if (cleaned == m_root) {
+        m_rootDirty = true;
+    }
+    else if (cleaned.startsWith(m_root + '/')) {
+        // 子目录（textures/ 等）的变化归到所属资产
+        m_dirty.insert(cleaned.mid(m_root.size() + 1).section('/', 0, 0));
+    }
+    m_debounce->start();
+}
+
+void LibraryWatcher::flushChanges()
+{
+    if (m_dirty.isEmpty() && !m_rootDirty)
+        return;
+    const bool rootDirty = m_rootDirty;
+    QSet<QString> dirty = m_dirty;
+    m_rootDirty = false;
+    m_dirty.clear();
+
+    // 同步期间每个 .part 的创建和改名都会触发通知，资产库又常在网络盘上：重扫放到扫描线程
+    const int generation = m_generation;
+    const QString root = m_root;
+    LibraryPresence* presence = m_presence;
+    m_pool.start([this, presence, root, rootDirty, dirty, generation]() mutable {
+        if (rootDirty) {
+            // 根目录变化只说明资产目录有增删：与在库表比对出增删的 slug
+            const QStringList onDisk = QDir(root).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+            const QSet<QString> current(onDisk.cbegin(), onDisk.cend());
+            const QStringList known = presence->slugs();
+            const QSet<QString> previous(known.cbegin(), known.cend());
+            dirty.unite(current - previous);
+            dirty.unite(previous - current);
+        }
+        if (dirty.isEmpty())
+            return;
+
+        const QStringList slugs(dirty.cbegin(), dirty.cend());
+        for (const QString& slug : slugs)
+            presence->rescanAsset(slug);
+        QMetaObject::invokeMethod(this, [this, slugs, generation]() {
+            if (generation != m_generation)
+                return;
+            watchDirectories();
+            Q_EMIT presenceChanged(slugs);
+        }, Qt::QueuedConnection);
+    });
+}
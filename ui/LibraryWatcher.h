@@ -0,0 +1,59 @@
+﻿#ifndef LIBRARYWATCHER_H
+#define LIBRARYWATCHER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QTimer>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QThreadPool>
+#include "library_presence.h"
+
+/**
+ * 维护资产库在库表：启动时在后台全量扫描一次，之后监视资产库根目录和各资产目录
+ * （Linux 上 QFileSystemWatcher 即 inotify，Windows 上为 ReadDirectoryChangesW），
+ * 目录有变化时只重扫对应的资产目录。变化通知先合并一小段时间再处理，批量下载时不会逐个文件重扫。
+ * 扫描和重扫都在本对象私有的单线程池上依次进行，GUI 线程只收结果、更新监视列表。
+ */
+class LibraryWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @param presence 要维护的在库表（不持有，须比本对象活得久）
+     */
+    explicit LibraryWatcher(LibraryPresence* presence, QObject* parent = nullptr);
+
+    /** 丢弃排队的重扫并等待正在进行的扫描结束 */
+    ~LibraryWatcher() override;
+
+    /**
+     * 后台扫描资产库，完成后开始监视（重复调用会换到新的资产库）
+     * @param libraryPath 资产库根目录
+     */
+    void start(const QString& libraryPath);
+
+Q_SIGNALS:
+    void scanFinished(int assetCount);
+    // 这些资产目录下的文件有增删
+    void presenceChanged(const QStringList& slugs);
+
+private Q_SLOTS:
+    void onDirectoryChanged(const QString& path);
+    void flushChanges();
+
+private:
+    LibraryPresence* m_presence;
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_debounce;
+    QString m_root;
+    QSet<QString> m_dirty;        // 待重扫的 slug
+    bool m_rootDirty = false;     // 根目录有变化：可能新增或删除了资产目录
+    int m_generation = 0;
+    QThreadPool m_pool;           // 扫描线程（单线程，保证全量扫描和重扫按顺序执行）
+
+    void watchDirectories();
+};
+
+#endif // LIBRARYWATCHER_H
@@ -0,0 +1,154 @@
+﻿#include "MetricsPanel.h"
+#include "metrics.h"
+#include "sync_plan.h"
+#include <QtWidgets/QVBoxLayout>
+#include <QtWidgets/QHBoxLayout>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QHeaderView>
+#include <QtWidgets/QFileDialog>
+#include <QtWidgets/QMessageBox>
+#include <QtCore/QJsonObject>
+
+// 刷新间隔（毫秒）
+static const int REFRESH_INTERVAL_MS = 1000;
+
+// 列
+enum MetricsColumn {
+    COLUMN_NAME = 0,
+    COLUMN_VALUE,
+    COLUMN_P50,
+    COLUMN_P90,
+    COLUMN_P99,
+    COLUMN_MAX,
+    COLUMN_COUNT
+};
+
+// 时间类指标（_us 结尾）换成易读的单位
+static QString format_metric(const QString& name, qint64 value)
+{
+    if (name.contains("_us")) {
+        if (value >= 1000000)
+            return QString("%1 s").arg(value / 1000000.0, 0, 'f', 2);
+        if (value >= 1000)
+            return QString("%1 ms").arg(value / 1000.0, 0, 'f', 1);
+        return QString("%1 us").arg(value);
+    }
+    if (name.startsWith("net.bytes"))
+        return format_bytes(value);
+    return QString::number(value);
+}
+
+MetricsPanel::MetricsPanel(QWidget* parent)
+    : QWidget(parent, Qt::Tool)
+    , m_tree(new QTreeWidget(this))
+    , m_summary(new QLabel(this))
+    , m_timer(new QTimer(this))
+{
+    setWindowTitle(u8"统计");
+    resize(640, 480);
+
+    m_tree->setColumnCount(COLUMN_COUNT);
+    m_tree->setHeaderLabels({ u8"指标", u8"值 / 次数", "p50", "p90", "p99", "max" });
+    m_tree->setRootIsDecorated(true);
+    m_tree->setUniformRowHeights(true);
+    m_tree->header()->setSectionResizeMode(COLUMN_NAME, QHeaderView::Stretch);
+    m_tree->header()->setStretchLastSection(false);
+
+    m_counterGroup = new QTreeWidgetItem(m_tree, { u8"计数" });
+    m_gaugeGroup = new QTreeWidgetItem(m_tree, { u8"瞬时值" });
+    m_histogramGroup = new QTreeWidgetItem(m_tree, { u8"耗时分布" });
+    for (QTreeWidgetItem* group : { m_counterGroup, m_gaugeGroup, m_histogramGroup }) {
+        group->setFirstColumnSpanned(true);
+        group->setExpanded(true);
+    }
+
+    QPushButton* exportBtn = new QPushButton(u8"导出 JSON", this);
+    connect(exportBtn, &QPushButton::clicked, this, &MetricsPanel::exportJson);
+
+    QHBoxLayout* bottom = new QHBoxLayout;
+    bottom->addWidget(m_summary, 1);
+    bottom->addWidget(exportBtn);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(m_tree);
+    layout->addLayout(bottom);
+
+    m_timer->setInterval(REFRESH_INTERVAL_MS);
+    connect(m_timer, &QTimer::timeout, this, &MetricsPanel::refresh);
+}
+
+void MetricsPanel::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
+    m_lastBytes = -1;
+    refresh();
+    m_timer->start();
+}
+
+void MetricsPanel::hideEvent(QHideEvent* event)
+{
+    m_timer->stop();
+    QWidget::hideEvent(event);
+}
+
+QTreeWidgetItem* MetricsPanel::row(QTreeWidgetItem* group, const QString& name)
+{
+    QTreeWidgetItem*& item = m_rows[name];
+    if (!item) {
+        item = new QTreeWidgetItem(group, { name });
+        for (int column = COLUMN_VALUE; column < COLUMN_COUNT; ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    }
+    return item;
+}
+
+void MetricsPanel::refresh()
+{
+    const QJsonObject snapshot = metrics_snapshot();
+    const QJsonObject counters = snapshot["counters"].toObject();
+    const QJsonObject gauges = snapshot["gauges"].toObject();
+    const QJsonObject histograms = snapshot["histograms"].toObject();
+
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it)
+        row(m_counterGroup, it.key())->setText(COLUMN_VALUE, format_metric(it.key(), it.value().toVariant().toLongLong()));
+    for (auto it = gauges.constBegin(); it != gauges.constEnd(); ++it)
+        row(m_gaugeGroup, it.key())->setText(COLUMN_VALUE, format_metric(it.key(), it.value().toVariant().toLongLong()));
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it) {
+        const QJsonObject h = it.value().toObject();
+        QTreeWidgetItem* item = row(m_histogramGroup, it.key());
+        item->setText(COLUMN_VALUE, QString::number(h["count"].toVariant().toLongLong()));
+        item->setText(COLUMN_P50, format_metric(it.key(), h["p50"].toVariant().toLongLong()));
+        item->setText(COLUMN_P90, format_metric(it.key(), h["p90"].toVariant().toLongLong()));
+        item->setText(COLUMN_P99, format_metric(it.key(), h["p99"].toVariant().toLongLong()));
+        item->setText(COLUMN_MAX, format_metric(it.key(), h["max"].toVariant().toLongLong()));
+    }
+
+    /* 汇总：当前吞吐、缩略图缓存命中率 */
+    const qint64 bytes = counters["net.bytes_received"].toVariant().toLongLong();
+    QString throughput = "-";
+    if (m_lastBytes >= 0 && m_sampleTimer.elapsed() > 0)
+        throughput = format_bytes(qint64(double(bytes - m_lastBytes) * 1000.0 / double(m_sampleTimer.elapsed()))) + "/s";
+    m_lastBytes = bytes;
+    m_sampleTimer.restart();
+
+    const qint64 hits = counters["thumbnail.cache_hits"].toVariant().toLongLong();
+    const qint64 misses = counters["thumbnail.cache_misses"].toVariant().toLongLong();
+    const QString hitRate = hits + misses > 0
+        ? QString("%1%").arg(100.0 * double(hits) / double(hits + misses), 0, 'f', 1)
+        : QString("-");
+
+    m_summary->setText(QString(u8"吞吐 %1　活动传输 %2　缩略图命中率 %3")
+        .arg(throughput)
+        .arg(gauges["net.active_transfers"].toVariant().toLongLong())
+        .arg(hitRate));
+}
+
+void MetricsPanel::exportJson()
+{
+    const QString path = QFileDialog::getSaveFileName(this, u8"导出统计", "polyhaven_metrics.json", "JSON (*.json)");
+    if (path.isEmpty())
+        return;
+    const QString error = metrics_write_file(path);
+    if (!error.isEmpty())
+        QMessageBox::warning(this, u8"导出统计", error);
+}
@@ -0,0 +1,46 @@
+﻿#ifndef METRICSPANEL_H
+#define METRICSPANEL_H
+
+#include <QtWidgets/QWidget>
+#include <QtWidgets/QTreeWidget>
+#include <QtWidgets/QLabel>
+#include <QtCore/QHash>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+/**
+ * 统计面板：每秒读取一次指标注册表，显示吞吐、缩略图缓存命中率、各主机请求延迟、
+ * 缩略图解码和筛选耗时等（直方图显示 p50 / p90 / p99 / max），可导出为 JSON。
+ * 只在可见时刷新。
+ */
+class MetricsPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MetricsPanel(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
+private Q_SLOTS:
+    void refresh();
+    void exportJson();
+
+private:
+    QTreeWidget* m_tree;
+    QLabel* m_summary;
+    QTimer* m_timer;
+    QTreeWidgetItem* m_counterGroup;
+    QTreeWidgetItem* m_gaugeGroup;
+    QTreeWidgetItem* m_histogramGroup;
+    QHash<QString, QTreeWidgetItem*> m_rows;   // 指标名 -> 行，刷新时原地更新，不打乱展开和滚动位置
+
+    // 吞吐按两次刷新之间的字节增量计算
+    QElapsedTimer m_sampleTimer;
+    qint64 m_lastBytes = -1;
+
+    QTreeWidgetItem* row(QTreeWidgetItem* group, const QString& name);
+};
+
+#endif // METRICSPANEL_H
@@ -1,15 +1,30 @@
 ﻿#include "phaPullFromPolyhaven.h"
 #include <QtCore/QDebug>
 #include <QtCore/QCryptographicHash>
+#include <QtCore/QSettings>
 #include <atomic>        // 原子计数
 #include "AssetDownloadTask.h"
-
-// 初始化 PHPlugin 静态变量
-bool PHPlugin::PH_PROGRESS_CANCEL = false;
+#include "filehash.h"
+#include "service_urls.h"
+#include "metrics.h"
+
+// 配置项的键（QSettings(SETTINGS_ORG_NAME, SETTINGS_APP_NAME)）
+static const char* CONCURRENCY_FLOOR_KEY = "DownloadConcurrencyFloor";     // 下载并发下界
+static const char* CONCURRENCY_CEILING_KEY = "DownloadConcurrencyCeiling"; // 下载并发上界
+static const char* DOWNLOAD_TARGETS_KEY = "DownloadTargets";               // 下载目标，如 "1k:hdr, 4k:exr"
+static const char* CONTENT_STORE_KEY = "ContentStoreEnabled";              // 启用内容寻址仓库（硬链接去重）
+static const char* LIBRARY_BUDGET_KEY = "LibraryBudgetGB";                 // 资产库磁盘预算（GB，0 表示不限制）
+static const char* LIBRARY_KEEP_RES_KEY = "LibraryKeepResolution";         // 不淘汰的分辨率上限，如 "1k"
+static const char* EXPORT_INFO_JSON_KEY = "ExportInfoJson";                // 同时导出各资产目录下的 info.json
+static const char* API_BASE_URL_KEY = "ApiBaseUrl";                        // API 根地址（镜像站 / 本地假服务器）
+static const char* CDN_BASE_URL_KEY = "CdnBaseUrl";                        // 缩略图 CDN 根地址
 
 phaPullFromPolyhaven::phaPullFromPolyhaven(QObject* parent)
     : QObject(parent)
 {
+    // 下载走调度器私有的线程池，不动 Houdini 共用的 globalInstance
+    m_scheduler = new DownloadScheduler();
+
     m_workerThread = new QThread(this);
     this->moveToThread(m_workerThread);
     m_workerThread->start();
@@ -22,9 +37,50 @@ phaPullFromPolyhaven::~phaPullFromPolyhaven()
         m_workerThread->quit();
         m_workerThread->wait();
     }
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const QSharedPointer<OnDemandFetch>& fetch : std::as_const(m_onDemand))
+            fetch->cancelled.store(true);
+    }
+    // 等待仍在运行的阶段任务结束（它们持有 this）
+    delete m_scheduler;
+    m_cache.flush();
     m_workerThread->deleteLater();
 }
 
+void phaPullFromPolyhaven::loadSettings()
+{
+    QSettings settings(SETTINGS_ORG_NAME, SETTINGS_APP_NAME);
+    loadSettings(settings);
+}
+
+void phaPullFromPolyhaven::loadSettings(const QSettings& settings)
+{
+    // 并发上下界、下载目标可在配置中覆盖，未配置时沿用默认值
+    if (settings.contains(CONCURRENCY_FLOOR_KEY) || settings.contains(CONCURRENCY_CEILING_KEY)) {
+        setConcurrencyBounds(settings.value(CONCURRENCY_FLOOR_KEY, 2).toInt(),
+            settings.value(CONCURRENCY_CEILING_KEY, 16).toInt());
+    }
+    // 多分辨率 / 多格式：一次拉取规划全部目标
+    const QVector<DownloadTarget> targets = parse_download_targets(settings.value(DOWNLOAD_TARGETS_KEY).toString());
+    if (!targets.isEmpty())
+        setTargets(targets);
+    setUseContentStore(settings.value(CONTENT_STORE_KEY, false).toBool());
+    // 元数据只存一份在资产库根目录；需要时仍导出各资产的 info.json
+    setExportInfoJson(settings.value(EXPORT_INFO_JSON_KEY, false).toBool());
+    // 磁盘预算：资产库当缓存用，超出时淘汰最久未用的高分辨率本体
+    const double budgetGB = settings.value(LIBRARY_BUDGET_KEY, 0.0).toDouble();
+    if (budgetGB > 0.0) {
+        setLibraryBudget(qint64(budgetGB * 1024.0 * 1024.0 * 1024.0),
+            settings.value(LIBRARY_KEEP_RES_KEY, "1k").toString());
+    }
+    // 服务地址：未配置时为官方地址（或环境变量 PH_API_BASE_URL / PH_CDN_BASE_URL）
+    if (settings.contains(API_BASE_URL_KEY) || settings.contains(CDN_BASE_URL_KEY)) {
+        set_service_base_urls(settings.value(API_BASE_URL_KEY).toString(),
+            settings.value(CDN_BASE_URL_KEY).toString());
+    }
+}
+
 void phaPullFromPolyhaven::setAssetType(const QString& type)
 {
     QMutexLocker locker(&m_mutex);
@@ -37,54 +93,310 @@ void phaPullFromPolyhaven::setRevalidate(bool revalidate)
     m_revalidate = revalidate;
 }
 
-/* ---------- 异步入口 ---------- */
+void phaPullFromPolyhaven::setSlugFilter(const QStringList& slugs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_slugFilter = slugs;
+}
+
+void phaPullFromPolyhaven::setDryRun(bool dryRun)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dryRun = dryRun;
+}
+
+void phaPullFromPolyhaven::setUseContentStore(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_useContentStore = enabled;
+}
+
+void phaPullFromPolyhaven::setExportInfoJson(bool enabled)
+{
+    m_metadata.setExportInfoJson(enabled);
+}
+
+void phaPullFromPolyhaven::setLibraryBudget(qint64 bytes, const QString& keepRes)
+{
+    m_cache.setBudget(bytes, keepRes);
+}
+
+/* ---------- 使用记录 + 按需拉回（GUI 线程调用，遍历目录在调度器的独立线程，下载走 Payload 队列） ---------- */
+void phaPullFromPolyhaven::recordAssetUse(const QString& slug)
+{
+    if (slug.isEmpty())
+        return;
+    const QString libPath = get_asset_lib_path();
+    m_scheduler->runDetached([this, slug, libPath]() {
+        m_cache.setLibraryPath(libPath);
+        m_cache.touchAsset(slug);
+        // 访问记录攒一段时间再写盘，连续拖入多个资产只写一次
+        QMetaObject::invokeMethod(this, &phaPullFromPolyhaven::scheduleCacheFlush, Qt::QueuedConnection);
+        if (!m_cache.evictedFiles(slug).isEmpty())
+            fetchEvicted(slug);
+    });
+}
+
+/* ---------- 子线程：访问记录延迟写盘 ---------- */
+void phaPullFromPolyhaven::scheduleCacheFlush()
+{
+    // 定时器必须在工作线程里创建
+    if (!m_cacheFlushTimer) {
+        m_cacheFlushTimer = new QTimer(this);
+        m_cacheFlushTimer->setSingleShot(true);
+        m_cacheFlushTimer->setInterval(5000);
+        connect(m_cacheFlushTimer, &QTimer::timeout, this, [this]() { m_cache.flush(); });
+    }
+    m_cacheFlushTimer->start();
+}
+
+void phaPullFromPolyhaven::setTargets(const QVector<DownloadTarget>& targets)
+{
+    QVector<DownloadTarget> sorted = targets;
+    sort_download_targets(sorted);
+    if (sorted.isEmpty())
+        return;
+    QMutexLocker locker(&m_mutex);
+    m_targets = sorted;
+}
+
+QVector<DownloadTarget> phaPullFromPolyhaven::targets() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_targets;
+}
+
+void phaPullFromPolyhaven::setStageLimit(DownloadStage stage, int limit)
+{
+    m_scheduler->setStageLimit(stage, limit);
+}
+
+void phaPullFromPolyhaven::setConcurrencyBounds(int floor, int ceiling)
+{
+    m_scheduler->setConcurrencyBounds(floor, ceiling);
+}
+
+/* ---------- 提权（任意线程可调，调度器内部加锁） ---------- */
+void phaPullFromPolyhaven::boostAsset(const QString& slug)
+{
+    if (!slug.isEmpty())
+        m_scheduler->boost(slug);
+}
+
+/* ---------- 异步入口（调用方线程只投递，不做任何 IO） ---------- */
 void phaPullFromPolyhaven::executeAsync()
 {
-    m_asyncResultCode = 0;
     m_isCancelled.store(false);
+    QMetaObject::invokeMethod(this, "doExecuteAsync", Qt::QueuedConnection);
+}
+
+/* ---------- 校验入口（整个过程在调度器的独立线程，内部再按核数并行） ---------- */
+void phaPullFromPolyhaven::verifyAsync()
+{
+    m_isCancelled.store(false);
+    QString assetType;
+    {
+        QMutexLocker locker(&m_mutex);
+        assetType = m_assetType;
+    }
+    m_scheduler->runDetached([this, assetType]() { verifyLibrary(assetType); });
+}
+
+/* ---------- 续传入口：重放日志中未完成的文件 ---------- */
+void phaPullFromPolyhaven::resumeAsync()
+{
+    m_isCancelled.store(false);
+    setDryRun(false);
+    QMetaObject::invokeMethod(this, "doResumeAsync", Qt::QueuedConnection);
+}
+
+/* ---------- 任意线程：上次中断的同步留下的文件 ---------- */
+QVector<SyncFile> phaPullFromPolyhaven::interruptedFiles()
+{
+    const QString libPath = get_asset_lib_path();
+    if (libPath.isEmpty() || !m_journal.open(libPath))
+        return QVector<SyncFile>();
+    return m_journal.pendingFiles();
+}
+
+/* ---------- 子线程：重置本次拉取的状态并校验资产库（失败时已发出 executeFinished） ---------- */
+bool phaPullFromPolyhaven::beginRun()
+{
+    m_asyncResultCode = 0;
     m_currentProgress = 0;
     m_downloadedCount.store(0);
     m_failedCount.store(0);
     m_currentProgressText.clear();
-    PHPlugin::PH_PROGRESS_CANCEL = false;
+    m_totalToFetch = 0;
+    m_dispatched.clear();
+    m_deferredMetadata.clear();
+    m_assetProgress.clear();
+    m_plan.clear();
+    m_urlInFlight.clear();
+    m_urlCompleted.clear();
+    m_urlWaiters.clear();
+    m_plannedBytes.store(0);
+    m_transferredBytes.store(0);
+    m_lastSampleBytes = 0;
+    m_smoothedRate = 0.0;
 
     QString assetLibPath = get_asset_lib_path();
     QDir libDir(assetLibPath);
     if (assetLibPath.isEmpty() || libDir.dirName() != "Poly Haven") {
         Q_EMIT report("ERROR", "First open Preferences > File Paths and create an asset library named \"Poly Haven\"");
         Q_EMIT executeFinished(-1);
-        return;
+        return false;
     }
     if (!libDir.exists()) {
         Q_EMIT report("ERROR", "Asset library path not found! Please check the folder still exists");
         Q_EMIT executeFinished(-2);
+        return false;
+    }
+
+    m_asyncLibDir = libDir;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_runTargets = m_targets;
+        m_runSlugs = QSet<QString>(m_slugFilter.cbegin(), m_slugFilter.cend());
+        m_store = m_useContentStore ? ContentStore(libDir.path()) : ContentStore();
+    }
+    m_cache.setLibraryPath(libDir.path());
+    m_hashes.setLibraryPath(libDir.path());
+    m_metadata.setLibraryPath(libDir.path());
+    if (!m_journal.open(libDir.path()))
+        Q_EMIT report("WARN", "Failed to open the sync journal; this run cannot be resumed after a crash");
+
+    // 定时器必须在工作线程里创建
+    if (!m_throughputTimer) {
+        m_throughputTimer = new QTimer(this);
+        m_throughputTimer->setInterval(1000);
+        connect(m_throughputTimer, &QTimer::timeout, this, &phaPullFromPolyhaven::sampleThroughput);
+    }
+    m_throughputClock.start();
+    m_throughputTimer->start();
+    return true;
+}
+
+/* ---------- 子线程：校验资产库并启动列表获取 ---------- */
+void phaPullFromPolyhaven::doExecuteAsync()
+{
+    if (!beginRun())
         return;
+    // 上次未完成的文件并入本次：所属资产重新规划时补齐（.part 从断点续传），
+    // 本次没有涉及的资产留在日志里，下次打开浏览器时仍可续传
+    if (!m_dryRun) {
+        const int carried = m_journal.pendingFiles().size();
+        if (carried > 0)
+            Q_EMIT report("INFO", QString("%1 files left unfinished by the last sync will be re-planned").arg(carried));
+        m_journal.beginRun();
+    }
+
+    // 列表阶段自身占一个计数，列表全部到齐后才释放，避免先到的资产下完就提前收尾
+    m_remaining.store(1);
+    Q_EMIT progressUpdated(0, 0, "Fetching asset list...");
+
+    QString assetType;
+    {
+        QMutexLocker locker(&m_mutex);
+        assetType = m_assetType;
+    }
+    m_scheduler->runDetached([this, assetType]() { fetchListing(assetType); });
+}
+
+/* ---------- 子线程：跳过列表和清单，直接派发日志中未完成的文件 ---------- */
+void phaPullFromPolyhaven::doResumeAsync()
+{
+    if (!beginRun())
+        return;
+
+    const QVector<SyncFile> pending = m_journal.pendingFiles();
+    QMap<QString, QVector<SyncFile>> bySlug;
+    for (const SyncFile& file : pending)
+        bySlug[file.slug].append(file);
+
+    // 派发期间占一个计数，防止先派发的资产完成时提前收尾
+    m_remaining.store(1);
+    for (auto it = bySlug.constBegin(); it != bySlug.constEnd(); ++it) {
+        m_dispatched.insert(it.key());
+        ++m_totalToFetch;
+        m_remaining.fetch_add(1, std::memory_order_relaxed);
+
+        AssetProgress& progress = m_assetProgress[it.key()];
+        progress.asset.insert(it.key(), QJsonObject());
+        m_plan.addAsset(it.value());
+        qint64 bytes = 0;
+        for (const SyncFile& file : it.value())
+            bytes += file.size;
+        m_plannedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        dispatchPayloads(progress, it.value());
+    }
+    Q_EMIT report("INFO", QString("Resuming interrupted sync: %1").arg(m_plan.summary()));
+    Q_EMIT progressUpdated(0, m_totalToFetch, QString("Resuming %1 assets...").arg(m_totalToFetch));
+
+    if (m_remaining.fetch_sub(1, std::memory_order_relaxed) == 1)
+        allTasksFinished();
+}
+
+/* ---------- 线程池：缓存列表先行派发，网络列表随后补齐 ---------- */
+void phaPullFromPolyhaven::fetchListing(const QString& assetType)
+{
+    // 1. 本地缓存中已知的资产立即开始下载
+    QMap<QString, QJsonObject> cached = load_cached_asset_list(assetType);
+    if (!cached.isEmpty() && !m_isCancelled.load(std::memory_order_relaxed)) {
+        QMetaObject::invokeMethod(this, [this, cached]() {
+            processAssets(cached, m_asyncLibDir, true);
+        }, Qt::QueuedConnection);
     }
 
+    // 2. 阻塞的网络请求 + 解析只占用这个池线程
     QString error;
-    QMap<QString, QJsonObject> assets = get_asset_list(m_assetType, true, error);
+    QMap<QString, QJsonObject> fresh;
+    if (!m_isCancelled.load(std::memory_order_relaxed)) {
+        QByteArray raw = fetch_asset_list_raw(assetType, error);
+        if (error.isEmpty())
+            fresh = parse_asset_list_raw(raw, error);
+        if (error.isEmpty()) {
+            write_asset_list_cache(raw);
+            Q_EMIT catalogueUpdated();
+        }
+    }
+
+    QMetaObject::invokeMethod(this, [this, fresh, error]() {
+        onListingFinished(fresh, error);
+    }, Qt::QueuedConnection);
+}
+
+/* ---------- 子线程：网络列表到达 ---------- */
+void phaPullFromPolyhaven::onListingFinished(const QMap<QString, QJsonObject>& fresh, const QString& error)
+{
     if (!error.isEmpty()) {
-        Q_EMIT report("ERROR", error);
-        Q_EMIT executeFinished(-3);
-        return;
+        if (m_dispatched.isEmpty()) {
+            m_remaining.store(0);
+            m_throughputTimer->stop();
+            Q_EMIT report("ERROR", error);
+            Q_EMIT executeFinished(-3);
+            return;
+        }
+        Q_EMIT report("WARN", QString("Failed to refresh asset list, continuing with cached list: %1").arg(error));
+        flushDeferredMetadata();
     }
-    if (assets.isEmpty()) {
+    else if (fresh.isEmpty() && m_dispatched.isEmpty()) {
+        m_remaining.store(0);
+        m_throughputTimer->stop();
         Q_EMIT report("INFO", "No assets found to download");
         Q_EMIT finished(0, 0);
         Q_EMIT executeFinished(0);
         return;
     }
+    else {
+        processAssets(fresh, m_asyncLibDir);
+        // 网络列表里已没有的资产（下架）按缓存的条目规划
+        flushDeferredMetadata();
+    }
 
-    m_asyncAssets = assets;
-    m_asyncLibDir = libDir;
-    QMetaObject::invokeMethod(this, "doExecuteAsync", Qt::QueuedConnection);
-}
-
-/* ---------- 子线程真正干活 ---------- */
-void phaPullFromPolyhaven::doExecuteAsync()
-{
-    processAssets(m_asyncAssets, m_asyncLibDir);
-    /* 收尾信号由 allTasksFinished() 发出，不再这里立即调用 */
+    // 释放列表阶段的计数
+    if (m_remaining.fetch_sub(1, std::memory_order_relaxed) == 1)
+        allTasksFinished();
 }
 
 /* ---------- 取消 ---------- */
@@ -92,59 +404,196 @@ void phaPullFromPolyhaven::cancelDownload()
 {
     QMutexLocker locker(&m_mutex);
     m_isCancelled.store(true);
-    PHPlugin::PH_PROGRESS_CANCEL = true;
-    
 }
 
-/* ---------- 处理资产：全局线程池 + 原子计数 ---------- */
+/* ---------- 处理资产：分阶段调度 + 原子计数（可多次调用，已派发的 slug 跳过） ---------- */
+// 缓存列表先行时只派发缩略图：元数据阶段要拿列表里的 files_hash 判断清单是否过期，
+// 用缓存的条目会拿旧值和自己比，Poly Haven 重新发布过的资产整次拉取都被当成最新。
+// 这些资产的元数据阶段等网络列表到达后用新条目入队（列表获取失败时用缓存的条目）
 void phaPullFromPolyhaven::processAssets(const QMap<QString, QJsonObject>& assets,
-    const QDir& libDirPath)
+    const QDir& libDirPath, bool fromCache)
 {
-
-    m_totalToFetch = assets.size();
-    Q_EMIT progressUpdated(0, m_totalToFetch, "Preparing download tasks...");
-
-    QThreadPool* pool = QThreadPool::globalInstance();
-    pool->setMaxThreadCount(qMin(4, QThread::idealThreadCount() * 2));
-    //pool->setMaxThreadCount(1);
-
-    m_remaining.store(assets.size());
+    Q_UNUSED(libDirPath);
     QMap<QString, QJsonObject> asset;
 
     for (auto it = assets.constBegin(); it != assets.constEnd(); ++it) {
-        if (m_isCancelled.load(std::memory_order_relaxed)) {
-            if (m_remaining.fetch_sub(1, std::memory_order_relaxed) == 1)
-                Q_EMIT allTasksFinished();
+        if (m_isCancelled.load(std::memory_order_relaxed))
+            break;
+        if (m_dispatched.contains(it.key())) {
+            if (!fromCache && m_deferredMetadata.contains(it.key())) {
+                auto progress = m_assetProgress.find(it.key());
+                if (progress != m_assetProgress.end())
+                    progress.value().asset[it.key()] = it.value();
+            }
             continue;
         }
+        if (!m_runSlugs.isEmpty() && !m_runSlugs.contains(it.key()))
+            continue;
+        m_dispatched.insert(it.key());
+        ++m_totalToFetch;
+        m_remaining.fetch_add(1, std::memory_order_relaxed);
+
         asset.clear();
         asset.insert(it.key(), it.value());
-        AssetDownloadTask* task = new AssetDownloadTask(asset, libDirPath, m_revalidate, this);
-        connect(task, &AssetDownloadTask::taskFinished,
-            this, &phaPullFromPolyhaven::handleTaskFinished,
-            Qt::QueuedConnection);
-        task->setAutoDelete(true);
-        pool->start(task);
+
+        // 缩略图地址只依赖 slug，与元数据并行入队；本体要等元数据阶段规划出文件
+        AssetProgress& progress = m_assetProgress[it.key()];
+        progress.asset = asset;
+        progress.pendingStages = 1;
+        if (fromCache)
+            m_deferredMetadata.insert(it.key());
+        else
+            enqueueStage(asset, DownloadStage::Metadata);
+        if (!m_dryRun) {
+            ++progress.pendingStages;
+            enqueueStage(asset, DownloadStage::Thumbnail);
+        }
+    }
+
+    int cur = m_currentProgress.load(std::memory_order_relaxed);
+    Q_EMIT progressUpdated(cur, m_totalToFetch, QString("Queued %1 assets...").arg(m_totalToFetch));
+}
+
+/* ---------- 子线程：网络列表已到（或获取失败），放行等待的元数据阶段 ---------- */
+void phaPullFromPolyhaven::flushDeferredMetadata()
+{
+    const QSet<QString> deferred = m_deferredMetadata;
+    m_deferredMetadata.clear();
+    for (const QString& slug : deferred) {
+        auto progress = m_assetProgress.constFind(slug);
+        if (progress != m_assetProgress.constEnd())
+            enqueueStage(progress.value().asset, DownloadStage::Metadata);
     }
-    /* 无 waitForDone！函数立即返回，事件循环继续 */
 }
 
-/* ---------- 单任务完成槽 ---------- */
+/* ---------- 子线程：把资产的某个阶段交给调度器 ---------- */
+void phaPullFromPolyhaven::enqueueStage(const QMap<QString, QJsonObject>& asset, DownloadStage stage, const SyncFile& file)
+{
+    AssetDownloadTask* task = new AssetDownloadTask(asset, m_asyncLibDir, m_revalidate, this, stage, file);
+    connect(task, &AssetDownloadTask::taskFinished,
+        this, &phaPullFromPolyhaven::handleTaskFinished,
+        Qt::QueuedConnection);
+    task->setAutoDelete(true);
+    m_scheduler->enqueue(stage, asset.firstKey(), task, file.size);
+}
+
+/* ---------- 单阶段完成槽 ---------- */
 void phaPullFromPolyhaven::handleTaskFinished(const DownloadResult& res)
 {
-    if (res.error.isEmpty()) {
+    auto it = m_assetProgress.find(res.slug);
+    if (it == m_assetProgress.end())
+        return;
+    AssetProgress& progress = it.value();
+
+    if (!res.error.isEmpty()) {
+        progress.errors.append(res.error);
+    }
+    else if (res.stage == DownloadStage::Metadata) {
+        if (!m_dryRun)
+            m_journal.settleAsset(res.slug, res.files);
         if (res.exists) {
+            progress.exists = true;
+            m_plan.addAsset(QVector<SyncFile>());
+        }
+        else {
+            m_plan.addAsset(res.files);
+            qint64 bytes = 0;
+            for (const SyncFile& file : res.files) {
+                if (!file.inStore)
+                    bytes += file.size;
+            }
+            m_plannedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+            if (!m_dryRun) {
+                m_journal.recordPlanned(res.files);
+                dispatchPayloads(progress, res.files);
+            }
+        }
+    }
+
+    if (res.stage == DownloadStage::Payload && !res.files.isEmpty()) {
+        const SyncFile& file = res.files.constFirst();
+        if (res.error.isEmpty())
+            m_journal.recordCompleted(file.localPath);
+        else
+            m_journal.recordFailed(file.localPath, res.error);
+        releaseUrlWaiters(file, res.error.isEmpty());
+    }
+
+    if (--progress.pendingStages == 0)
+        finishAsset(res.slug);
+}
+
+/* ---------- 子线程：为资产的每个待传文件派发 Payload 任务（按 URL 去重） ---------- */
+void phaPullFromPolyhaven::dispatchPayloads(AssetProgress& progress, const QVector<SyncFile>& files)
+{
+    // 每个文件一个 Payload 任务（贴图集几十个文件并行），调度器按文件大小排序，小目标先下
+    for (SyncFile file : files) {
+        ++progress.pendingStages;
+        if (m_urlCompleted.contains(file.url)) {
+            // 别的资产已经下好同一文件：本地复制
+            file.sourcePath = m_urlCompleted.value(file.url);
+            enqueueStage(progress.asset, DownloadStage::Payload, file);
+        }
+        else if (m_urlInFlight.contains(file.url)) {
+            // 同一文件正在为别的资产下载：等它完成
+            m_urlWaiters[file.url].append(file);
+        }
+        else {
+            m_urlInFlight.insert(file.url);
+            enqueueStage(progress.asset, DownloadStage::Payload, file);
+        }
+    }
+}
+
+/* ---------- 子线程：跨资产共享文件下载结束，放行等待者 ---------- */
+void phaPullFromPolyhaven::releaseUrlWaiters(const SyncFile& file, bool succeeded)
+{
+    // 复制任务本身不是下载方
+    if (!file.sourcePath.isEmpty())
+        return;
+    m_urlInFlight.remove(file.url);
+    if (succeeded)
+        m_urlCompleted.insert(file.url, file.localPath);
+
+    const QVector<SyncFile> waiters = m_urlWaiters.take(file.url);
+    for (int i = 0; i < waiters.size(); ++i) {
+        SyncFile waiter = waiters[i];
+        auto it = m_assetProgress.find(waiter.slug);
+        if (it == m_assetProgress.end())
+            continue;
+        if (succeeded) {
+            waiter.sourcePath = file.localPath;
+        }
+        else if (i == 0) {
+            // 下载方失败：第一个等待者接手下载，其余继续等它
+            m_urlInFlight.insert(waiter.url);
+            m_urlWaiters[waiter.url] = waiters.mid(1);
+            enqueueStage(it.value().asset, DownloadStage::Payload, waiter);
+            break;
+        }
+        enqueueStage(it.value().asset, DownloadStage::Payload, waiter);
+    }
+}
+
+/* ---------- 子线程：资产全部阶段结束 ---------- */
+void phaPullFromPolyhaven::finishAsset(const QString& slug)
+{
+    AssetProgress progress = m_assetProgress.take(slug);
+    m_scheduler->unboost(slug);
+    if (progress.errors.isEmpty()) {
+        if (progress.exists) {
             m_downloadedCount.fetch_add(1, std::memory_order_relaxed);
-            Q_EMIT report("INFO", QString("Asset %1 already exists").arg(res.slug));
+            Q_EMIT report("INFO", QString("Asset %1 already exists").arg(slug));
         }
         else {
             m_downloadedCount.fetch_add(1, std::memory_order_relaxed);
-            Q_EMIT report("INFO", QString("Successfully downloaded asset: %1").arg(res.slug));
+            Q_EMIT report("INFO", QString("Successfully downloaded asset: %1").arg(slug));
         }
     }
     else {
         m_failedCount.fetch_add(1, std::memory_order_relaxed);
-        Q_EMIT report("ERROR", QString("Failed to download asset %1: %2").arg(res.slug).arg(res.error));
+        Q_EMIT report("ERROR", QString("Failed to download asset %1: %2").arg(slug).arg(progress.errors.join("; ")));
     }
     int cur = m_currentProgress.fetch_add(1, std::memory_order_relaxed) + 1;
     Q_EMIT progressUpdated(cur, m_totalToFetch, QString("Processing asset %1/%2...").arg(cur).arg(m_totalToFetch));
@@ -153,9 +602,36 @@ void phaPullFromPolyhaven::handleTaskFinished(const DownloadResult& res)
         Q_EMIT allTasksFinished();
 }
 
+/* ---------- 子线程定时：字节进度 + 指数平滑吞吐 + ETA ---------- */
+void phaPullFromPolyhaven::sampleThroughput()
+{
+    // 平滑系数：越大越跟手，越小越稳
+    static const double RATE_SMOOTHING = 0.2;
+
+    const qint64 elapsedMs = m_throughputClock.restart();
+    const qint64 done = m_transferredBytes.load(std::memory_order_relaxed);
+    const qint64 total = m_plannedBytes.load(std::memory_order_relaxed);
+    if (elapsedMs > 0) {
+        const double rate = double(done - m_lastSampleBytes) * 1000.0 / double(elapsedMs);
+        m_smoothedRate = m_smoothedRate <= 0.0 ? rate
+                                               : RATE_SMOOTHING * rate + (1.0 - RATE_SMOOTHING) * m_smoothedRate;
+    }
+    m_lastSampleBytes = done;
+
+    const qint64 remainingBytes = qMax<qint64>(0, total - done);
+    const qint64 eta = m_smoothedRate > 1.0 ? qint64(remainingBytes / m_smoothedRate) : -1;
+    Q_EMIT byteProgressUpdated(done, total, m_smoothedRate, eta);
+}
+
 /* ---------- 全部任务完成槽 ---------- */
 void phaPullFromPolyhaven::allTasksFinished()
 {
+    m_throughputTimer->stop();
+    sampleThroughput();
+    Q_EMIT report("INFO", (m_dryRun ? QString("Dry run: ") : QString("Plan: ")) + m_plan.summary());
+    if (m_dryRun)
+        Q_EMIT planReady(m_plan.files.size(), m_plan.totalBytes, m_plan.summary());
+
     if (m_isCancelled.load(std::memory_order_relaxed)) {
         m_asyncResultCode = 1;
         Q_EMIT report("INFO", "Download cancelled by user");
@@ -166,262 +642,380 @@ void phaPullFromPolyhaven::allTasksFinished()
     Q_EMIT finished(m_downloadedCount.load(), m_failedCount.load());
     Q_EMIT executeFinished(m_asyncResultCode);
 
+    m_hashes.save();
+    m_metadata.flush();
+    m_cache.flush();
+    // 日志只留下仍未完成的文件（失败、取消），下次启动时可继续
+    if (!m_dryRun)
+        m_journal.finishRun();
+
+    // 刚下好的文件 mtime 最新，排在 LRU 末尾；扫描整个资产库放到池线程
+    if (!m_dryRun && m_asyncResultCode == 0 && m_cache.budget() > 0) {
+        m_scheduler->runDetached([this]() {
+            const EvictionReport eviction = m_cache.enforceBudget();
+            Q_EMIT report(eviction.error.isEmpty() ? "INFO" : "WARN", eviction.summary());
+        });
+    }
+
     /* 数据清空放主线程 */
-    m_asyncAssets.clear();
+    m_dispatched.clear();
+    m_deferredMetadata.clear();
+    m_assetProgress.clear();
+    m_urlInFlight.clear();
+    m_urlCompleted.clear();
+    m_urlWaiters.clear();
     m_asyncLibDir = QDir();
 }
 
 
 
-/* 以下四个函数未改动，原样保留 */
-DownloadResult phaPullFromPolyhaven::updateAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath, bool dryRun)
+/* ---------- 线程池：Metadata 阶段（存在性检查 + 元数据 + 规划待传文件） ---------- */
+DownloadResult phaPullFromPolyhaven::updateAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath)
 {
     DownloadResult result;
     result.slug = asset.keys().constFirst();
     result.exists = false;
+    // 资产目录在真正写文件时才创建（缩略图、本体各自 mkpath），规划阶段不碰磁盘
     QDir assetDir(libDirPath.filePath(result.slug));
-    if (!assetDir.exists() && !assetDir.mkpath(".")) {
-        result.error = QString("Failed to create asset directory: %1").arg(assetDir.path());
-        return result;
-    }
-    QFileInfo infoFp(assetDir.filePath("info.json"));//E:\Resource\Poly Haven\billiard_hall\info.json
-    //QFileInfo thumbFp(assetDir.filePath("thumbnail.webp")); //E:\Resource\Poly Haven\billiard_hall\thumbnail.webp
-    bool needUpdate = true;
-    if (infoFp.exists() && !m_revalidate) {
-        if (!checkAssetExists(asset, infoFp, needUpdate)) {
-            result.error = QString("Failed to check asset %1 existence").arg(asset.firstKey());
-            return result;
-        }
-        if (!needUpdate) {
-            result.exists = true;
-            return result;
-        }
-    }
-    if (dryRun) {
-        result.exists = infoFp.exists();
-        return result;
+    // 已知资产也按缓存的清单重新规划：元数据先于本体落盘，上次中断的文件只能靠这一步补齐；
+    // -r 和过期判断只决定是否重新请求 /files。规划查在库表，不逐个 stat
+    const bool refetch = m_revalidate || m_metadata.isStale(result.slug, asset.first());
+    QJsonObject infoJson;
+    QString err = fetchAssetInfo(asset, infoJson, refetch);
+    QStringList skipped;
+    if (err.isEmpty())
+        err = plan_asset_files(result.slug, assetDir, infoJson, m_runTargets, result.files, skipped,
+            m_store.isValid() ? &m_store : nullptr, &m_hashes, &m_presence);
+    // 缺某个分辨率 / 格式的提示只在清单更新时给一次，不必每次同步都刷
+    if (refetch) {
+        for (const QString& reason : skipped)
+            Q_EMIT report("WARN", reason);
     }
-    QString err = downloadAsset(asset, libDirPath, infoFp);
-    if (!err.isEmpty()) result.error = err;
+    // 按预算淘汰过的文件不随同步补齐，用到时由 recordAssetUse 拉回
+    result.files.removeIf([this](const SyncFile& file) { return m_cache.isEvicted(file.localPath); });
+    if (!err.isEmpty())
+        result.error = err;
+    else
+        result.exists = result.files.isEmpty();
     return result;
 }
 
-QString phaPullFromPolyhaven::downloadAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath, const QFileInfo& infoFp)
+QString phaPullFromPolyhaven::fetchAssetInfo(const QMap<QString, QJsonObject>& asset, QJsonObject& infoJson, bool refetch)
 {
-    // 你的下载逻辑（之前已修复的版本，精准下载 hdri→1k→hdr）
-    QDir assetDir(libDirPath.filePath(asset.firstKey()));//assetDir E:\Resource\Poly Haven\billiard_hall
-    if (!assetDir.exists() && !assetDir.mkpath(".")) {
-        return QString("Failed to create asset directory: %1").arg(assetDir.path());
+    const QString slug = asset.firstKey();
+    // 不要求重新请求就直接用内存里的清单
+    if (!refetch && m_metadata.contains(slug)) {
+        infoJson = m_metadata.value(slug);
+        return "";
     }
 
-
-
-    QFile infoFile(infoFp.filePath());//E:\Resource\Poly Haven\billiard_hall\info.json
-    QFileInfo infofileinfo(infoFile);
-    QJsonObject infoJson = asset.value(asset.firstKey());
-    QJsonObject downloadJson;
-    if (!infofileinfo.exists() || infofileinfo.size() == 0)
-    {        
-        QUrl infoUrl = QString("https://api.polyhaven.com/files/%1").arg(asset.firstKey());
-        
-        downloadJson = QJsonDocument::fromJson(get(infoUrl)).object();
-        infoJson["files"] = downloadJson;
-        if (infoJson.isEmpty()) {
-            return QString("Failed to fetch asset info for %1").arg(asset.firstKey());
-        }
-
-        if (!infoFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            return QString("Failed to write info.json for %1: %2").arg(asset.firstKey()).arg(infoFile.errorString());
-        }
-        infoFile.write(QJsonDocument(infoJson).toJson(QJsonDocument::Indented));
-        infoFile.close();
+    infoJson = asset.value(slug);
+    QUrl infoUrl = QString("%1/files/%2").arg(api_base_url(), slug);
+    const QJsonObject downloadJson = QJsonDocument::fromJson(get(infoUrl)).object();
+    if (downloadJson.isEmpty()) {
+        return QString("Failed to fetch asset info for %1").arg(slug);
     }
-    else
-    {
-        // 步骤2：打开文件（只读模式 + 文本模式，避免二进制解析问题）
-        if (!infoFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            
-            return QString("Failed to open %1: %2").arg(asset.firstKey()).arg(infoFile.errorString());
-        }
-
-        // 步骤3：读取文件内容（全部读取为字符串）
-        QString jsonStr = infoFile.readAll();
-        infoFile.close(); // 读取完成后立即关闭文件（重要！）
-
-        // 步骤4：解析 JSON 字符串
-        QJsonParseError parseError;
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonStr.toUtf8(), &parseError);
-
-        // 步骤5：检查解析结果 + 转换为 QJsonObject
-        if (parseError.error != QJsonParseError::NoError) {
-
-            return QString(parseError.errorString());
-        }
-        if (!jsonDoc.isObject()) {
-            
-            return QString("shuzu");
-        }
+    infoJson["files"] = downloadJson;
+    return m_metadata.insert(slug, infoJson);
+}
 
-        // 成功解析为 QJsonObject
-        infoJson = jsonDoc.object();
+/* ---------- 线程池：Thumbnail 阶段 ---------- */
+QString phaPullFromPolyhaven::downloadThumbnail(const QString& slug, const QDir& assetDir)
+{
+    if (!assetDir.exists() && !assetDir.mkpath(".")) {
+        return QString("Failed to create asset directory: %1").arg(assetDir.path());
     }
 
-    
-
-
-
     QString thumbName = QString("thumbnail.webp");
     QString thumbPath = assetDir.filePath(thumbName);
     QFile thumbfile(thumbPath);
-    QFileInfo thumbfileinfo(thumbfile);
-    if (!thumbfileinfo.exists() || thumbfileinfo.size() == 0)
+    // 在库表可用时查表，否则 stat
+    qint64 thumbSize = -1;
+    if (!m_presence.lookup(thumbPath, thumbSize))
+        thumbSize = QFileInfo::exists(thumbPath) ? QFileInfo(thumbPath).size() : -1;
+    if (thumbSize <= 0)
     {
 
 
-        QUrl thumbUrl = QString("https://cdn.polyhaven.com/asset_img/thumbs/%1.png?width=256&height=256").arg(asset.firstKey());
+        QUrl thumbUrl = QString("%1/asset_img/thumbs/%2.png?width=256&height=256").arg(cdn_base_url(), slug);
 
         if (!download_file(thumbUrl, thumbPath))
         {
             return QString("Failed to download %1 for writing: %2").arg(thumbName).arg(thumbfile.errorString());
         }
+        m_presence.recordFile(thumbPath, QFileInfo(thumbPath).size());
+        Q_EMIT previewReady(slug);
     }
+    return "";
+}
 
+/* ---------- 线程池：Payload 阶段（下载计划中的单个文件） ---------- */
+QString phaPullFromPolyhaven::downloadPlannedFile(const SyncFile& file, OnDemandFetch* onDemand)
+{
+    // 按需拉回用自己的仓库、取消标记和字节计数，其余沿用本次同步的
+    const ContentStore& contentStore = onDemand ? onDemand->store : m_store;
+    const std::atomic<bool>& cancelled = onDemand ? onDemand->cancelled : m_isCancelled;
+    std::atomic<qint64>& plannedBytes = onDemand ? onDemand->plannedBytes : m_plannedBytes;
+    std::atomic<qint64>& transferredBytes = onDemand ? onDemand->transferredBytes : m_transferredBytes;
+    if (cancelled.load(std::memory_order_relaxed)) {
+        return "Cancelled while preparing download";
+    }
 
+    const QString fileName = QFileInfo(file.localPath).fileName();
+    // include 里的相对路径可能带子目录（textures/...）
+    QDir().mkpath(QFileInfo(file.localPath).absolutePath());
 
-
-
-
-    //TODO 有些info.json层级不一样 不知道为什么
-    if (infoJson.contains("files") && infoJson["files"].isObject()) {
-        QJsonObject filesJson = infoJson["files"].toObject();
-        if (!filesJson.contains("hdri") || !filesJson["hdri"].isObject()) {
-            return QString("Asset %1 has no '%2' hdri in files").arg(asset.firstKey()).arg("hdri");
+    if (!file.sourcePath.isEmpty()) {
+        QString err = link_or_copy(file.sourcePath, file.localPath);
+        if (!err.isEmpty()) {
+            plannedBytes.fetch_sub(file.size, std::memory_order_relaxed);
+            return err;
         }
+        transferredBytes.fetch_add(file.size, std::memory_order_relaxed);
+        m_presence.recordFile(file.localPath, file.size);
+        return "";
+    }
 
-        QJsonObject hdriJson = filesJson["hdri"].toObject();
-
-
-        const QString targetQuality = m_res;
-        if (!hdriJson.contains(targetQuality) || !hdriJson[targetQuality].isObject()) {
-            return QString("Asset %1 has no '%2' quality in hdri").arg(asset.firstKey()).arg(targetQuality);
+    // 内容仓库已有（规划时就有，或本次拉取中别的资产刚收录）：只建链接；本地损坏的不信任仓库
+    if (!file.stale && contentStore.contains(file.md5, file.size)) {
+        if (contentStore.materialize(file.md5, file.localPath).isEmpty()) {
+            m_cache.markFetched(file.localPath);
+            m_presence.recordFile(file.localPath, file.size);
+            if (!file.inStore)
+                plannedBytes.fetch_sub(file.size, std::memory_order_relaxed);
+            Q_EMIT report("INFO", QString("Linked %1 from content store").arg(fileName));
+            return "";
         }
+    }
+    if (file.inStore)
+        plannedBytes.fetch_add(file.size, std::memory_order_relaxed);
+
+    // 先写 .part，完成后改名；上次中断留下的 .part 从断点续传
+    const QString partPath = SyncJournal::partPath(file.localPath);
+    qint64 resumeFrom = QFileInfo(partPath).size();
+    if (file.size > 0 && resumeFrom > file.size) {
+        QFile::remove(partPath);
+        resumeFrom = 0;
+    }
+    if (resumeFrom > 0) {
+        // 续传即上次中断（网络错误 / 取消 / 崩溃）后的重试
+        static MetricCounter* const resumes = metrics_counter("net.resumes");
+        resumes->add();
+        transferredBytes.fetch_add(resumeFrom, std::memory_order_relaxed);
+        Q_EMIT report("INFO", QString("Resuming %1 at %2").arg(fileName).arg(format_bytes(resumeFrom)));
+    }
 
-        QJsonObject qualityJson = hdriJson[targetQuality].toObject();
-        const QString targetFormat = m_format;
-        if (!qualityJson.contains(targetFormat) || !qualityJson[targetFormat].isObject()) {
-            return QString("Asset %1 has no '%2' format in %3 quality").arg(asset.firstKey()).arg(targetFormat).arg(targetQuality);
+    // 每 16 MB 记一次检查点
+    static const qint64 CHECKPOINT_BYTES = 16 * 1024 * 1024;
+    qint64 received = 0;
+    qint64 checkpoint = 0;
+    // 改名前就已完整（上次在改名前中断）时不再请求
+    bool ok = (file.size > 0 && resumeFrom == file.size)
+        || download_file_resumable(QUrl(file.url), partPath, [&](qint64 delta) {
+            received += delta;
+            transferredBytes.fetch_add(delta, std::memory_order_relaxed);
+            if (received - checkpoint >= CHECKPOINT_BYTES) {
+                checkpoint = received;
+                if (!onDemand)
+                    m_journal.recordProgress(file.localPath, resumeFrom + received);
+            }
+            return !cancelled.load(std::memory_order_relaxed);
+        }, resumeFrom);
+
+    QString err;
+    if (!ok) {
+        const qint64 kept = QFileInfo(partPath).size();
+        if (kept > 0 && !onDemand)
+            m_journal.recordProgress(file.localPath, kept);
+        err = QString("Failed to download %1").arg(fileName);
+    }
+    else if (file.size > 0 && QFileInfo(partPath).size() != file.size) {
+        QFile::remove(partPath);
+        err = QString("Size mismatch for %1 (expected %2, got %3)").arg(fileName).arg(file.size).arg(resumeFrom + received);
+    }
+    else {
+        // 按 md5 寻址的仓库只收录校验过的内容；改名前校验 .part，不符时旧文件原样保留
+        const bool checkMd5 = contentStore.isValid() && !file.md5.isEmpty();
+        const QString actualMd5 = checkMd5 ? filehash(partPath) : QString();
+        if (checkMd5 && actualMd5.compare(file.md5, Qt::CaseInsensitive) != 0) {
+            QFile::remove(partPath);
+            err = QString("MD5 mismatch for %1 (expected %2, got %3)").arg(fileName).arg(file.md5).arg(actualMd5);
         }
-
-        QJsonObject formatJson = qualityJson[targetFormat].toObject();
-        QString fileUrl = formatJson["url"].toString();
-        if (fileUrl.isEmpty()) {
-            return QString("Asset %1 has empty URL for %2-%3").arg(asset.firstKey()).arg(targetQuality).arg(targetFormat);
+        else {
+            // 旧文件一直留到新文件完整下好：下载失败或取消时用户手里仍是上一版。
+            // 旧文件是指向仓库 blob 等共享内容的链接时先断开，其余情况改名直接原子替换
+            if (is_shared_link(file.localPath))
+                QFile::remove(file.localPath);
+            err = replace_file(partPath, file.localPath);
         }
-
-        if (m_isCancelled || PHPlugin::PH_PROGRESS_CANCEL) {
-            return "Cancelled while preparing download";
+        if (err.isEmpty() && checkMd5) {
+            // 旧文件可能就是损坏的 blob 的链接：用刚校验过的内容替换它
+            if (file.stale)
+                QFile::remove(contentStore.blobPath(file.md5));
+            QString storeErr = contentStore.ingest(file.localPath, file.md5);
+            if (!storeErr.isEmpty())
+                Q_EMIT report("WARN", storeErr);
+            // 刚算过的 md5 顺手记下，下次校验不必再读
+            m_hashes.insert(file.localPath, actualMd5);
         }
+    }
 
-        QUrl url(fileUrl);
-        QString fileName = QFileInfo(url.path()).fileName();//xxx_1k.hdr
-        if (fileName.isEmpty()) {
-            fileName = QString("%1_%2.%3").arg(asset.firstKey()).arg(targetQuality).arg(targetFormat);
-        }
+    if (!err.isEmpty()) {
+        // 失败的文件不再计入进度，ETA 的分子分母一起回退
+        transferredBytes.fetch_sub(resumeFrom + received, std::memory_order_relaxed);
+        plannedBytes.fetch_sub(file.size, std::memory_order_relaxed);
+        return err;
+    }
 
-        QString filePath = assetDir.filePath(fileName);
-        QFile file(filePath);
-        QFileInfo exrfileinfo(file);
-        if (!exrfileinfo.exists() || exrfileinfo.size() == 0)
-        {
+    m_cache.markFetched(file.localPath);
+    m_presence.recordFile(file.localPath, QFileInfo(file.localPath).size());
+    Q_EMIT report("INFO", QString("Downloaded %1 (%2) to %3").arg(fileName).arg(format_bytes(file.size)).arg(file.localPath));
+    return "";
+}
 
-            if (!download_file(url, filePath)) {
-                return QString("Failed to download %1 : %2").arg(fileName).arg(file.errorString());
-            }
-            /*
-            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
-                return QString("Failed to open %1 for writing: %2").arg(fileName).arg(file.errorString());
-            }
+/* ---------- 线程池：并行校验本地文件 ---------- */
+void phaPullFromPolyhaven::verifyLibrary(const QString& assetType)
+{
+    static const QStringList typeNames = { "hdris", "textures", "models" };
+    const int type = int(typeNames.indexOf(assetType));   // "all" -> -1
 
+    const QString libPath = get_asset_lib_path();
+    QDir libDir(libPath);
+    if (libPath.isEmpty() || !libDir.exists()) {
+        Q_EMIT report("ERROR", "Asset library path not found! Please check the folder still exists");
+        Q_EMIT verifyFinished(0, 0, QStringList());
+        return;
+    }
+    m_hashes.setLibraryPath(libPath);
+    m_metadata.setLibraryPath(libPath);
+
+    // 1. 从元数据库收集本地已有的清单文件
+    Q_EMIT progressUpdated(0, 0, "Collecting files to verify...");
+    QVector<SyncFile> files;
+    for (const QString& slug : m_metadata.slugs()) {
+        const QJsonObject infoJson = m_metadata.value(slug);
+        if (type >= 0 && infoJson["type"].toInt() != type)
+            continue;
+        collect_local_manifest_files(slug, QDir(libDir.filePath(slug)), infoJson, files, &m_presence);
+    }
 
-            QByteArray fileContent = winhttp_get_binary(fileUrl, error);
-            if (!error.isEmpty()) {
-                file.close();
-                file.remove();
-                return QString("Failed to download %1: %2").arg(fileName).arg(error);
-            }
-            file.write(fileContent);
-            file.close();
-            */
+    // 2. 先查哈希缓存（只 stat），未命中的交给 filehash_batch 按核数并行读
+    const int total = files.size();
+    QVector<QString> digests(total);
+    QStringList misses;
+    QVector<int> missRows;
+    for (int i = 0; i < total; ++i) {
+        if (!m_hashes.lookup(files[i].localPath, digests[i])) {
+            misses.append(files[i].localPath);
+            missRows.append(i);
         }
-
-        
-
-        /*
-        qint64 expectedSize = fileJson["size"].toInt();
-        if (expectedSize > 0 && fileContent.size() != expectedSize) {
-            file.close();
-            file.remove();
-            return QString("Size mismatch for %1 (expected %2, got %3)").arg(fileName).arg(expectedSize).arg(fileContent.size());
+    }
+    const int cached = total - misses.size();
+    const QStringList hashed = filehash_batch(misses, HashAlgorithm::Md5, 0, [&](int finished, int count) {
+        if (finished % 64 == 0 || finished == count)
+            Q_EMIT progressUpdated(cached + finished, total, QString("Verifying file %1/%2...").arg(cached + finished).arg(total));
+        return !m_isCancelled.load(std::memory_order_relaxed);
+    });
+    int hashedCount = 0;
+    for (int k = 0; k < hashed.size(); ++k) {
+        if (hashed[k].isEmpty())
+            continue;
+        digests[missRows[k]] = hashed[k];
+        m_hashes.insert(misses[k], hashed[k]);
+        ++hashedCount;
+    }
+    m_hashes.save();
+
+    // 3. 只报告不符的文件；哈希缓存里已记下其真实 md5，下次同步规划时按 stale 重新下载
+    const bool cancelled = m_isCancelled.load(std::memory_order_relaxed);
+    int checked = 0;
+    QStringList mismatches;
+    for (int i = 0; i < total; ++i) {
+        // 取消后没算到的文件不计；没取消却为空说明读取失败，按不符处理
+        if (digests[i].isEmpty() && cancelled)
+            continue;
+        ++checked;
+        if (digests[i].compare(files[i].md5, Qt::CaseInsensitive) != 0) {
+            mismatches.append(files[i].localPath);
+            Q_EMIT report("WARN", QString("Checksum mismatch: %1").arg(files[i].localPath));
         }
+    }
+    Q_EMIT report("INFO", QString("Verified %1 files (%2 read, %3 from hash cache), %4 mismatches")
+        .arg(checked).arg(hashedCount).arg(checked - hashedCount).arg(mismatches.size()));
+    Q_EMIT verifyFinished(checked, hashedCount, mismatches);
+}
 
-        qint64 writtenBytes = file.write(fileContent);
-        file.close();
-
-        if (writtenBytes != fileContent.size()) {
-            file.remove();
-            return QString("Failed to write %1 (written %2 of %3 bytes)").arg(fileName).arg(writtenBytes).arg(fileContent.size());
-        }
+/* ---------- 池线程：规划某资产被淘汰的文件，作为 Payload 任务交给调度器 ---------- */
+void phaPullFromPolyhaven::fetchEvicted(const QString& slug)
+{
+    QSharedPointer<OnDemandFetch> fetch(new OnDemandFetch);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_onDemand.contains(slug))
+            return;
+        m_onDemand.insert(slug, fetch);
+    }
 
-        QString expectedMd5 = fileJson["md5"].toString();
-        if (!expectedMd5.isEmpty()) {
-            QString actualMd5 = QCryptographicHash::hash(fileContent, QCryptographicHash::Md5).toHex();
-            if (actualMd5 != expectedMd5) {
-                file.remove();
-                return QString("MD5 mismatch for %1 (expected %2, got %3)").arg(fileName).arg(expectedMd5).arg(actualMd5);
-            }
-        }
-        */
+    const QString libPath = m_cache.libraryPath();
+    m_metadata.setLibraryPath(libPath);
+    const QJsonObject infoJson = m_metadata.value(slug);
+    if (infoJson.isEmpty()) {
+        finishEvicted(slug, QString("No metadata for %1, sync the asset first").arg(slug));
+        return;
+    }
 
-        Q_EMIT report("INFO", QString("Downloaded %1 (%2-%3) to %4").arg(fileName).arg(targetQuality).arg(targetFormat).arg(filePath));
+    QVector<DownloadTarget> targets;
+    bool useStore = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        targets = m_targets;
+        useStore = m_useContentStore;
     }
-    else {
-        return QString("Asset %1 has no 'hdri' node in info.json").arg(asset.firstKey());
+    fetch->store = useStore ? ContentStore(libPath) : ContentStore();
+
+    QVector<SyncFile> files;
+    QStringList skipped;
+    const QString err = plan_asset_files(slug, QDir(QDir(libPath).filePath(slug)), infoJson, targets, files, skipped,
+        fetch->store.isValid() ? &fetch->store : nullptr);
+    // 只补被淘汰的文件；其余缺失文件仍交给正常同步
+    files.removeIf([this](const SyncFile& file) { return !m_cache.isEvicted(file.localPath); });
+    if (!err.isEmpty() || files.isEmpty()) {
+        finishEvicted(slug, err);
+        return;
     }
 
-    return "";
+    // 用户正等着用：提权排到各队列最前，但仍受调度器的 ceiling 约束
+    fetch->remaining.store(files.size());
+    m_scheduler->boost(slug);
+    for (const SyncFile& file : files) {
+        if (!file.inStore)
+            fetch->plannedBytes.fetch_add(file.size, std::memory_order_relaxed);
+        m_scheduler->enqueue(DownloadStage::Payload, slug, QRunnable::create([this, fetch, file, slug]() {
+            const QString fileErr = downloadPlannedFile(file, fetch.data());
+            if (!fileErr.isEmpty()) {
+                QMutexLocker locker(&fetch->mutex);
+                fetch->errors.append(fileErr);
+            }
+            if (fetch->remaining.fetch_sub(1) != 1)
+                return;
+            QMutexLocker locker(&fetch->mutex);
+            const QString errors = fetch->errors.join("; ");
+            locker.unlock();
+            finishEvicted(slug, errors);
+        }), file.size);
+    }
 }
 
-bool phaPullFromPolyhaven::checkAssetExists(const QMap<QString, QJsonObject>& asset, const QFileInfo& infoFp, bool& needUpdate)
+/* ---------- 线程池：某资产的按需拉回全部结束 ---------- */
+void phaPullFromPolyhaven::finishEvicted(const QString& slug, const QString& error)
 {
-    //没有info.json里面没有slug 所以这个有问题哦.
-    QJsonObject oldInfo = loadOldInfo(infoFp);
-    oldInfo.value("files").toObject();
-    if (oldInfo.isEmpty()) {
-        needUpdate = true;
-        return true;
-    }
-    else
+    QSharedPointer<OnDemandFetch> fetch;
     {
-        needUpdate = false;
-        return true;
+        QMutexLocker locker(&m_mutex);
+        fetch = m_onDemand.take(slug);
     }
-    /*
-    QString oldSlug = oldInfo["slug"].toString();
-    needUpdate = (oldSlug != asset.slug) || m_revalidate;
-    return true;
-    */
-}
-
-QJsonObject phaPullFromPolyhaven::loadOldInfo(const QFileInfo& infoFp)
-{
-    QFile file(infoFp.filePath());
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return QJsonObject();
-    QByteArray data = file.readAll();
-    file.close();
-    QJsonParseError parseErr;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &parseErr);
-    return doc.isObject() ? doc.object() : QJsonObject();
+    m_scheduler->unboost(slug);
+    if (fetch && error.isEmpty() && fetch->transferredBytes.load() > 0)
+        Q_EMIT report("INFO", QString("Fetched evicted files of %1 (%2)").arg(slug).arg(format_bytes(fetch->transferredBytes.load())));
+    Q_EMIT assetFetched(slug, error);
 }
-
-
-
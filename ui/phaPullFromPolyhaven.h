@@ -14,33 +14,39 @@
 #include <QtCore/QFileInfo>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
 #include <QtCore/QDir>
 #include <QtCore/QJsonArray>
-#include <QtWidgets/QProgressDialog>
+#include <QtCore/QSet>
+#include <QtCore/QHash>
+#include <QtCore/QSettings>
+#include <QtCore/QSharedPointer>
 
 // 项目相关头文件
 #include "get_asset_list.h"
 #include "download_file.h"
-#include "AssetModel.h"
 #include "get_asset_lib.h"
 #include "constants.h"
+#include "download_scheduler.h"
+#include "sync_plan.h"
+#include "library_cache.h"
+#include "hash_cache.h"
+#include "sync_journal.h"
+#include "metadata_store.h"
+#include "library_presence.h"
 
 #include <atomic>          // ← 新增
 
 
 
 
-// 模拟 PHPlugin 类（进度取消标志）
-class PHPlugin {
-public:
-    static bool PH_PROGRESS_CANCEL;
-};
-
 // 下载任务结果结构体
 struct DownloadResult {
     QString error;         // 错误信息（空表示成功）
     QString slug;          // 成功下载的资产 slug
-    bool exists;           // dry_run 模式下表示资产是否已存在
+    bool exists = false;   // dry_run 模式下表示资产是否已存在
+    DownloadStage stage = DownloadStage::Metadata; // 产生该结果的阶段
+    QVector<SyncFile> files; // Metadata 阶段规划出的待传文件，每个文件一个 Payload 任务
 };
 
 class phaPullFromPolyhaven : public QObject
@@ -52,41 +58,163 @@ public:
     explicit phaPullFromPolyhaven(QObject* parent = nullptr);
     ~phaPullFromPolyhaven() override;
 
+    /** 从 QSettings 读取并发、下载目标、内容仓库、磁盘预算等配置（浏览器和命令行共用） */
+    void loadSettings();
+    /** 同上，配置来源由调用方注入（命令行可指定 ini 文件） */
+    void loadSettings(const QSettings& settings);
+
     void setAssetType(const QString& type);
     void setRevalidate(bool revalidate);
 
+    /**
+     * 只拉取指定的资产（为空表示按资产类型拉取全部）
+     * @param slugs 资产 slug
+     */
+    void setSlugFilter(const QStringList& slugs);
+
+    /**
+     * dry-run：只拉取/读取 /files 清单并规划，不下载缩略图和文件本体
+     * 结束时通过 planReady 给出文件数与总字节
+     */
+    void setDryRun(bool dryRun);
+
+    /**
+     * 设置下载目标（分辨率, 格式）集合；同一资产的清单和缩略图只处理一次，
+     * 文件本体按大小从小到大调度，小分辨率先到
+     * @param targets 目标列表（空列表忽略）
+     */
+    void setTargets(const QVector<DownloadTarget>& targets);
+    QVector<DownloadTarget> targets() const;
+
+    /**
+     * 启用内容寻址仓库（<资产库>/.store）：文件按清单 md5 只存一份，资产目录里是硬链接
+     * @param enabled 是否启用（下次拉取生效）
+     */
+    void setUseContentStore(bool enabled);
+
+    /**
+     * 元数据统一存放在资产库根目录的 .metadata.jsonl；开启后同时导出各资产目录下的 info.json
+     * @param enabled 是否导出（默认否）
+     */
+    void setExportInfoJson(bool enabled);
+
+    /**
+     * 设置资产库磁盘预算：每次拉取结束后按最近访问时间淘汰高分辨率本体
+     * @param bytes 上限字节数（<=0 表示不限制）
+     * @param keepRes 保留分辨率，不高于它的文件不淘汰
+     */
+    void setLibraryBudget(qint64 bytes, const QString& keepRes = "1k");
+
+    /**
+     * 记录资产被使用（拖入场景、导入）；该资产有被淘汰的文件时在后台按需拉回
+     * @param slug 资产 slug
+     */
+    void recordAssetUse(const QString& slug);
+
+    /**
+     * 设置某个下载阶段的并发上限（元数据 / 缩略图 / 本体各自独立排队）
+     * @param stage 阶段
+     * @param limit 同时进行的任务数（至少 1）
+     */
+    void setStageLimit(DownloadStage stage, int limit);
+
+    /**
+     * 设置下载总并发的上下界（实际并发按吞吐与失败率在其间自适应）
+     * @param floor 下界
+     * @param ceiling 上界
+     */
+    void setConcurrencyBounds(int floor, int ceiling);
+
+    /**
+     * 把资产排队中的下载任务提到最前（浏览器里选中或拖动时调用）
+     * @param slug 资产 slug
+     */
+    void boostAsset(const QString& slug);
+
     void executeAsync();
 
+    /**
+     * 校验本地文件：按 setAssetType 的类型，多线程计算所有本体的 md5 并与清单比对
+     * 大小 / mtime / inode 未变的文件直接用哈希缓存；不符的文件记入缓存，下次同步时重新下载
+     * 结束时发出 verifyFinished
+     */
+    void verifyAsync();
+
+    /**
+     * 上次中断（崩溃、关闭 Houdini、取消）的同步留下的未完成文件，来自资产库的任务日志
+     * @return 未完成的文件；没有时为空
+     */
+    QVector<SyncFile> interruptedFiles();
+
+    /**
+     * 资产库在库表：由 LibraryWatcher 扫描和维护，规划、缩略图阶段和浏览器都查它而不逐个 stat
+     * 本对象下载完成的文件会立即登记
+     */
+    LibraryPresence* presence() { return &m_presence; }
+
+    /**
+     * 续传：跳过列表和清单，直接下载日志中未完成的文件，已写入 .part 的部分用 Range 请求接着下
+     * 结束时与 executeAsync 一样发出 executeFinished
+     */
+    void resumeAsync();
+
 Q_SIGNALS:
     void progressUpdated(int current, int total, const QString& text);
     void report(const QString& type, const QString& content);
     void finished(int downloadedCount, int failedCount);
     void executeFinished(int resultCode);
+    void catalogueUpdated();                  // 网络资产列表已写入缓存
+    void previewReady(const QString& slug);   // 某资产的缩略图已落盘
+    // 字节进度（每秒一次）：已传 / 计划总量 / 平滑后的吞吐（字节每秒）/ 预计剩余秒数（-1 表示未知）
+    void byteProgressUpdated(qint64 doneBytes, qint64 totalBytes, double bytesPerSecond, qint64 etaSeconds);
+    // dry-run 结束：待传文件数、总字节、报告文字
+    void planReady(int fileCount, qint64 totalBytes, const QString& summary);
+    // 按需拉回被淘汰的文件结束（error 为空表示成功）
+    void assetFetched(const QString& slug, const QString& error);
+    // 校验结束：校验文件数、实际读取的文件数（其余命中缓存）、内容不符的文件
+    void verifyFinished(int checkedCount, int hashedCount, const QStringList& mismatches);
 
 public Q_SLOTS:
     void cancelDownload();
 
 private Q_SLOTS:
     void doExecuteAsync();
+    void doResumeAsync();
     void handleTaskFinished(const DownloadResult& res);   // ← 新增
     void allTasksFinished();                              // ← 新增
+    void sampleThroughput();
+    void scheduleCacheFlush();                            // 重启访问记录的延迟写盘定时器
 
 private:
-    DownloadResult updateAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath, bool dryRun);
-    QString downloadAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath, const QFileInfo& infoFp);
-    bool checkAssetExists(const QMap<QString, QJsonObject>& asset, const QFileInfo& infoFp, bool& needUpdate);
-    QJsonObject loadOldInfo(const QFileInfo& infoFp);
-    void processAssets(const QMap<QString, QJsonObject>& assets, const QDir& libDirPath);
+    struct AssetProgress;
+    struct OnDemandFetch;
+
+    bool beginRun();
+    DownloadResult updateAsset(const QMap<QString, QJsonObject>& asset, const QDir& libDirPath);
+    QString fetchAssetInfo(const QMap<QString, QJsonObject>& asset, QJsonObject& infoJson, bool refetch);
+    QString downloadThumbnail(const QString& slug, const QDir& assetDir);
+    QString downloadPlannedFile(const SyncFile& file, OnDemandFetch* onDemand = nullptr);
+    void fetchEvicted(const QString& slug);
+    void finishEvicted(const QString& slug, const QString& error);
+    void verifyLibrary(const QString& assetType);
+    void enqueueStage(const QMap<QString, QJsonObject>& asset, DownloadStage stage, const SyncFile& file = SyncFile());
+    void dispatchPayloads(AssetProgress& progress, const QVector<SyncFile>& files);
+    void finishAsset(const QString& slug);
+    void releaseUrlWaiters(const SyncFile& file, bool succeeded);
+    void processAssets(const QMap<QString, QJsonObject>& assets, const QDir& libDirPath, bool fromCache = false);
+    void flushDeferredMetadata();
+    void fetchListing(const QString& assetType);
+    void onListingFinished(const QMap<QString, QJsonObject>& fresh, const QString& error);
 
 
 
     QString m_assetType = "all";
     bool m_revalidate = false;
     QThread* m_workerThread = nullptr;
-    QMutex m_mutex;
+    mutable QMutex m_mutex;
     QWaitCondition m_waitCond;
 
-    std::atomic<bool> m_isCancelled{ false };              // ← 原子化
+    std::atomic<bool> m_isCancelled{ false };              // 取消标记只属于本实例：浏览器和 cmd_polyhaven 的拉取互不干扰
     std::atomic<int> m_remaining{ 0 };                     // ← 替代 waitForDone
     int m_totalToFetch = 0;
     std::atomic<int> m_currentProgress{ 0 };
@@ -94,12 +222,63 @@ private:
     std::atomic<int> m_failedCount{ 0 };
     QString m_currentProgressText;
 
-    QMap<QString, QJsonObject> m_asyncAssets;
+    QSet<QString> m_dispatched;                            // 本次拉取已派发的 slug（仅工作线程访问）
+    QSet<QString> m_deferredMetadata;                      // 按缓存列表派发、元数据阶段等网络列表的 slug（仅工作线程访问）
+
+    // 单个资产在各阶段间的进度（仅工作线程访问）
+    struct AssetProgress {
+        QMap<QString, QJsonObject> asset;
+        int pendingStages = 0;   // 已入队但未完成的阶段数，归零即该资产结束
+        bool exists = false;
+        QStringList errors;
+    };
+    QHash<QString, AssetProgress> m_assetProgress;
+
+    // 按需拉回一个资产被淘汰的文件：与同步共用调度器的 Payload 名额，
+    // 但取消标记和字节进度各自独立，同步的取消不波及，也不计入同步的 ETA
+    struct OnDemandFetch {
+        ContentStore store;
+        std::atomic<bool> cancelled{ false };
+        std::atomic<qint64> plannedBytes{ 0 };
+        std::atomic<qint64> transferredBytes{ 0 };
+        std::atomic<int> remaining{ 0 };       // 尚未结束的文件数，归零即该资产拉回结束
+        QMutex mutex;
+        QStringList errors;                     // mutex 保护
+    };
+
+    // 跨资产去重（按 URL，仅工作线程访问）：同一文件只下载一次，其他资产等它完成后本地复制
+    QSet<QString> m_urlInFlight;
+    QHash<QString, QString> m_urlCompleted;                // url -> 已下好的本地路径
+    QHash<QString, QVector<SyncFile>> m_urlWaiters;
+
+    // 规划与字节进度
+    bool m_dryRun = false;
+    SyncPlan m_plan;                                       // 仅工作线程访问
+    std::atomic<qint64> m_plannedBytes{ 0 };
+    std::atomic<qint64> m_transferredBytes{ 0 };           // 下载线程在 curl 回调里累加
+    QTimer* m_throughputTimer = nullptr;
+    QTimer* m_cacheFlushTimer = nullptr;                   // 访问记录延迟写盘（单次，工作线程）
+    QElapsedTimer m_throughputClock;
+    qint64 m_lastSampleBytes = 0;
+    double m_smoothedRate = 0.0;                           // 指数平滑后的字节/秒
+    DownloadScheduler* m_scheduler = nullptr;
     QDir m_asyncLibDir;
     int m_asyncResultCode = 0;
-public:
-    QString m_res = "1k";
-    QString m_format = "hdr";
+    // 下载目标矩阵：每个资产一次规划出所有目标的文件；m_runTargets 是本次拉取开始时的快照
+    QVector<DownloadTarget> m_targets{ { "1k", "hdr", 0 }, { "1k", "jpg", 1 }, { "1k", "gltf", 2 } };
+    QVector<DownloadTarget> m_runTargets;
+    QStringList m_slugFilter;                              // 只拉取这些资产（m_mutex 保护）
+    QSet<QString> m_runSlugs;                              // 本次拉取开始时的快照
+
+    bool m_useContentStore = false;
+    ContentStore m_store;                                  // 本次拉取使用的仓库（未启用时 isValid() 为 false）
+
+    LibraryCache m_cache;                                  // 访问记录 + 磁盘预算（自身线程安全）
+    QHash<QString, QSharedPointer<OnDemandFetch>> m_onDemand; // 正在按需拉回的资产（m_mutex 保护）
+    HashCache m_hashes;                                    // （路径, 大小, mtime, inode）-> md5（自身线程安全）
+    LibraryPresence m_presence;                            // 磁盘上实际有哪些文件（自身线程安全）
+    MetadataStore m_metadata;                              // 全部资产的列表条目 + 清单，内存索引（自身线程安全）
+    SyncJournal m_journal;                                 // 本体下载的任务日志，用于中断后续传（自身线程安全）
 };
 
 
@@ -9,8 +9,16 @@
 #include <QtWidgets/qscrollbar.h>
 #include <QtCore/qrect.h>
 #include <QtCore/QStringList>
+#include <QtCore/qthreadpool.h>
+#include <memory>
 
 #include "download_file.h"
+#include "phaPullFromPolyhaven.h"
+#include "trace.h"
+#include "metrics.h"
+
+// 补全列表中存放纯文本词的角色（DisplayRole 带资产数，不能直接写回输入框）
+static const int COMPLETION_TERM_ROLE = Qt::UserRole + 1;
 
 // 静态成员初始化
 QString StartWindow::s_lastPath = "";
@@ -27,6 +35,7 @@ StartWindow::StartWindow(QWidget* parent)
     m_thumbCache.setMaxCost(300);
     m_assetDelegate = new AssetDelegate(this);
     m_assetDelegate->setThumbCache(&m_thumbCache); // 传递缓存给委托
+    connect(m_assetDelegate, &AssetDelegate::assetDragged, this, &StartWindow::onAssetDragged);
 
     QVBoxLayout* mainLayout = new QVBoxLayout;
     mainLayout->addWidget(ui->horizontalLayoutWidget);
@@ -35,17 +44,39 @@ StartWindow::StartWindow(QWidget* parent)
     m_statusBar = new QStatusBar();
     mainLayout->addWidget(m_statusBar);
 
+    // 统计面板：吞吐、延迟分布、缓存命中率
+    QPushButton* metricsBtn = new QPushButton(u8"统计", this);
+    metricsBtn->setFlat(true);
+    m_statusBar->addPermanentWidget(metricsBtn);
+    connect(metricsBtn, &QPushButton::clicked, this, [=]() {
+        if (!m_metricsPanel)
+            m_metricsPanel = new MetricsPanel(this);
+        m_metricsPanel->show();
+        m_metricsPanel->raise();
+        });
+
     s_lastPath = loadPathFromConfig();
+    set_asset_lib_path(s_lastPath);
     ui->m_pathLabel->setText(s_lastPath);
 
     ui->controlLayout->addStretch();
     ui->propertyLayout->addStretch();
 
     m_polyhavenWorker = new phaPullFromPolyhaven(this);
+    // 并发、下载目标、内容仓库、磁盘预算等配置与命令行子命令共用
+    m_polyhavenWorker->loadSettings();
     m_assetModel = nullptr;
     m_categoriesModel = nullptr;
     m_tagModel = new QStandardItemModel(this);
 
+    // 搜索补全：候选由 TagTrie 给出，QCompleter 只负责弹出和回填
+    m_completionModel = new QStandardItemModel(this);
+    m_completer = new QCompleter(m_completionModel, this);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_completer->setCompletionRole(COMPLETION_TERM_ROLE);
+    m_completer->setMaxVisibleItems(TagTrie::TOP_K);
+    ui->m_searchInput->setCompleter(m_completer);
+
     // 初始化 ListView 基础优化（提前配置，避免重复设置）
     if (ui->m_assetListView) {
         ui->m_assetListView->setViewMode(QListView::IconMode);
@@ -66,7 +97,44 @@ StartWindow::StartWindow(QWidget* parent)
     }
     connect(m_polyhavenWorker, &phaPullFromPolyhaven::progressUpdated,
         this, &StartWindow::onProgressUpdated);
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::byteProgressUpdated,
+        this, &StartWindow::onByteProgressUpdated);
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::planReady, this,
+        [=](int, qint64, const QString& summary) { m_lastPlanSummary = summary; });
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::verifyFinished,
+        this, &StartWindow::onVerifyFinished);
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::assetFetched, this, [=](const QString& slug, const QString& error) {
+        if (error.isEmpty())
+            m_statusBar->showMessage(QString(u8"已重新下载 %1 被淘汰的文件").arg(slug), 5000);
+        else
+            m_statusBar->showMessage(QString(u8"重新下载 %1 失败：%2").arg(slug).arg(error), 10000);
+        });
+
+    // 拉取时元数据/缩略图先于大文件完成：列表一更新就重建浏览器，缩略图到一张刷一次可见区域
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::catalogueUpdated, this, [=]() {
+        m_assetsData.clear();
+        loadAssets(false);
+        });
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::previewReady, this, &StartWindow::schedulePreviewRefresh);
 
+    // 在库表：首次显示时后台扫描资产库，之后按目录变化增量更新，缩略图有增删就刷新可见区域
+    m_libraryWatcher = new LibraryWatcher(m_polyhavenWorker->presence(), this);
+    connect(m_libraryWatcher, &LibraryWatcher::scanFinished, this, &StartWindow::schedulePreviewRefresh);
+    connect(m_libraryWatcher, &LibraryWatcher::presenceChanged, this, &StartWindow::schedulePreviewRefresh);
+
+}
+
+void StartWindow::schedulePreviewRefresh()
+{
+    if (m_previewRefreshPending)
+        return;
+    m_previewRefreshPending = true;
+    QTimer::singleShot(200, this, [=]() {
+        m_previewRefreshPending = false;
+        loadVisibleAreaThumbs();
+        if (ui->m_assetListView)
+            ui->m_assetListView->viewport()->update();
+        });
 }
 
 StartWindow* StartWindow::getInstance()
@@ -155,10 +223,12 @@ void StartWindow::showEvent(QShowEvent* event)
     QWidget::showEvent(event);
     if (m_firstShow) {
         m_firstShow = false;
-        loadAssets(false);
+        // 分类树来自编译期节点表，可立即显示；资产索引在后台构建，完成后分批灌入模型
         loadTreeModel();
-        // 窗口显示后，延迟加载第一屏图片（确保布局完成）
-        QTimer::singleShot(50, this, &StartWindow::loadVisibleAreaThumbs);
+        loadAssets(false);
+        m_libraryWatcher->start(get_asset_lib_path());
+        // 窗口画出来之后再询问，避免对话框挡住首帧
+        QTimer::singleShot(0, this, &StartWindow::offerResume);
     }
     else {
         // 非首次显示（如窗口切换回来），加载当前可见区域
@@ -170,6 +240,7 @@ void StartWindow::importLight()
 {
     PY_InterpreterAutoLock py_lock;
     QString exrPath = this->m_exrPath;
+    m_polyhavenWorker->recordAssetUse(QFileInfo(exrPath).dir().dirName());
 
     QString pythonScript = QStringLiteral(R"(
 import toolutils
@@ -215,28 +286,62 @@ void StartWindow::onProgressUpdated(int current, int total, const QString& text)
     }
 }
 
-void StartWindow::showConfirmation(const QString& text)
+void StartWindow::onByteProgressUpdated(qint64 doneBytes, qint64 totalBytes, double bytesPerSecond, qint64 etaSeconds)
 {
-    if (text != "hdris") {
-        QMessageBox::information(this, u8"取消", QString(u8"Polyhaven 拉取操作已取消,只支持hdris！（类型：%1）").arg(text));
+    if (totalBytes <= 0) {
+        ui->m_progressBar->setFormat("%p%");
         return;
     }
+    ui->m_progressBar->setFormat(QString("%p%  %1 / %2  %3/s  ETA %4")
+        .arg(format_bytes(doneBytes))
+        .arg(format_bytes(totalBytes))
+        .arg(format_bytes(qint64(bytesPerSecond)))
+        .arg(format_duration(etaSeconds)));
+}
 
-    QMessageBox::StandardButton reply = QMessageBox::question(
-        this,
-        u8"操作确认",
-        QString(u8"确认下载 %1 ？").arg(text),
-        QMessageBox::Yes | QMessageBox::No,
-        QMessageBox::No
-    );
-
-    if (reply == QMessageBox::Yes) {
+void StartWindow::showConfirmation(const QString& text)
+{
+    QMessageBox box(QMessageBox::Question, u8"操作确认", QString(u8"确认下载 %1 ？").arg(text),
+        QMessageBox::Yes | QMessageBox::No, this);
+    box.setDefaultButton(QMessageBox::No);
+    // 只拉清单、算出要传的文件和字节数，不下载
+    QPushButton* planBtn = box.addButton(u8"仅预估", QMessageBox::ActionRole);
+    // 不下载，只核对本地文件的 md5
+    QPushButton* verifyBtn = box.addButton(u8"校验本地文件", QMessageBox::ActionRole);
+    box.exec();
+
+    m_dryRunRequested = box.clickedButton() == planBtn;
+    if (box.clickedButton() == verifyBtn) {
+        ui->fetchComboBtn->setEnabled(false);
+        ui->m_cancelBtn->setEnabled(true);
+        m_polyhavenWorker->setAssetType(text);
+        m_polyhavenWorker->verifyAsync();
+    }
+    else if (box.clickedButton() == box.button(QMessageBox::Yes) || m_dryRunRequested) {
         ui->fetchComboBtn->setEnabled(false);
         ui->m_cancelBtn->setEnabled(true);
         onTextChanged(text);
     }
 }
 
+void StartWindow::onVerifyFinished(int checkedCount, int hashedCount, const QStringList& mismatches)
+{
+    ui->fetchComboBtn->setEnabled(true);
+    ui->m_cancelBtn->setEnabled(false);
+
+    QString text = QString(u8"已校验 %1 个文件（读取 %2 个，其余命中哈希缓存），%3 个与清单不符。")
+        .arg(checkedCount).arg(hashedCount).arg(mismatches.size());
+    if (!mismatches.isEmpty()) {
+        // 列表太长时只列前几个，其余看日志
+        static const int MAX_LISTED = 10;
+        text += u8"\n\n" + mismatches.mid(0, MAX_LISTED).join("\n");
+        if (mismatches.size() > MAX_LISTED)
+            text += QString(u8"\n……（另有 %1 个）").arg(mismatches.size() - MAX_LISTED);
+        text += u8"\n\n下次拉取时会重新下载这些文件。";
+    }
+    QMessageBox::information(this, u8"校验", text);
+}
+
 
 //TODO
 /*
@@ -267,46 +372,83 @@ void StartWindow::onTextChanged(const QString& text)
     disconnect(m_polyhavenWorker, &phaPullFromPolyhaven::executeFinished, this, nullptr);
 
     m_polyhavenWorker->setAssetType(text);
-    m_polyhavenWorker->setRevalidate(true);//TODO
+    // 清单是否过期按列表里的 files_hash 判断，不再每次同步都重新请求 /files
+    m_polyhavenWorker->setRevalidate(false);
+    m_polyhavenWorker->setDryRun(m_dryRunRequested);
+    m_lastPlanSummary.clear();
 
     connect(m_polyhavenWorker, &phaPullFromPolyhaven::executeFinished, this, [=](int resultCode) {
-        switch (resultCode) {
-        case 0:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::information(this, u8"成功", QString(u8"Polyhaven 拉取操作执行完成！（类型：%1）").arg(text));
-            break;
-        case 1:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::information(this, u8"取消", QString(u8"Polyhaven 拉取操作已取消！（类型：%1）").arg(text));
-            break;
-        case -1:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::critical(this, u8"失败", QString(u8"未找到资产库，请先在创建 \"Poly Haven\" 文件夹！（类型：%1）").arg(text));
-            break;
-        case -2:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::critical(this, u8"失败", QString(u8"资产库路径不存在，请检查路径有效性！（类型：%1）").arg(text));
-            break;
-        case -3:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::critical(this, u8"失败", QString(u8"获取资产列表失败！（类型：%1）").arg(text));
-            break;
-        default:
-            ui->fetchComboBtn->setEnabled(true);
-            ui->m_cancelBtn->setEnabled(false);
-            QMessageBox::critical(this, u8"失败", QString(u8"Polyhaven 拉取操作执行失败！（错误码：%1，类型：%2）").arg(resultCode).arg(text));
-            break;
-        }
+        onExecuteFinished(resultCode, text);
         });
 
     m_polyhavenWorker->executeAsync();
 }
 
+void StartWindow::onExecuteFinished(int resultCode, const QString& text)
+{
+    switch (resultCode) {
+    case 0:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        if (m_dryRunRequested)
+            QMessageBox::information(this, u8"预估", QString(u8"%1（类型：%2）").arg(m_lastPlanSummary).arg(text));
+        else
+            QMessageBox::information(this, u8"成功", QString(u8"Polyhaven 拉取操作执行完成！（类型：%1）").arg(text));
+        break;
+    case 1:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        QMessageBox::information(this, u8"取消", QString(u8"Polyhaven 拉取操作已取消！（类型：%1）").arg(text));
+        break;
+    case -1:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        QMessageBox::critical(this, u8"失败", QString(u8"未找到资产库，请先在创建 \"Poly Haven\" 文件夹！（类型：%1）").arg(text));
+        break;
+    case -2:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        QMessageBox::critical(this, u8"失败", QString(u8"资产库路径不存在，请检查路径有效性！（类型：%1）").arg(text));
+        break;
+    case -3:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        QMessageBox::critical(this, u8"失败", QString(u8"获取资产列表失败！（类型：%1）").arg(text));
+        break;
+    default:
+        ui->fetchComboBtn->setEnabled(true);
+        ui->m_cancelBtn->setEnabled(false);
+        QMessageBox::critical(this, u8"失败", QString(u8"Polyhaven 拉取操作执行失败！（错误码：%1，类型：%2）").arg(resultCode).arg(text));
+        break;
+    }
+}
+
+void StartWindow::offerResume()
+{
+    if (!m_polyhavenWorker)
+        return;
+    const QVector<SyncFile> pending = m_polyhavenWorker->interruptedFiles();
+    if (pending.isEmpty())
+        return;
+
+    qint64 bytes = 0;
+    for (const SyncFile& file : pending)
+        bytes += file.size;
+    const QString text = QString(u8"上次拉取未完成：还有 %1 个文件（%2）。是否继续下载？")
+        .arg(pending.size()).arg(format_bytes(bytes));
+    if (QMessageBox::question(this, u8"继续拉取", text) != QMessageBox::Yes)
+        return;
+
+    ui->fetchComboBtn->setEnabled(false);
+    ui->m_cancelBtn->setEnabled(true);
+    m_dryRunRequested = false;
+    disconnect(m_polyhavenWorker, &phaPullFromPolyhaven::executeFinished, this, nullptr);
+    connect(m_polyhavenWorker, &phaPullFromPolyhaven::executeFinished, this, [=](int resultCode) {
+        onExecuteFinished(resultCode, u8"续传");
+        });
+    m_polyhavenWorker->resumeAsync();
+}
+
 void StartWindow::canceldownload()
 {
     m_polyhavenWorker->cancelDownload();
@@ -319,76 +461,127 @@ void StartWindow::savePathToConfig(const QString& path)
     QSettings settings(ORG_NAME, APP_NAME);
     settings.setValue(PATH_KEY, path);
     s_lastPath = path;
+    set_asset_lib_path(path);
 }
 
 QString StartWindow::loadPathFromConfig()
 {
     QSettings settings(ORG_NAME, APP_NAME);
-    return settings.value(PATH_KEY).toString();
+    return load_asset_lib_path(settings);
 }
 
+// 后台加载阶段的产物：在线程池中构建，完成后整体移交 GUI 线程
+struct AsyncLibraryLoad {
+    QMap<QString, QJsonObject> assets;
+    AssetIndex index;
+    TagTrie trie;
+};
+
 void StartWindow::loadAssets(bool filtered)
 {
-    /* 1. 清空旧模型 */
+    /* 1. 清空旧模型，先挂一个空模型，窗口立即可绘制（首帧与资产数量无关） */
     if (m_assetModel) {
         m_assetModel->deleteLater();
         m_assetModel = nullptr;
     }
+    if (!ui->m_assetListView)
+        return;
 
-    /* 2. 若无数据，重新加载 */
-    if (m_assetsData.isEmpty()) {
-        m_assetsData = get_asset_lib();
+    m_assetModel = new AssetModel(QMap<QString, QJsonObject>(), this);
+    m_assetModel->setPresence(m_polyhavenWorker->presence());
+    ui->m_assetListView->setModel(m_assetModel);
+    ui->m_assetListView->setItemDelegate(m_assetDelegate);
+
+    /* 2. 已有数据：直接出结果 */
+    if (!m_assetsData.isEmpty()) {
+        onLibraryReady(filtered);
+        return;
     }
 
-    /* 3. 数据有效性检查 */
-    if (m_assetsData.isEmpty() || !ui->m_assetListView) {
+    /* 3. 读缓存 + 建索引 + 建补全树放到线程池，GUI 线程不做任何 JSON 解析 */
+    m_statusBar->showMessage(u8"正在加载资产库...");
+    const int generation = ++m_loadGeneration;
+    auto load = std::make_shared<AsyncLibraryLoad>();
+
+    QThreadPool::globalInstance()->start([this, load, generation, filtered]() {
+        load->assets = get_asset_lib();
+        load->index.build(load->assets);
+        load->trie.build(load->index.termCounts());
+
+        QMetaObject::invokeMethod(this, [this, load, generation, filtered]() {
+            // 期间又触发了新的加载，丢弃旧结果
+            if (generation != m_loadGeneration)
+                return;
+            m_assetsData = std::move(load->assets);
+            m_assetIndex = std::move(load->index);
+            m_tagTrie = std::move(load->trie);
+            m_textBitsQuery.clear();
+            m_textBits = m_assetIndex.allBits();
+            onLibraryReady(filtered);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void StartWindow::onLibraryReady(bool filtered)
+{
+    /* 数据有效性检查 */
+    if (m_assetsData.isEmpty()) {
         m_statusBar->showMessage(u8"未找到有效资产数据");
         return;
     }
 
-    /* 4. 创建并绑定新模型 */
-    if (!filtered) {
-        m_assetModel = new AssetModel(m_assetsData, this);
-        ui->m_assetListView->setModel(m_assetModel);
-        ui->m_assetListView->setItemDelegate(m_assetDelegate);
-        m_statusBar->showMessage(
-            QString(u8"加载完成：共%1个资产").arg(m_assetsData.size()));
-    }
-    else {
-        // 筛选场景的模型设置（原有逻辑保留）
-        QMap<QString, QJsonObject> filteredAssets = filterAssets();
-        m_assetModel = new AssetModel(filteredAssets, this);
-        ui->m_assetListView->setModel(m_assetModel);
-        m_statusBar->showMessage(
-            QString(u8"筛选完成：共%1个资产").arg(filteredAssets.size()));
+    updateFacetCounts();
+
+    // 加载期间用户已经输入搜索词或点了分类：直接按条件筛选
+    if (filtered || !m_searchText.isEmpty() || m_currentNode >= 0) {
+        refreshTextBits();
+        updateFacetCounts();
+        applyFilter();
+        return;
     }
 
-    // 资产加载完成后，触发一次可见区域加载
-    QTimer::singleShot(20, this, &StartWindow::loadVisibleAreaThumbs);
+    /* 全量结果分批插入，每批之间回到事件循环，首屏先出 */
+    m_streamRows = m_assetIndex.sortedRows(m_assetIndex.allBits(), m_sortField, m_sortDescending);
+    m_streamPos = 0;
+    m_streamModel = m_assetModel;
+    streamNextChunk();
 }
 
-void StartWindow::onCategoryClicked(const QModelIndex& index)
+void StartWindow::streamNextChunk()
 {
-    if (!index.isValid()) return;
+    // 模型已被筛选/重新加载替换，停止灌入
+    if (!m_streamModel || m_streamModel != m_assetModel) {
+        m_streamRows.clear();
+        m_streamModel = nullptr;
+        return;
+    }
 
-    QString fullPath = index.data(CATALOG_PATH_ROLE).toString();
+    const int end = qMin(m_streamPos + STREAM_CHUNK_SIZE, int(m_streamRows.size()));
+    m_streamModel->appendRows(m_assetIndex, m_streamRows.mid(m_streamPos, end - m_streamPos));
+    const bool firstChunk = m_streamPos == 0;
+    m_streamPos = end;
 
-    if (fullPath.contains("HDRIs"))
-        m_currentCategory = 0;
-    else if (fullPath.contains("Textures"))
-        m_currentCategory = 1;
-    else if (fullPath.contains("Models"))
-        m_currentCategory = 2;
-    else
-        m_currentCategory = 3;
+    if (firstChunk)
+        QTimer::singleShot(20, this, &StartWindow::loadVisibleAreaThumbs);
 
-    QStringList fullList = fullPath.split('/');
-    QStringList categoryList;
-    for (const QString& item : fullList) {
-        if (item != "ALL" && item != "HDRIs" && item != "Models" && item != "Textures")
-            categoryList.append(item.toLower());
+    if (m_streamPos < m_streamRows.size()) {
+        m_statusBar->showMessage(QString(u8"正在加载：%1/%2").arg(m_streamPos).arg(m_streamRows.size()));
+        QTimer::singleShot(0, this, &StartWindow::streamNextChunk);
+    }
+    else {
+        m_statusBar->showMessage(QString(u8"加载完成：共%1个资产").arg(m_streamRows.size()));
+        m_streamRows.clear();
+        m_streamModel = nullptr;
     }
-    m_categoryList = categoryList;
+}
+
+void StartWindow::onCategoryClicked(const QModelIndex& index)
+{
+    if (!index.isValid()) return;
+
+    // 节点 id 在 buildTreeModel 时写入，筛选条件已预计算在 AssetIndex 的位图中
+    QVariant node = index.data(CATALOG_NODE_ROLE);
+    m_currentNode = node.isValid() ? node.toInt() : -1;
 
     applyFilter();
 }
@@ -396,11 +589,70 @@ void StartWindow::onCategoryClicked(const QModelIndex& index)
 void StartWindow::updateText(const QString& text)
 {
     m_searchText = text.toLower().trimmed();
+    updateCompletions();
+    refreshTextBits();
+    updateFacetCounts();
     applyFilter();
 }
 
+void StartWindow::updateCompletions()
+{
+    m_completionModel->clear();
+    if (m_searchText.isEmpty())
+        return;
+
+    // O(前缀长度 + k)，每次按键都查
+    const QVector<QPair<QString, int>> hits = m_tagTrie.complete(m_searchText, TagTrie::TOP_K);
+    for (const auto& hit : hits) {
+        if (hit.first == m_searchText)
+            continue;  // 已经输入完整，无需再提示
+        auto* item = new QStandardItem(QString("%1  (%2)").arg(hit.first).arg(hit.second));
+        item->setData(hit.first, COMPLETION_TERM_ROLE);
+        item->setEditable(false);
+        m_completionModel->appendRow(item);
+    }
+}
+
+void StartWindow::refreshTextBits()
+{
+    // 新搜索词包含旧搜索词时（继续输入），结果必然是旧结果的子集，只需复查旧结果
+    bool canRefine = m_textBits.size() == m_assetIndex.size()
+        && m_searchText.contains(m_textBitsQuery);
+    m_textBits = m_assetIndex.matchText(m_searchText, canRefine ? m_textBits : QBitArray());
+    m_textBitsQuery = m_searchText;
+}
+
+void StartWindow::updateFacetCounts()
+{
+    // 索引尚在后台构建时保持节点原名
+    if (m_categoryItems.isEmpty() || m_assetIndex.size() == 0)
+        return;
+
+    if (m_textBits.size() != m_assetIndex.size())
+        refreshTextBits();
+
+    // 每个节点一次 AND + popcount，逐键刷新也足够便宜
+    QVector<int> counts = m_assetIndex.facetCounts(m_textBits);
+    for (int node = 0; node < m_categoryItems.size() && node < counts.size(); ++node) {
+        QStandardItem* item = m_categoryItems[node];
+        if (!item) continue;
+        const std::string_view& name = CATEGORY_NODES[node].name;
+        item->setText(QString("%1 (%2)").arg(QLatin1String(name.data(), int(name.size()))).arg(counts[node]));
+    }
+}
+
+void StartWindow::onAssetDragged(const QString& assetId)
+{
+    m_polyhavenWorker->boostAsset(assetId);
+    // 拖入场景算一次使用；被淘汰的高分辨率文件在后台拉回
+    m_polyhavenWorker->recordAssetUse(assetId);
+}
+
 void StartWindow::onAssetPreview(const QVariantMap& asset)
 {
+    // 选中即提权：正在同步时该资产的排队任务插到最前
+    m_polyhavenWorker->boostAsset(asset.value("asset_id").toString());
+
     m_tagModel->clear();
     QStringList items;
 
@@ -472,216 +724,91 @@ void StartWindow::onAssetPreview(const QVariantMap& asset)
         : asset["authors"].toString());
 }
 
-QMap<QString, QJsonObject> StartWindow::filterAssets() const
+QVector<int> StartWindow::filterAssets() const
 {
-    QString text = m_searchText.toLower().trimmed();
-    QStringList fList = m_categoryList;
-
-    QMap<QString, QJsonObject> filtered;
-
-    if (m_assetsData.isEmpty())
-        return filtered;
-
-    auto it = m_assetsData.constBegin();
-    while (it != m_assetsData.constEnd()) {
-        const QJsonObject& asset = it.value();
-
-        /* 1. 分类匹配（0/1/2/3）*/
-        int assetType = asset.value("type").toInt();
-        bool categoryMatch = (m_currentCategory == 3) || (assetType == m_currentCategory);
-
-        /* 2. 空条件快速分支 */
-        if (fList.isEmpty() && text.isEmpty()) {
-            if (categoryMatch)
-                filtered.insert(it.key(), asset);
-            ++it;
-            continue;
-        }
-
-        /* 3. 文本+分类联合过滤 */
-        //QString assetName = asset.name.toLower();
-        QString assetName = asset.value("name").toString().toLower();
-
-        /* 统一把 tags & categories 合并到 QStringList */
-        QStringList assetTags;
-        // 1. 处理 tags 数组：转为 QStringList 并添加到 assetTags
-        QJsonValue tagsValue = asset.value("tags");
-        if (tagsValue.isArray()) {
-            QVariantList tagsVariant = tagsValue.toArray().toVariantList();
-            Q_FOREACH(const QVariant & var, tagsVariant) { // 遍历每个 QVariant
-                assetTags.append(var.toString()); // 显式转为 QString
-            }
-        }
-
-
-        // 2. 处理 categories 数组：转为 QStringList 并添加到 assetTags
-        QJsonValue categoriesValue = asset.value("categories");
-        if (categoriesValue.isArray()) {
-            QVariantList catsVariant = categoriesValue.toArray().toVariantList();
-            Q_FOREACH(const QVariant & var, catsVariant) {
-                assetTags.append(var.toString());
-            }
-        }
-
-        /* 文本匹配：name 或 任一 tag */
-        bool textMatch = assetName.contains(text) ||
-            std::any_of(assetTags.constBegin(), assetTags.constEnd(),
-                [&](const QString& t) { return t.contains(text); });
-
-        /* f_list 全部包含（不区分大小写）*/
-        bool allIn = true;
-        for (const QString& item : fList) {
-            bool found = std::any_of(assetTags.constBegin(), assetTags.constEnd(),
-                [&](const QString& t) { return t.contains(item.toLower()); });
-            if (!found) {
-                allIn = false;
-                break;
-            }
-        }
-
-        if (allIn && categoryMatch && textMatch)
-            filtered.insert(it.key(), asset);
+    if (m_assetIndex.size() == 0)
+        return QVector<int>();
+    TraceSpan span("filterAssets", "ui", m_searchText);
+    static MetricHistogram* const filterTime = metrics_histogram("ui.filter_us");
+    MetricTimer timer(filterTime);
+
+    /* 分类位图 & 文本位图 */
+    QBitArray textBits = m_textBits.size() == m_assetIndex.size()
+        ? m_textBits
+        : m_assetIndex.matchText(m_searchText);
+    QBitArray bits = m_assetIndex.nodeBits(m_currentNode) & textBits;
+
+    /* 按预计算的排序置换输出 */
+    QVector<int> rows = m_assetIndex.sortedRows(bits, m_sortField, m_sortDescending);
+    span.setBytes(rows.size());
+    return rows;
+}
 
-        ++it;
+void StartWindow::onSortChanged(int index)
+{
+    // 0:默认(slug) 1:名称 2:下载量 3:发布日期；数值类字段默认从大到小
+    switch (index) {
+    case 1:
+        m_sortField = AssetIndex::SortByName;
+        m_sortDescending = false;
+        break;
+    case 2:
+        m_sortField = AssetIndex::SortByDownloads;
+        m_sortDescending = true;
+        break;
+    case 3:
+        m_sortField = AssetIndex::SortByDatePublished;
+        m_sortDescending = true;
+        break;
+    default:
+        m_sortField = AssetIndex::SortByKey;
+        m_sortDescending = false;
+        break;
     }
-
-    return filtered;
+    applyFilter();
 }
 
 void StartWindow::applyFilter()
 {
-    QMap<QString, QJsonObject> filtered = filterAssets();
+    QVector<int> rows = filterAssets();
 
     if (m_assetModel) {
         m_assetModel->deleteLater();
         m_assetModel = nullptr;
     }
 
-    m_assetModel = new AssetModel(filtered, this);
+    m_assetModel = new AssetModel(m_assetIndex, rows, this);
+    m_assetModel->setPresence(m_polyhavenWorker->presence());
     ui->m_assetListView->setModel(m_assetModel);
     ui->m_assetListView->setItemDelegate(m_assetDelegate);
 
-    m_statusBar->showMessage(QString(u8"筛选结果：共%1个资产").arg(filtered.size()));
+    m_statusBar->showMessage(QString(u8"筛选结果：共%1个资产").arg(rows.size()));
 
     // 筛选完成后，加载新的可见区域图片
     QTimer::singleShot(20, this, &StartWindow::loadVisibleAreaThumbs);
 }
 
-QStringList StartWindow::parseCatalogFile()
-{
-    QString fileContent = QStringLiteral("6b43eea6-2dee-4960-8ff0-edfb4f283858:HDRIs:HDRIs\n"
-        "e2328e9a-1cec-4c44-b542-5cd52bfbce19:HDRIs/Indoor:HDRIs-Indoor\n"
-        "1f0e3686-4835-433f-a076-074d204d3a43:HDRIs/Indoor/Natural Light:HDRIs-Indoor-Natural Light\n"
-        "00459860-c6d8-4632-b5e9-19929853cf3b:HDRIs/Indoor/Natural Light/Medium Contrast:HDRIs-Indoor-Natural Light-Medium Contrast\n"
-        "7c6ef490-2383-461c-b6ee-dcdd6714a2c4:HDRIs/Indoor/Natural Light/Low Contrast:HDRIs-Indoor-Natural Light-Low Contrast\n"
-        "5cb78b4d-9bcc-4b91-8a30-ff185da05e18:HDRIs/Indoor/Natural Light/High Contrast:HDRIs-Indoor-Natural Light-High Contrast\n"
-        "768ae7a1-5518-495d-9176-7cccad60a71c:HDRIs/Indoor/Artificial Light:HDRIs-Indoor-Artificial Light\n"
-        "5f70a139-9202-4fc9-a218-bcea5f9ab263:HDRIs/Indoor/Artificial Light/Medium Contrast:HDRIs-Indoor-Artificial Light-Medium Contrast\n"
-        "1134e281-8fda-4913-9662-06d42776b3e9:HDRIs/Indoor/Artificial Light/Low Contrast:HDRIs-Indoor-Artificial Light-Low Contrast\n"
-        "1325556c-7986-4568-a694-1134b6e16d32:HDRIs/Indoor/Artificial Light/High Contrast:HDRIs-Indoor-Artificial Light-High Contrast\n"
-        "f1e775ea-3173-41fe-b0e1-e315a61ab694:HDRIs/Indoor/Studio:HDRIs-Indoor-Studio\n"
-        "feae2c70-9016-4506-af27-6db147f93d00:HDRIs/Indoor/Studio/Medium Contrast:HDRIs-Indoor-Studio-Medium Contrast\n"
-        "af336f94-da70-4e9e-b3aa-9444d6b270fc:HDRIs/Indoor/Studio/Low Contrast:HDRIs-Indoor-Studio-Low Contrast\n"
-        "0ecbbd9d-7504-41d6-988c-1470362f5fc4:HDRIs/Indoor/Studio/High Contrast:HDRIs-Indoor-Studio-High Contrast\n"
-        "a40d8a97-03b5-4a77-aafc-4f31126329fe:HDRIs/Outdoor:HDRIs-Outdoor\n"
-        "eac57a1b-31a6-4542-a7c6-797799cc49c9:HDRIs/Outdoor/Nature:HDRIs-Outdoor-Nature\n"
-        "41ce4c4f-8ff1-4aa9-ae68-0120b44f0b77:HDRIs/Outdoor/Nature/Midday:HDRIs-Outdoor-Nature-Midday\n"
-        "8d14dcb5-f464-43ea-bbf5-15df36cf406e:HDRIs/Outdoor/Nature/Morning-afternoon:HDRIs-Outdoor-Nature-Morning-afternoon\n"
-        "415760a2-a428-4781-bf8e-636735f059fe:HDRIs/Outdoor/Nature/Night:HDRIs-Outdoor-Nature-Night\n"
-        "0f03b383-10da-4c89-819f-02a29bbc4bce:HDRIs/Outdoor/Nature/Sunrise-sunset:HDRIs-Outdoor-Nature-Sunrise-sunset\n"
-        "8908b21d-a3fe-48ab-a59c-3d1d4553344a:HDRIs/Outdoor/Urban:HDRIs-Outdoor-Urban\n"
-        "5f2c9621-3c96-4944-8206-d11cef84b586:HDRIs/Outdoor/Urban/Midday:HDRIs-Outdoor-Urban-Midday\n"
-        "18a3a12c-9d33-404c-9c95-811fe23052a8:HDRIs/Outdoor/Urban/Morning-afternoon:HDRIs-Outdoor-Urban-Morning-afternoon\n"
-        "44100f90-2dc1-4d97-b8dc-d192afd42b89:HDRIs/Outdoor/Urban/Night:HDRIs-Outdoor-Urban-Night\n"
-        "b35909d0-be3d-4be5-a888-caf24f881148:HDRIs/Outdoor/Urban/Sunrise-sunset:HDRIs-Outdoor-Urban-Sunrise-sunset\n"
-        "f2d63417-5e13-4efd-9987-93697bbf0a40:HDRIs/Outdoor/Skies:HDRIs-Outdoor-Skies\n"
-        "ee1c2a23-f241-40e2-a0f1-46f3469b6ac7:HDRIs/Outdoor/Skies/Midday:HDRIs-Outdoor-Skies-Midday\n"
-        "f21f81e2-3dde-4f2c-b9b4-3180a98d3d2e:HDRIs/Outdoor/Skies/Morning-afternoon:HDRIs-Outdoor-Skies-Morning-afternoon\n"
-        "8e41e6f9-b630-40c3-8427-3bace6c8268c:HDRIs/Outdoor/Skies/Night:HDRIs-Outdoor-Skies-Night\n"
-        "e64bbf5b-1ddf-47b2-9a6f-adf38150e68c:HDRIs/Outdoor/Skies/Sunrise-sunset:HDRIs-Outdoor-Skies-Sunrise-sunset\n"
-        "0b4a1940-abfc-435d-ae06-1b1912fcb0fa:Textures:Textures\n"
-        "fc0b7e40-beca-4085-a2c0-62fcff980615:Textures/Rock:Textures-Rock\n"
-        "57a6a6bc-1144-4fb9-9858-226c85c1062d:Textures/Terrain:Textures-Terrain\n"
-        "f0457b2f-0212-4fb7-968b-35cb79bf6c8b:Textures/Terrain/Aerial:Textures-Terrain-Aerial\n"
-        "5314108e-cb5a-43a5-aee0-0dc00fc2ed88:Textures/Terrain/Rock:Textures-Terrain-Rock\n"
-        "c79f5bda-6ad7-4556-972a-8dcc07a2d3f2:Textures/Terrain/Sand:Textures-Terrain-Sand\n"
-        "8753a952-0631-4b2d-9dbf-1122a725268e:Textures/Terrain/Snow:Textures-Terrain-Snow\n"
-        "eba19344-dabb-4949-b152-04bad720a3f7:Textures/Roofing:Textures-Roofing\n"
-        "e267e464-8444-4213-b8ab-426d0aae55c3:Textures/Wood:Textures-Wood\n"
-        "cb20759c-8417-4047-aca2-19755b99e892:Textures/Brick:Textures-Brick\n"
-        "dde53271-57f5-4d03-9d49-0384142ce2f4:Textures/Fabric:Textures-Fabric\n"
-        "09cf6a6c-a358-4f01-b38e-fe17f027f493:Textures/Metal:Textures-Metal\n"
-        "18ac3bd9-c74b-419b-b275-31047f5ade74:Textures/Plaster-concrete:Textures-Plaster-concrete\n"
-        "38881529-9e8f-474e-81c8-d535cba978f4:Models:Models\n"
-        "419127fb-d621-4dd9-b881-8e0d625119fb:Models/Props:Models-Props\n"
-        "1082487c-9383-4e5d-bbbd-13fe8007dc9e:Models/Props/Appliances:Models-Props-Appliances\n"
-        "b02575d8-d0fb-4a8c-8233-ec3ac8b4b052:Models/Props/Electronics:Models-Props-Electronics\n"
-        "62daa2e2-0e53-4623-a9ed-fee4190c99e0:Models/Props/Tools:Models-Props-Tools\n"
-        "d006c372-76c4-4f2b-b22d-42d60b89d086:Models/Industrial:Models-Industrial\n"
-        "3dfced29-5b6c-4a9c-8e4a-19e1c1330c4c:Models/Lighting:Models-Lighting\n"
-        "ae0813db-d65b-447f-8535-2a4856d98b9a:Models/Nature:Models-Nature\n"
-        "d88a690f-556e-4936-a8a6-9b675b8c2031:Models/Nature/Food:Models-Nature-Food\n"
-        "e60a325b-60d7-4b45-9e0d-1bb268c763bb:Models/Nature/Ground Cover:Models-Nature-Ground Cover\n"
-        "f55affcc-c81f-4e51-9b76-b4273189824a:Models/Nature/Ground Cover/Grass:Models-Nature-Ground Cover-Grass\n"
-        "35e80462-1b62-4736-95dc-ed8bb0c4cb1a:Models/Nature/Plants:Models-Nature-Plants\n"
-        "05825054-8739-4c42-8bc7-f70e15625a9b:Models/Nature/Potted Plants:Models-Nature-Potted Plants\n"
-        "1d68844f-b0e7-40ee-8819-d81eb1ee6baf:Models/Nature/Rocks:Models-Nature-Rocks\n"
-        "5eb59ce6-abcf-4c4c-8b72-d3540ceda629:Models/Furniture:Models-Furniture\n"
-        "c362fb1a-f3cf-4afc-ab4c-9ac979d7a20d:Models/Furniture/Seating:Models-Furniture-Seating\n"
-        "f7d9a241-6a68-4104-bdf8-1c13109e8e6c:Models/Furniture/Shelves:Models-Furniture-Shelves\n"
-        "dac0d06c-3e0d-4530-981c-530b89fb0cb2:Models/Furniture/Table:Models-Furniture-Table");
-
-    QTextStream in(&fileContent);
-    QSet<QString> allPaths;
-    QString line;
-
-    while (!in.atEnd()) {
-        line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith('#') || line.startsWith("VERSION"))
-            continue;
-
-        QStringList parts = line.split(':');
-        if (parts.size() < 2) continue;
-
-        QString path = parts[1].trimmed().replace(" ", " ");
-        QString fullPath = "ALL/" + path;
-
-        QStringList segs = fullPath.split('/');
-        for (int i = 1; i <= segs.size(); ++i) {
-            QString cur = segs.mid(0, i).join('/');
-            allPaths.insert(cur);
-        }
-    }
-
-    QStringList sorted = allPaths.values();
-    std::sort(sorted.begin(), sorted.end(),
-        [](const QString& a, const QString& b) {
-            int la = a.count('/');
-            int lb = b.count('/');
-            return la != lb ? la < lb : a < b;
-        });
-    return sorted;
-}
-
-QStandardItemModel* StartWindow::buildTreeModel(const QStringList& sortedPaths)
+QStandardItemModel* StartWindow::buildTreeModel()
 {
     auto* model = new QStandardItemModel();
     QStandardItem* rootItem = model->invisibleRootItem();
 
-    QHash<QString, QStandardItem*> itemMap;
-    itemMap[""] = rootItem;
+    // CATEGORY_NODES 已按深度排序且带父节点 id，直接按下标挂接
+    m_categoryItems.fill(nullptr, CATEGORY_NODE_COUNT);
 
-    for (const QString& path : sortedPaths) {
-        if (path.isEmpty()) continue;
+    for (int node = 0; node < CATEGORY_NODE_COUNT; ++node) {
+        const CategoryNode& n = CATEGORY_NODES[node];
+        QString path = QString::fromLatin1(n.path.data(), int(n.path.size()));
+        QString displayName = QString::fromLatin1(n.name.data(), int(n.name.size()));
 
-        QString displayName = path.split('/').last();
         auto* item = new QStandardItem(displayName);
+        item->setEditable(false);
         item->setData(path, CATALOG_PATH_ROLE);
-        itemMap[path] = item;
+        item->setData(node, CATALOG_NODE_ROLE);
+        m_categoryItems[node] = item;
 
-        QString parentPath = path.section('/', 0, -2);
-        auto* parentItem = itemMap.value(parentPath);
-        if (parentItem && item->parent() != parentItem)
+        QStandardItem* parentItem = n.parent >= 0 ? m_categoryItems[n.parent] : rootItem;
+        if (parentItem)
             parentItem->appendRow(item);
     }
     return model;
@@ -694,11 +821,11 @@ void StartWindow::loadTreeModel()
         m_categoriesModel = nullptr;
     }
 
-    QStringList paths = parseCatalogFile();
-    m_categoriesModel = buildTreeModel(paths);
+    m_categoriesModel = buildTreeModel();
 
     ui->m_categoriesTreeView->setModel(m_categoriesModel);
     ui->m_categoriesTreeView->setHeaderHidden(true);
+    updateFacetCounts();
 
     // 绑定分类点击事件（如果之前没绑定）
     connect(ui->m_categoriesTreeView, &QTreeView::clicked, this, &StartWindow::onCategoryClicked);
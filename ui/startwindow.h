@@ -18,6 +18,7 @@
 #include <QtWidgets/qscrollarea.h>
 
 #include <QtWidgets/qcombobox.h>
+#include <QtWidgets/qcompleter.h>
 #include <QtWidgets/qmessagebox.h>
 #include <QtWidgets/qfiledialog.h>
 #include <QtCore/qtimer.h>
@@ -28,6 +29,7 @@
 #include <QtCore/qfile.h>
 #include <QtCore/qdir.h>
 #include <QtCore/qvariantmap.h>
+#include <QtCore/qpointer.h>
 
 #include <UT/UT_String.h>
 #include <PY/PY_Python.h>
@@ -35,6 +37,10 @@
 
 #include "AssetDelegate.h"
 #include "AssetModel.h"
+#include "LibraryWatcher.h"
+#include "MetricsPanel.h"
+#include "asset_index.h"
+#include "tag_trie.h"
 #include "ui_startwindow.h"
 
 // 前置声明（避免未定义错误，若 AssetInfo 有单独头文件可包含）
@@ -89,11 +95,43 @@ private:
     // 数据相关
     QMap<QString, QJsonObject> m_assetsData;
     QString m_searchText;
-    QVector<QString> m_categoryList;
-    int m_currentCategory = 3;  // 0:HDRIs,1:Textures,2:Models,3:All
+    int m_currentNode = -1;     // 当前选中的分类节点 id（-1 表示全部）
+
+    // 索引相关：搜索结果位图随输入增量更新，分类计数由位图按位与得到
+    AssetIndex m_assetIndex;
+    QBitArray m_textBits;
+    QString m_textBitsQuery;
+    QVector<QStandardItem*> m_categoryItems;  // 下标为节点 id
+
+    // 排序相关：置换数组在 AssetIndex 建索引时预计算
+    AssetIndex::SortField m_sortField = AssetIndex::SortByKey;
+    bool m_sortDescending = false;
+
+    // 搜索补全：tags/categories 前缀树 + 弹出列表
+    TagTrie m_tagTrie;
+    QCompleter* m_completer = nullptr;
+    QStandardItemModel* m_completionModel = nullptr;
 
     bool m_firstShow = true;
 
+    // 异步启动：后台建索引，完成后分批插入模型
+    static constexpr int STREAM_CHUNK_SIZE = 256;
+    int m_loadGeneration = 0;
+    QVector<int> m_streamRows;
+    int m_streamPos = 0;
+    QPointer<AssetModel> m_streamModel;
+
+    // 拉取过程中缩略图陆续落盘：合并成一次可见区域刷新
+    bool m_previewRefreshPending = false;
+    // 在库表的扫描与目录监视
+    LibraryWatcher* m_libraryWatcher = nullptr;
+    // 统计面板（首次打开时创建）
+    MetricsPanel* m_metricsPanel = nullptr;
+
+    // dry-run：确认框里选“仅预估”时只规划不下载，结束后展示报告
+    bool m_dryRunRequested = false;
+    QString m_lastPlanSummary;
+
     // UI 组件
     QStandardItemModel* m_categoriesModel;
     QStandardItemModel* m_tagModel;
@@ -109,13 +147,23 @@ private:
 
     // 核心：加载可见区域及附近的图片（解决静止不加载问题）
     void loadVisibleAreaThumbs();
-    // 加载资产数据（原有函数）
+    // 加载资产数据：读缓存与建索引在线程池完成，不阻塞 GUI
     void loadAssets(bool filtered = false);
+    // 索引就绪后（GUI 线程）：刷新计数并开始分批填充模型
+    void onLibraryReady(bool filtered);
+    // 向模型追加下一批行，批间让出事件循环
+    void streamNextChunk();
+    // 按当前搜索词刷新文本位图（新词包含旧词时只复查旧结果）
+    void refreshTextBits();
+    // 刷新分类树节点上的资产计数
+    void updateFacetCounts();
+    // 按当前搜索词刷新补全候选
+    void updateCompletions();
 
 public:
-    const QString ORG_NAME = "coolaken";   // 自定义（如你的公司/个人名称）
-    const QString APP_NAME = "polyhavenforhoudini";       // 自定义（如你的程序名称）
-    const QString PATH_KEY = "LastFilepath";// 配置项的键（用于读取/写入）
+    const QString ORG_NAME = SETTINGS_ORG_NAME;   // 自定义（如你的公司/个人名称）
+    const QString APP_NAME = SETTINGS_APP_NAME;   // 自定义（如你的程序名称）
+    const QString PATH_KEY = SETTINGS_LIBRARY_PATH_KEY;// 配置项的键（用于读取/写入）
     static QString s_lastPath;
 
 protected:
@@ -132,25 +180,35 @@ private Q_SLOTS:
 
 
     void onProgressUpdated(int current, int total, const QString& text);
+    // 缩略图落盘 / 在库表变化：200 ms 内合并成一次可见区域刷新
+    void schedulePreviewRefresh();
+    // 字节进度：写到进度条文字上（已传 / 总量 / 速度 / 剩余时间）
+    void onByteProgressUpdated(qint64 doneBytes, qint64 totalBytes, double bytesPerSecond, qint64 etaSeconds);
 
     // 路径选择相关
     void showConfirmation(const QString& text = "all");
+    // 校验结束：汇报不符的文件
+    void onVerifyFinished(int checkedCount, int hashedCount, const QStringList& mismatches);
 
     //void test();
     void onTextChanged(const QString& text);
+    // 拉取结束：按结果码提示
+    void onExecuteFinished(int resultCode, const QString& text);
+    // 首次显示时：资产库里有中断的拉取就询问是否续传
+    void offerResume();
     void canceldownload();
 
     void savePathToConfig(const QString& path);
     QString loadPathFromConfig();
 
-    // 解析目录文件（原有函数）
-    QStringList parseCatalogFile();
-    // 构建树形模型（原有函数）
-    QStandardItemModel* buildTreeModel(const QStringList& sortedPaths);
+    // 构建树形模型（节点表见 category_taxonomy.h，编译期生成）
+    QStandardItemModel* buildTreeModel();
     // 应用筛选（原有函数）
     void applyFilter();
-    // 筛选资产（原有函数）
-    QMap<QString, QJsonObject> filterAssets() const;
+    // 筛选资产：返回按当前排序排好的 AssetIndex 行号
+    QVector<int> filterAssets() const;
+    // 排序方式切换
+    void onSortChanged(int index);
     // 加载树形模型（原有函数）
     void loadTreeModel();
     // 分类点击事件（原有函数）
@@ -159,4 +217,6 @@ private Q_SLOTS:
     void updateText(const QString& text);
     // 资产预览事件（供 Delegate 调用）
     void onAssetPreview(const QVariantMap& asset);
+    // 资产拖动事件（连到 AssetDelegate::assetDragged）：提前该资产的下载
+    void onAssetDragged(const QString& assetId);
 };